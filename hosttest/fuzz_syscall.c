@@ -0,0 +1,757 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Host System Call Fuzzer
+ *
+ * Runs the system call dispatcher and the process, scheduler and
+ * synchronization code natively on the build host and feeds it system call
+ * sequences decoded from fuzzer input. Hardware, paging, the file system
+ * and the timer are replaced by the stubs below; the timer is advanced by
+ * the input itself. After every step the kernel data structures are checked
+ * (scheduler queues, process states, mutex and semaphore tables) and any
+ * out-of-range table access is caught by the address sanitizer.
+ *
+ * Built with clang and -fsanitize=fuzzer this is a libFuzzer target.
+ * Otherwise a standalone driver replays input files, or runs random inputs:
+ *
+ * Usage: fuzz_syscall [-v] [-n runs] [-s seed] [file ...]
+ *
+ * Input format: records of FUZZ_RECORD_SIZE bytes
+ *   byte 0     - system call id, or FUZZ_OP_TICK and above to advance the
+ *                timer by (op - FUZZ_OP_TICK + 1) ticks
+ *   bytes 1-6  - three 16-bit little endian arguments; arguments that are
+ *                pointers are NULL when 0, otherwise they point into the
+ *                memory region of the calling process
+ */
+#define _GNU_SOURCE
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "kernel.h"
+#include "interrupts.h"
+#include "kcond.h"
+#include "kelf.h"
+#include "kfpu.h"
+#include "kfs.h"
+#include "kmalloc.h"
+#include "kmbox.h"
+#include "kmutex.h"
+#include "kpage.h"
+#include "kpaging.h"
+#include "kpipe.h"
+#include "kpoll.h"
+#include "kproc.h"
+#include "kprof.h"
+#include "krwlock.h"
+#include "ksem.h"
+#include "ksyscall.h"
+#include "prog_user.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "tty.h"
+
+#define FUZZ_RECORD_SIZE    7
+#define FUZZ_RECORDS_MAX    4096
+#define FUZZ_OP_TICK        0xf0
+
+// Memory backing the process stacks and the process table
+#define FUZZ_ARENA_SIZE     (64 * 1024 * 1024)
+
+// Memory that pointer arguments refer to, split into a region per process
+// table entry, so that the buffers of different processes never overlap
+#define FUZZ_USER_SLICE     (64 * 1024)
+#define FUZZ_USER_SIZE      (PROC_MAX * FUZZ_USER_SLICE)
+
+#define FUZZ_TIMERS_MAX     8
+
+// Address the processes make system calls from; a blocked system call that
+// is restarted leaves the process just before it
+#define FUZZ_SYSCALL_EIP    0x1000
+
+#define ARG1 0x1
+#define ARG2 0x2
+#define ARG3 0x4
+
+// Arguments of each system call that are pointers
+const unsigned char fuzz_ptr_args[SYSCALL_MAX] = {
+    [SYSCALL_IO_READ]       = ARG2,
+    [SYSCALL_IO_WRITE]      = ARG2,
+    [SYSCALL_SYS_GET_NAME]  = ARG1,
+    [SYSCALL_PROC_GET_NAME] = ARG1,
+    [SYSCALL_MSG_SEND]      = ARG2,
+    [SYSCALL_MSG_RECV]      = ARG2,
+    [SYSCALL_PIPE]          = ARG1,
+    [SYSCALL_POLL]          = ARG1,
+    [SYSCALL_MEM_STATS]     = ARG1,
+    [SYSCALL_EXEC]          = ARG1,
+    [SYSCALL_IO_OPEN]       = ARG1,
+    [SYSCALL_PROF_DUMP]     = ARG1,
+    [SYSCALL_LAT_SNAPSHOT]  = ARG2,
+    [SYSCALL_PROC_STATS]    = ARG2,
+    [SYSCALL_LOCKSTAT]      = ARG1,
+    [SYSCALL_TRACE_READ]    = ARG1,
+    [SYSCALL_SYS_LOG]       = ARG1,
+};
+
+// Kernel state normally provided by kernel.c and timer.c
+proc_t *active_proc;
+
+int fuzz_ticks;
+void (*fuzz_timers[FUZZ_TIMERS_MAX])();
+int fuzz_timer_intervals[FUZZ_TIMERS_MAX];
+
+struct tty_t fuzz_ttys[TTY_MAX];
+
+unsigned char *fuzz_arena;
+int fuzz_arena_used;
+unsigned char *fuzz_user;
+
+int fuzz_verbose;
+
+// Input being run, saved by the standalone driver when a check fails
+const unsigned char *fuzz_input;
+size_t fuzz_input_size;
+
+extern int next_pid;
+extern proc_queue_t run_queue;
+extern proc_queue_t sleep_queue;
+extern mutex_t mutexes[MUTEX_MAX];
+extern queue_t mutex_queue;
+extern sem_t semaphores[SEM_MAX];
+extern queue_t sem_queue;
+extern kslab_t proc_table;
+
+/**
+ * Reports a failed check and aborts
+ * The standalone driver saves the input to fuzz_syscall.crash for replay
+ * @param msg - format string describing the failure
+ */
+void fuzz_fail(char *msg, ...) {
+    va_list args;
+
+    printf("FAIL: ");
+    va_start(args, msg);
+    vprintf(msg, args);
+    va_end(args);
+    printf(" (tick %d, pid %d)\n", fuzz_ticks, active_proc ? active_proc->pid : -1);
+
+#ifndef FUZZ_LIBFUZZER
+    FILE *f = fopen("fuzz_syscall.crash", "wb");
+    if (f) {
+        fwrite(fuzz_input, 1, fuzz_input_size, f);
+        fclose(f);
+        printf("input saved to fuzz_syscall.crash\n");
+    }
+#endif
+
+    fflush(stdout);
+    abort();
+}
+
+#define FUZZ_CHECK(cond, ...) { \
+    if (!(cond)) { \
+        fuzz_fail(__VA_ARGS__); \
+    } \
+}
+
+/*
+ * Stubs for the kernel modules that are not part of the harness
+ */
+#define FUZZ_LOG(prefix) { \
+    va_list args; \
+    if (fuzz_verbose) { \
+        printf(prefix); \
+        va_start(args, msg); \
+        vprintf(msg, args); \
+        va_end(args); \
+        printf("\n"); \
+    } \
+}
+
+void kernel_log_error(char *msg, ...) FUZZ_LOG("error: ")
+void kernel_log_warn(char *msg, ...) FUZZ_LOG("warn: ")
+void kernel_log_info(char *msg, ...) FUZZ_LOG("info: ")
+void kernel_log_debug(char *msg, ...) FUZZ_LOG("debug: ")
+void kernel_log_trace(char *msg, ...) FUZZ_LOG("trace: ")
+
+void kernel_panic(char *msg, ...) {
+    char buf[256];
+    va_list args;
+
+    va_start(args, msg);
+    vsnprintf(buf, sizeof(buf), msg, args);
+    va_end(args);
+
+    fuzz_fail("kernel panic: %s", buf);
+}
+
+int timer_get_ticks(void) {
+    return fuzz_ticks;
+}
+
+int timer_callback_register(void (*func_ptr)(), int interval, int repeat) {
+    for (int i = 0; i < FUZZ_TIMERS_MAX; i++) {
+        if (!fuzz_timers[i]) {
+            fuzz_timers[i] = func_ptr;
+            fuzz_timer_intervals[i] = interval;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void isr_entry_syscall() {
+}
+
+void interrupts_irq_register(int irq, void (*entry)(), void (*handler)()) {
+}
+
+struct tty_t *tty_get(int tty) {
+    if (tty < 0 || tty >= TTY_MAX) {
+        return NULL;
+    }
+
+    return &fuzz_ttys[tty];
+}
+
+void *kpage_alloc_contig(int count) {
+    int size = count * KPAGE_SIZE;
+    void *page;
+
+    if (count <= 0 || size > FUZZ_ARENA_SIZE - fuzz_arena_used) {
+        return NULL;
+    }
+
+    page = fuzz_arena + fuzz_arena_used;
+    fuzz_arena_used += size;
+
+    return page;
+}
+
+int kpage_free_contig(void *page, int count) {
+    return 0;
+}
+
+int kpaging_map_frame(proc_t *proc, unsigned int vaddr, unsigned int frame, int flags) {
+    return 0;
+}
+
+int kpaging_fork(proc_t *parent, proc_t *child) {
+    return 0;
+}
+
+void kpaging_proc_destroy(proc_t *proc) {
+}
+
+void kpaging_stats(mem_stats_t *stats) {
+}
+
+int kmalloc_stats(mem_stats_t *stats) {
+    if (!stats) {
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    return 0;
+}
+
+int kfpu_fork(proc_t *parent, proc_t *child) {
+    return 0;
+}
+
+void kfpu_release(proc_t *proc) {
+}
+
+kelf_image_t *kelf_find(char *name) {
+    return NULL;
+}
+
+int kelf_load(proc_t *proc, unsigned char *data, int size, unsigned int *entry) {
+    return -1;
+}
+
+int kfs_open(char *name) {
+    return -1;
+}
+
+int kfs_read(int io, char *buf, int n) {
+    return -1;
+}
+
+int kfs_seek(int io, int offset, int whence) {
+    return -1;
+}
+
+int kfs_dup(proc_t *proc, int io) {
+    return -1;
+}
+
+int kfs_close(proc_t *proc, int io) {
+    return -1;
+}
+
+void prog_shell(void) {
+}
+
+void prog_ping(void) {
+}
+
+void prog_pong(void) {
+}
+
+/*
+ * Kernel setup and stepping
+ */
+
+/**
+ * Maps memory below 4GB, where the 32-bit system call arguments and the
+ * kernel's pointer to integer casts can address it
+ * @param size - number of bytes
+ * @return pointer to the memory
+ */
+void *fuzz_map(int size) {
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_NORESERVE, -1, 0);
+
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+
+    return mem;
+}
+
+/**
+ * Initializes the kernel the way main() does, from scratch
+ */
+void fuzz_kernel_init(void) {
+    if (!fuzz_arena) {
+        fuzz_arena = fuzz_map(FUZZ_ARENA_SIZE);
+        fuzz_user = fuzz_map(FUZZ_USER_SIZE);
+    }
+
+    fuzz_arena_used = 0;
+    fuzz_ticks = 0;
+    memset(fuzz_timers, 0, sizeof(fuzz_timers));
+
+    for (int i = 0; i < TTY_MAX; i++) {
+        memset(&fuzz_ttys[i], 0, sizeof(fuzz_ttys[i]));
+        fuzz_ttys[i].id = i;
+        spscbuf_init(&fuzz_ttys[i].io_input);
+        ringbuf_init(&fuzz_ttys[i].io_output);
+    }
+
+    active_proc = NULL;
+    next_pid = 0;
+
+    kprof_stop();
+
+    scheduler_init();
+    kpipes_init();
+    kproc_init();
+    ksyscall_init();
+    ksemaphores_init();
+    kmutexes_init();
+    krwlocks_init();
+    kconds_init();
+    kmboxes_init();
+    kpolls_init();
+
+    scheduler_run();
+}
+
+/**
+ * Advances the timer by one tick, as timer_irq_handler does
+ */
+void fuzz_tick(void) {
+    fuzz_ticks++;
+
+    kprof_tick();
+
+    for (int i = 0; i < FUZZ_TIMERS_MAX; i++) {
+        if (fuzz_timers[i] && fuzz_ticks % fuzz_timer_intervals[i] == 0) {
+            fuzz_timers[i]();
+        }
+    }
+
+    scheduler_run();
+}
+
+/**
+ * Converts a 16-bit input value to a system call argument
+ * @param value - the input value
+ * @param ptr - whether the argument is a pointer
+ * @return the register value
+ */
+unsigned int fuzz_arg(short value, int ptr) {
+    unsigned char *mem = fuzz_user + proc_to_entry(active_proc) * FUZZ_USER_SLICE;
+
+    if (!ptr) {
+        return (unsigned int)(int)value;
+    }
+
+    if (value == 0) {
+        return 0;
+    }
+
+    // Structures passed by user programs are word aligned
+    return (unsigned int)(unsigned long)(mem + (value & 0xfc));
+}
+
+/**
+ * Makes a system call from the active process, as the int $0x80 path in
+ * kernel_context_enter does
+ * @param syscall - the system call id
+ * @param args - the three 16-bit arguments
+ */
+void fuzz_syscall(int syscall, short args[3]) {
+    int ptrs = syscall < SYSCALL_MAX ? fuzz_ptr_args[syscall] : 0;
+    trapframe_t *tf = active_proc->trapframe;
+
+    // The idle process never makes system calls
+    if (active_proc->pid == 0) {
+        fuzz_tick();
+        return;
+    }
+
+    // A restarted system call is repeated with the registers it left, as
+    // the process executes the int $0x80 instruction again
+    if (tf->eip != FUZZ_SYSCALL_EIP - SYSCALL_INSN_SIZE) {
+        tf->eax = syscall;
+        tf->ebx = fuzz_arg(args[0], ptrs & ARG1);
+        tf->ecx = fuzz_arg(args[1], ptrs & ARG2);
+        tf->edx = fuzz_arg(args[2], ptrs & ARG3);
+    }
+
+    tf->eip = FUZZ_SYSCALL_EIP;
+    ksyscall_irq_handler();
+    scheduler_run();
+}
+
+/*
+ * Invariant checks
+ */
+
+/**
+ * Checks the bookkeeping of a circular queue
+ * @param queue - the queue
+ * @param name - name of the queue for the failure report
+ * @param id - table index of the queue owner
+ */
+void fuzz_check_queue(queue_t *queue, char *name, int id) {
+    FUZZ_CHECK(queue->size >= 0 && queue->size <= QUEUE_SIZE,
+               "%s %d: queue size %d", name, id, queue->size);
+    FUZZ_CHECK(queue->head >= 0 && queue->head < QUEUE_SIZE,
+               "%s %d: queue head %d", name, id, queue->head);
+    FUZZ_CHECK(queue->tail >= 0 && queue->tail < QUEUE_SIZE,
+               "%s %d: queue tail %d", name, id, queue->tail);
+    FUZZ_CHECK((queue->head + queue->size) % QUEUE_SIZE == queue->tail,
+               "%s %d: queue head %d + size %d != tail %d", name, id,
+               queue->head, queue->size, queue->tail);
+}
+
+/**
+ * Returns the nth item of a queue, counting from the head
+ */
+int fuzz_queue_item(queue_t *queue, int n) {
+    return queue->items[(queue->head + n) % QUEUE_SIZE];
+}
+
+/**
+ * Checks that a pointer refers to an allocated process table entry
+ * @param proc - the pointer
+ * @return 1 if it does, 0 otherwise
+ */
+int fuzz_valid_proc(proc_t *proc) {
+    int entry = proc_to_entry(proc);
+
+    return entry >= 0 && entry_to_proc(entry) == proc;
+}
+
+/**
+ * Checks a process queue's links and that its processes are in a state
+ * @param queue - the process queue
+ * @param name - name of the queue for the failure report
+ * @param state - the state of every process in the queue
+ */
+void fuzz_check_proc_queue(proc_queue_t *queue, char *name, state_t state) {
+    proc_t *prev = NULL;
+    int n = 0;
+
+    for (proc_t *proc = queue->head; proc; proc = proc->queue_next) {
+        FUZZ_CHECK(n < PROC_MAX, "%s: loop in queue", name);
+        FUZZ_CHECK(fuzz_valid_proc(proc), "%s: freed process in queue", name);
+        FUZZ_CHECK(proc->scheduler_queue == queue, "%s: pid %d queue pointer", name, proc->pid);
+        FUZZ_CHECK(proc->queue_prev == prev, "%s: pid %d prev link", name, proc->pid);
+        FUZZ_CHECK(proc->state == state, "%s: pid %d in state %d", name, proc->pid, proc->state);
+        prev = proc;
+        n++;
+    }
+
+    FUZZ_CHECK(queue->tail == prev, "%s: tail does not match the last process", name);
+    FUZZ_CHECK(queue->size == n, "%s: size %d with %d processes", name, queue->size, n);
+}
+
+/**
+ * Checks that the processes in a wait queue exist and are blocked
+ * @param queue - the wait queue of process ids
+ * @param name - name of the table for the failure report
+ * @param id - table index of the queue owner
+ */
+void fuzz_check_waiters(queue_t *queue, char *name, int id) {
+    for (int i = 0; i < queue->size; i++) {
+        proc_t *proc = pid_to_proc(fuzz_queue_item(queue, i));
+
+        FUZZ_CHECK(proc, "%s %d: waiting pid %d does not exist", name, id, fuzz_queue_item(queue, i));
+        FUZZ_CHECK(proc->state == WAITING, "%s %d: waiting pid %d in state %d",
+                   name, id, proc->pid, proc->state);
+    }
+}
+
+/**
+ * Checks an id allocator queue: every id is in range, free and queued once
+ * @param queue - the queue of free ids
+ * @param name - name of the table for the failure report
+ * @param max - the table size
+ * @param allocated - pointer to the allocated flag of entry 0
+ * @param stride - size of a table entry
+ */
+void fuzz_check_ids(queue_t *queue, char *name, int max, int *allocated, int stride) {
+    unsigned char seen[QUEUE_SIZE] = {0};
+
+    fuzz_check_queue(queue, name, -1);
+
+    for (int i = 0; i < queue->size; i++) {
+        int id = fuzz_queue_item(queue, i);
+
+        FUZZ_CHECK(id >= 0 && id < max, "%s: free id %d out of range", name, id);
+        FUZZ_CHECK(!seen[id], "%s: id %d is free twice", name, id);
+        FUZZ_CHECK(!*(int *)((char *)allocated + id * stride), "%s: id %d is free and allocated", name, id);
+        seen[id] = 1;
+    }
+}
+
+/**
+ * Checks the process table, scheduler queues and lock tables
+ */
+void fuzz_check(void) {
+    int active = 0;
+    int ready = 0;
+    int sleeping = 0;
+
+    FUZZ_CHECK(active_proc, "no active process");
+    FUZZ_CHECK(fuzz_valid_proc(active_proc), "active process is not in the process table");
+    FUZZ_CHECK(active_proc->state == ACTIVE, "active process in state %d", active_proc->state);
+    FUZZ_CHECK(!active_proc->scheduler_queue, "active process is in a scheduler queue");
+
+    fuzz_check_proc_queue(&run_queue, "run queue", IDLE);
+    fuzz_check_proc_queue(&sleep_queue, "sleep queue", SLEEPING);
+
+    for (int entry = 0; entry < kslab_capacity(&proc_table); entry++) {
+        proc_t *proc = entry_to_proc(entry);
+
+        if (!proc) {
+            continue;
+        }
+
+        FUZZ_CHECK(pid_to_proc(proc->pid) == proc, "pid %d lookup", proc->pid);
+        FUZZ_CHECK(*(unsigned int *)proc->stack == PROC_STACK_CANARY, "pid %d stack canary", proc->pid);
+        FUZZ_CHECK((unsigned char *)proc->trapframe >= proc->stack &&
+                   (unsigned char *)(proc->trapframe + 1) <= proc->stack + proc->stack_size,
+                   "pid %d trapframe outside of its stack", proc->pid);
+
+        switch (proc->state) {
+            case ACTIVE:
+                FUZZ_CHECK(proc == active_proc, "pid %d active but not scheduled", proc->pid);
+                active++;
+                break;
+
+            case IDLE:
+                // The idle task is the only process that waits outside of the run queue
+                FUZZ_CHECK(proc->scheduler_queue == &run_queue || proc->pid == 0,
+                           "pid %d idle but not in the run queue", proc->pid);
+                ready += proc->scheduler_queue == &run_queue;
+                break;
+
+            case SLEEPING:
+                FUZZ_CHECK(proc->scheduler_queue == &sleep_queue,
+                           "pid %d sleeping but not in the sleep queue", proc->pid);
+                sleeping++;
+                break;
+
+            case WAITING:
+                FUZZ_CHECK(!proc->scheduler_queue, "pid %d waiting in a scheduler queue", proc->pid);
+                break;
+
+            default:
+                fuzz_fail("pid %d in state %d", proc->pid, proc->state);
+        }
+    }
+
+    FUZZ_CHECK(active == 1, "%d active processes", active);
+    FUZZ_CHECK(ready == run_queue.size, "%d ready processes, run queue size %d", ready, run_queue.size);
+    FUZZ_CHECK(sleeping == sleep_queue.size, "%d sleeping processes, sleep queue size %d",
+               sleeping, sleep_queue.size);
+
+    for (int i = 0; i < MUTEX_MAX; i++) {
+        mutex_t *mutex = &mutexes[i];
+
+        fuzz_check_queue(&mutex->wait_queue, "mutex", i);
+
+        if (!mutex->allocated) {
+            FUZZ_CHECK(!mutex->owner && mutex->wait_queue.size == 0, "mutex %d: free but in use", i);
+            continue;
+        }
+
+        FUZZ_CHECK(mutex->locks >= 0, "mutex %d: lock count %d", i, mutex->locks);
+        FUZZ_CHECK(!mutex->owner || fuzz_valid_proc(mutex->owner), "mutex %d: owner is not a process", i);
+        FUZZ_CHECK(mutex->owner || mutex->wait_queue.size == 0, "mutex %d: waiters without an owner", i);
+        fuzz_check_waiters(&mutex->wait_queue, "mutex", i);
+    }
+
+    fuzz_check_ids(&mutex_queue, "mutex ids", MUTEX_MAX, &mutexes[0].allocated, sizeof(mutex_t));
+
+    for (int i = 0; i < SEM_MAX; i++) {
+        sem_t *sem = &semaphores[i];
+
+        fuzz_check_queue(&sem->wait_queue, "semaphore", i);
+
+        if (!sem->allocated) {
+            FUZZ_CHECK(sem->wait_queue.size == 0, "semaphore %d: free but in use", i);
+            continue;
+        }
+
+        FUZZ_CHECK(sem->count <= 0 || sem->wait_queue.size == 0,
+                   "semaphore %d: count %d with waiters", i, sem->count);
+        fuzz_check_waiters(&sem->wait_queue, "semaphore", i);
+    }
+
+    fuzz_check_ids(&sem_queue, "semaphore ids", SEM_MAX, &semaphores[0].allocated, sizeof(sem_t));
+}
+
+/**
+ * Runs one input against a freshly initialized kernel
+ * @param data - the input
+ * @param size - size of the input
+ */
+void fuzz_run(const unsigned char *data, size_t size) {
+    fuzz_input = data;
+    fuzz_input_size = size;
+
+    fuzz_kernel_init();
+    fuzz_check();
+
+    for (size_t n = 0; n + FUZZ_RECORD_SIZE <= size && n < FUZZ_RECORDS_MAX * FUZZ_RECORD_SIZE;
+         n += FUZZ_RECORD_SIZE) {
+        const unsigned char *rec = &data[n];
+        short args[3];
+
+        for (int i = 0; i < 3; i++) {
+            args[i] = (short)(rec[1 + 2 * i] | rec[2 + 2 * i] << 8);
+        }
+
+        if (rec[0] >= FUZZ_OP_TICK) {
+            for (int i = FUZZ_OP_TICK; i <= rec[0]; i++) {
+                fuzz_tick();
+            }
+        } else {
+            // Include one id past the last valid system call
+            fuzz_syscall(rec[0] % (SYSCALL_MAX + 1), args);
+        }
+
+        fuzz_check();
+    }
+}
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size) {
+    fuzz_run(data, size);
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+/**
+ * Fills a random input, favoring small argument values so that table
+ * ids are often valid
+ * @param data - the input to fill
+ * @param size - size of the input
+ */
+void fuzz_random(unsigned char *data, size_t size) {
+    for (size_t n = 0; n + FUZZ_RECORD_SIZE <= size; n += FUZZ_RECORD_SIZE) {
+        data[n] = (rand() % 4 == 0) ? FUZZ_OP_TICK + rand() % 16 : rand() % (SYSCALL_MAX + 1);
+
+        for (int i = 0; i < 3; i++) {
+            int value = (rand() % 4 == 0) ? rand() : rand() % 36 - 2;
+
+            data[n + 1 + 2 * i] = value & 0xff;
+            data[n + 2 + 2 * i] = (value >> 8) & 0xff;
+        }
+    }
+}
+
+/**
+ * Replays an input file
+ * @param path - the file name
+ * @return -1 on error, 0 on success
+ */
+int fuzz_replay(char *path) {
+    static unsigned char data[FUZZ_RECORDS_MAX * FUZZ_RECORD_SIZE];
+    size_t size;
+    FILE *f = fopen(path, "rb");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    size = fread(data, 1, sizeof(data), f);
+    fclose(f);
+
+    fuzz_run(data, size);
+    printf("%s: %d records ok\n", path, (int)(size / FUZZ_RECORD_SIZE));
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static unsigned char data[FUZZ_RECORDS_MAX * FUZZ_RECORD_SIZE];
+    int runs = 2000;
+    unsigned int seed = 1;
+    int files = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            fuzz_verbose = 1;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = atoi(argv[++i]);
+        } else {
+            if (fuzz_replay(argv[i]) != 0) {
+                return 1;
+            }
+            files++;
+        }
+    }
+
+    if (files) {
+        return 0;
+    }
+
+    srand(seed);
+
+    for (int run = 0; run < runs; run++) {
+        size_t size = (1 + rand() % FUZZ_RECORDS_MAX) * FUZZ_RECORD_SIZE;
+
+        fuzz_random(data, size);
+        fuzz_run(data, size);
+    }
+
+    printf("%d runs ok (seed %u)\n", runs, seed);
+    return 0;
+}
+#endif
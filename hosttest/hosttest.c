@@ -0,0 +1,454 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Host Unit Tests and Benchmarks
+ *
+ * Runs the data structure code (queue, ringbuf, bit_util) natively on the
+ * build host, against the shims in hosttest/spede for the SPEDE headers.
+ * Correctness tests run first; benchmarks then report the time per
+ * operation, repeating each one until it has run for BENCH_MIN_NS.
+ *
+ * Usage: hosttest [test | bench]     (both by default)
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "bit_util.h"
+#include "queue.h"
+#include "ringbuf.h"
+
+#define BENCH_MIN_NS    200000000LL
+
+int checks;
+int failures;
+
+#define CHECK(cond) { \
+    checks++; \
+    if (!(cond)) { \
+        failures++; \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+}
+
+/*
+ * Queue tests
+ */
+void test_queue_empty_full(void) {
+    queue_t queue;
+    int item = -1;
+
+    memset(&queue, 0xaa, sizeof(queue));
+    CHECK(queue_init(&queue) == 0);
+    CHECK(queue.size == 0);
+    CHECK(queue_out(&queue, &item) == -1);
+    CHECK(item == -1);
+
+    for (int i = 0; i < QUEUE_SIZE; i++) {
+        CHECK(queue_in(&queue, i) == 0);
+    }
+
+    CHECK(queue.size == QUEUE_SIZE);
+    CHECK(queue_in(&queue, QUEUE_SIZE) == -1);
+    CHECK(queue.size == QUEUE_SIZE);
+
+    for (int i = 0; i < QUEUE_SIZE; i++) {
+        CHECK(queue_out(&queue, &item) == 0);
+        CHECK(item == i);
+    }
+
+    CHECK(queue_out(&queue, &item) == -1);
+    CHECK(queue.size == 0);
+
+    CHECK(queue_init(NULL) == -1);
+    CHECK(queue_in(NULL, 0) == -1);
+    CHECK(queue_out(NULL, &item) == -1);
+    CHECK(queue_out(&queue, NULL) == -1);
+    CHECK(queue_remove(NULL, 0) == -1);
+}
+
+void test_queue_wrap(void) {
+    queue_t queue;
+    int next_in = 0;
+    int next_out = 0;
+    int item;
+
+    queue_init(&queue);
+
+    // Keep the queue partly full while head and tail wrap several times
+    for (int round = 0; round < QUEUE_SIZE * 4; round++) {
+        int add = 1 + round % 5;
+
+        for (int i = 0; i < add && queue.size < QUEUE_SIZE; i++) {
+            CHECK(queue_in(&queue, next_in++) == 0);
+        }
+
+        for (int i = 0; i < 3 && queue.size > 0; i++) {
+            CHECK(queue_out(&queue, &item) == 0);
+            CHECK(item == next_out++);
+        }
+
+        CHECK(queue.size == next_in - next_out);
+    }
+
+    while (queue_out(&queue, &item) == 0) {
+        CHECK(item == next_out++);
+    }
+
+    CHECK(next_out == next_in);
+}
+
+void test_queue_remove(void) {
+    queue_t queue;
+    int expect[] = {1, 3, 4, 1, 6};
+    int item;
+
+    queue_init(&queue);
+
+    // Start mid-array so the items wrap
+    for (int i = 0; i < QUEUE_SIZE - 2; i++) {
+        queue_in(&queue, 0);
+        queue_out(&queue, &item);
+    }
+
+    int items[] = {1, 2, 3, 4, 2, 1, 6, 2};
+    for (int i = 0; i < 8; i++) {
+        queue_in(&queue, items[i]);
+    }
+
+    CHECK(queue_remove(&queue, 2) == 3);
+    CHECK(queue_remove(&queue, 7) == 0);
+    CHECK(queue.size == 5);
+
+    for (int i = 0; i < 5; i++) {
+        CHECK(queue_out(&queue, &item) == 0);
+        CHECK(item == expect[i]);
+    }
+}
+
+/*
+ * Ring buffer tests
+ */
+int notified;
+
+void test_ringbuf_notify(ringbuf_t *buf) {
+    (void)buf;
+    notified++;
+}
+
+void test_ringbuf_empty_full(void) {
+    ringbuf_t buf;
+    char byte = 'x';
+
+    // Initialization must not depend on the memory being zeroed
+    memset(&buf, 0xaa, sizeof(buf));
+    CHECK(ringbuf_init(&buf) == 0);
+    CHECK(buf.notify == NULL);
+    CHECK(ringbuf_is_empty(&buf));
+    CHECK(!ringbuf_is_full(&buf));
+    CHECK(ringbuf_read(&buf, &byte) == -1);
+    CHECK(byte == 'x');
+
+    for (int i = 0; i < RINGBUF_SIZE; i++) {
+        CHECK(ringbuf_write(&buf, (char)i) == 0);
+    }
+
+    CHECK(ringbuf_is_full(&buf));
+    CHECK(ringbuf_write(&buf, 0) == -1);
+    CHECK(ringbuf_write_mem(&buf, &byte, 1) == -1);
+
+    for (int i = 0; i < RINGBUF_SIZE; i++) {
+        CHECK(ringbuf_read(&buf, &byte) == 0);
+        CHECK(byte == (char)i);
+    }
+
+    CHECK(ringbuf_is_empty(&buf));
+    CHECK(ringbuf_read_mem(&buf, &byte, 1) == 0);
+
+    CHECK(ringbuf_init(NULL) == -1);
+    CHECK(ringbuf_write(NULL, 0) == -1);
+    CHECK(ringbuf_read(NULL, &byte) == -1);
+    CHECK(ringbuf_read(&buf, NULL) == -1);
+    CHECK(!ringbuf_is_empty(NULL));
+    CHECK(!ringbuf_is_full(NULL));
+}
+
+void test_ringbuf_wrap(void) {
+    static ringbuf_t buf;
+    char in[RINGBUF_SIZE];
+    char out[RINGBUF_SIZE];
+    int written = 0;
+    int read = 0;
+    int n;
+
+    ringbuf_init(&buf);
+
+    // Odd sized chunks so that copies straddle the end of the array
+    for (int round = 0; round < 64; round++) {
+        int chunk = 1 + (round * 397) % (RINGBUF_SIZE / 2);
+
+        for (int i = 0; i < chunk; i++) {
+            in[i] = (char)(written + i);
+        }
+
+        if (buf.size + chunk <= RINGBUF_SIZE) {
+            CHECK(ringbuf_write_mem(&buf, in, chunk) == 0);
+            written += chunk;
+        } else {
+            // A write that does not fit must leave the buffer unchanged
+            n = buf.size;
+            CHECK(ringbuf_write_mem(&buf, in, chunk) == -1);
+            CHECK(buf.size == n);
+        }
+
+        n = ringbuf_read_mem(&buf, out, chunk / 2 + 1);
+        CHECK(n >= 0);
+        for (int i = 0; i < n; i++) {
+            CHECK(out[i] == (char)(read + i));
+        }
+        read += n;
+
+        CHECK(buf.size == written - read);
+    }
+
+    // Reading more than is buffered returns what there is
+    n = ringbuf_read_mem(&buf, out, RINGBUF_SIZE);
+    CHECK(n == written - read);
+    for (int i = 0; i < n; i++) {
+        CHECK(out[i] == (char)(read + i));
+    }
+}
+
+void test_ringbuf_flush(void) {
+    static ringbuf_t buf;
+    char byte;
+
+    ringbuf_init(&buf);
+    buf.notify = test_ringbuf_notify;
+    notified = 0;
+
+    ringbuf_write(&buf, 1);
+    ringbuf_write_mem(&buf, "abc", 3);
+    ringbuf_read(&buf, &byte);
+    CHECK(notified == 3);
+
+    CHECK(ringbuf_flush(&buf) == 0);
+    CHECK(notified == 4);
+    CHECK(buf.notify == test_ringbuf_notify);
+    CHECK(ringbuf_is_empty(&buf));
+    CHECK(buf.head == 0 && buf.tail == 0);
+
+    // An empty read copies nothing and does not notify
+    CHECK(ringbuf_read_mem(&buf, &byte, 1) == 0);
+    CHECK(notified == 4);
+}
+
+/*
+ * Bit utility tests
+ */
+void test_bit_util(void) {
+    unsigned int samples[] = {0, 1, 2, 3, 0x80, 0x8000, 0x12345678, 0x7fffffff,
+                              0x80000000, 0xdeadbeef, 0xfffffffe, 0xffffffff};
+
+    CHECK(bit_count(0) == 0);
+    CHECK(bit_count(0xf0) == 4);
+    CHECK(bit_count(-1) == 32);
+    CHECK(bit_count((int)0x80000000) == 1);
+
+    CHECK(bit_test(0x10, 4) == 1);
+    CHECK(bit_test(0x10, 3) == 0);
+    CHECK(bit_set(0, 31) == (int)0x80000000);
+    CHECK(bit_clear(-1, 0) == -2);
+    CHECK(bit_toggle(0x5, 0) == 0x4);
+    CHECK(bit_toggle(0x4, 0) == 0x5);
+
+    CHECK(bit_ffs(0) == -1);
+    CHECK(bit_ffs(0x80000000) == 31);
+    CHECK(bit_ffs(0x18) == 3);
+    CHECK(bit_ffz(0xffffffff) == -1);
+    CHECK(bit_ffz(0x7) == 3);
+    CHECK(bit_fls(0) == -1);
+    CHECK(bit_fls(1) == 0);
+    CHECK(bit_fls(0x80000001) == 31);
+
+    for (int i = 0; i < (int)(sizeof(samples) / sizeof(samples[0])); i++) {
+        CHECK(bit_popcount(samples[i]) == bit_count((int)samples[i]));
+    }
+
+    for (int bit = 0; bit < 32; bit++) {
+        CHECK(bit_ffs(1u << bit) == bit);
+        CHECK(bit_fls(1u << bit) == bit);
+        CHECK(bit_popcount(1u << bit) == 1);
+    }
+}
+
+/*
+ * Benchmarks
+ */
+typedef struct bench_t {
+    const char *name;
+    long long (*run)(long long iterations);     // Returns items processed
+} bench_t;
+
+volatile int bench_sink;
+
+long long bench_queue_in_out(long long iterations) {
+    queue_t queue;
+    int item;
+
+    queue_init(&queue);
+    for (long long i = 0; i < iterations; i++) {
+        queue_in(&queue, (int)i);
+        queue_out(&queue, &item);
+    }
+
+    bench_sink = item;
+    return iterations;
+}
+
+long long bench_queue_remove(long long iterations) {
+    queue_t queue;
+
+    queue_init(&queue);
+    for (int i = 0; i < QUEUE_SIZE; i++) {
+        queue_in(&queue, i);
+    }
+
+    // Removing an item that is not queued still cycles the whole queue
+    for (long long i = 0; i < iterations; i++) {
+        bench_sink = queue_remove(&queue, -1);
+    }
+
+    return iterations * QUEUE_SIZE;
+}
+
+long long bench_ringbuf_byte(long long iterations) {
+    static ringbuf_t buf;
+    char byte = 0;
+
+    ringbuf_init(&buf);
+    for (long long i = 0; i < iterations; i++) {
+        ringbuf_write(&buf, (char)i);
+        ringbuf_read(&buf, &byte);
+    }
+
+    bench_sink = byte;
+    return iterations;
+}
+
+long long bench_ringbuf_mem(long long iterations) {
+    static ringbuf_t buf;
+    char chunk[256] = {0};
+
+    ringbuf_init(&buf);
+    for (long long i = 0; i < iterations; i++) {
+        ringbuf_write_mem(&buf, chunk, sizeof(chunk));
+        bench_sink = ringbuf_read_mem(&buf, chunk, sizeof(chunk));
+    }
+
+    return iterations * sizeof(chunk);
+}
+
+long long bench_bit_count(long long iterations) {
+    int sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        sum += bit_count((int)(i * 2654435761u));
+    }
+
+    bench_sink = sum;
+    return iterations;
+}
+
+long long bench_bit_popcount(long long iterations) {
+    int sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        sum += bit_popcount((unsigned int)(i * 2654435761u));
+    }
+
+    bench_sink = sum;
+    return iterations;
+}
+
+long long bench_bit_ffs(long long iterations) {
+    int sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        sum += bit_ffs((unsigned int)(i * 2654435761u));
+    }
+
+    bench_sink = sum;
+    return iterations;
+}
+
+bench_t benches[] = {
+    {"queue_in_out", bench_queue_in_out},
+    {"queue_remove", bench_queue_remove},
+    {"ringbuf_byte", bench_ringbuf_byte},
+    {"ringbuf_mem/256", bench_ringbuf_mem},
+    {"bit_count", bench_bit_count},
+    {"bit_popcount", bench_bit_popcount},
+    {"bit_ffs", bench_bit_ffs},
+};
+
+long long now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void run_benches(void) {
+    printf("%-20s %12s %12s %14s\n", "Benchmark", "Time", "Iterations", "Items/s");
+
+    for (int b = 0; b < (int)(sizeof(benches) / sizeof(benches[0])); b++) {
+        long long iterations = 1000;
+        long long items;
+        long long elapsed;
+
+        // Grow the iteration count until the run is long enough to time
+        while (1) {
+            long long start = now_ns();
+            items = benches[b].run(iterations);
+            elapsed = now_ns() - start;
+
+            if (elapsed >= BENCH_MIN_NS) {
+                break;
+            }
+
+            iterations *= (elapsed > BENCH_MIN_NS / 10) ? 2 : 10;
+        }
+
+        printf("%-20s %9.2f ns %12lld %12.3fM\n", benches[b].name,
+               (double)elapsed / iterations, iterations, items * 1000.0 / elapsed);
+    }
+}
+
+int main(int argc, char **argv) {
+    int tests = argc < 2 || strcmp(argv[1], "test") == 0;
+    int bench = argc < 2 || strcmp(argv[1], "bench") == 0;
+
+    if (tests) {
+        test_queue_empty_full();
+        test_queue_wrap();
+        test_queue_remove();
+        test_ringbuf_empty_full();
+        test_ringbuf_wrap();
+        test_ringbuf_flush();
+        test_bit_util();
+
+        printf("%d checks, %d failed\n", checks, failures);
+        if (failures) {
+            return 1;
+        }
+    }
+
+    if (bench) {
+        run_benches();
+    }
+
+    return 0;
+}
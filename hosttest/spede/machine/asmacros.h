@@ -0,0 +1,11 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Host shim for <spede/machine/asmacros.h>: only the C declaration macros are used
+ */
+#ifndef __BEGIN_DECLS
+#define __BEGIN_DECLS
+#define __END_DECLS
+#endif
@@ -0,0 +1,21 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Host shim for <spede/machine/proc_reg.h>: flag values and segment
+ * selectors for process trapframes
+ */
+#ifndef PROC_REG_H
+#define PROC_REG_H
+
+#define EF_DEFAULT_VALUE 0x2
+#define EF_INTR          0x200
+
+static inline unsigned short get_cs(void) { return 0x08; }
+static inline unsigned short get_ds(void) { return 0x10; }
+static inline unsigned short get_es(void) { return 0x10; }
+static inline unsigned short get_fs(void) { return 0x10; }
+static inline unsigned short get_gs(void) { return 0x10; }
+
+#endif
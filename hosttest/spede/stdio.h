@@ -0,0 +1,9 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Host shim for <spede/stdio.h>: the host C library provides the same API
+ */
+#include <stdio.h>
+#include <stdlib.h>
@@ -0,0 +1,8 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Host shim for <spede/time.h>: the host C library provides the same API
+ */
+#include <time.h>
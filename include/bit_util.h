@@ -44,4 +44,32 @@ int bit_clear(int value, int bit);
  */
 int bit_toggle(int value, int bit);
 
+/**
+ * Finds the lowest bit that is set
+ * @param value - the value to search
+ * @return index of the lowest set bit, -1 if no bits are set
+ */
+int bit_ffs(unsigned int value);
+
+/**
+ * Finds the highest bit that is set
+ * @param value - the value to search
+ * @return index of the highest set bit, -1 if no bits are set
+ */
+int bit_fls(unsigned int value);
+
+/**
+ * Finds the lowest bit that is clear
+ * @param value - the value to search
+ * @return index of the lowest clear bit, -1 if all bits are set
+ */
+int bit_ffz(unsigned int value);
+
+/**
+ * Counts the number of bits that are set, without looping over each bit
+ * @param value - the value to count bits in
+ * @return number of bits that are set
+ */
+int bit_popcount(unsigned int value);
+
 #endif
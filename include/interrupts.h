@@ -11,10 +11,18 @@
 #include <spede/machine/asmacros.h>
 
 // IRQ Definitions
+#define IRQ_FPU      0x07       // Device not available (FPU owned by another process)
+#define IRQ_DOUBLE_FAULT 0x08   // Double fault exception (handled by a task, see ktss.h)
+#define IRQ_PAGE_FAULT 0x0e     // Page fault exception
 #define IRQ_TIMER    0x20       // PIC IRQ 0 (Timer)
 #define IRQ_KEYBOARD 0x21       // PIC IRQ 1 (Keyboard)
+#define IRQ_CASCADE  0x22       // PIC IRQ 2 (Secondary PIC)
+#define IRQ_ATA      0x2e       // PIC IRQ 14 (Primary ATA channel)
 #define IRQ_SYSCALL  0x80       // System call IRQ
 
+// Maximum number of ISR handlers
+#define IRQ_MAX      0xf0
+
 
 #ifndef ASSEMBLER
 /**
@@ -40,6 +48,14 @@ void interrupts_disable(void);
  */
 void interrupts_irq_register(int irq, void (*entry)(), void (*handler)());
 
+/**
+ * Registers a task gate in the IDT for the specified interrupt
+ * The interrupt switches to the task instead of entering the kernel context
+ * @param irq - IRQ number
+ * @param tss - selector of the task's TSS descriptor
+ */
+void interrupts_task_register(int irq, int tss);
+
 /**
  * Interrupt service routine handler
  * @param irq - IRQ number
@@ -77,6 +93,10 @@ __BEGIN_DECLS
 extern void isr_entry_timer();
 extern void isr_entry_keyboard();
 extern void isr_entry_syscall();
+extern void isr_entry_page_fault();
+extern void isr_entry_ata();
+extern void isr_entry_fpu();
+extern void isr_entry_double_fault();
 
 __END_DECLS
 #endif
@@ -0,0 +1,43 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * ATA Disk Block Device
+ *
+ * Drives the master disk on the primary IDE channel (as emulated by QEMU)
+ * in LBA28 mode. Reads use either PIO, where the CPU copies each sector
+ * out of the data port, or bus-master DMA, where the IDE controller copies
+ * the sectors into memory described by a PRD table. Background reads for
+ * the buffer cache complete on IRQ 14; synchronous transfers poll the
+ * drive. Writes always use PIO.
+ */
+#ifndef KATA_H
+#define KATA_H
+
+#define ATA_NAME        "hd0"
+
+// Transfer modes
+#define ATA_MODE_PIO    0
+#define ATA_MODE_DMA    1
+
+/**
+ * Detects the disk and registers it as a block device
+ * DMA is used when both the disk and the IDE controller support it.
+ * @return -1 if there is no disk, otherwise the block device id
+ */
+int kata_init(void);
+
+/**
+ * Selects the transfer mode used for reads
+ * @param mode - ATA_MODE_PIO or ATA_MODE_DMA
+ * @return -1 if the mode is not available, 0 on success
+ */
+int kata_mode(int mode);
+
+/**
+ * ATA IRQ handler
+ */
+void kata_irq_handler(void);
+
+#endif
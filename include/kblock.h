@@ -0,0 +1,143 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Block Devices
+ *
+ * Drivers describe a device with a kblock_dev_t and register it to get a
+ * device id. All transfers are in whole BLOCK_SIZE blocks; drivers for
+ * devices with smaller sectors transfer several sectors per block.
+ *
+ * Every driver transfers synchronously through read and write. Drivers of
+ * interrupt driven devices may also provide start, which begins a read and
+ * returns at once; the driver's IRQ handler reports the result through
+ * kblock_done. One such transfer may be in progress per device, and
+ * synchronous transfers wait for it to finish first.
+ */
+#ifndef KBLOCK_H
+#define KBLOCK_H
+
+#define BLOCK_SIZE      1024    // Bytes per block
+#define BLOCK_DEV_MAX   4       // Maximum number of registered devices
+
+typedef struct kblock_dev_t kblock_dev_t;
+
+struct kblock_dev_t {
+    char *name;             // Device name (e.g. "ram0")
+    int blocks;             // Number of blocks on the device
+
+    /**
+     * Transfers consecutive blocks between the device and memory
+     * @param dev - the device
+     * @param block - first block number (already bounds checked)
+     * @param count - number of blocks (already bounds checked)
+     * @param buf - memory holding count * BLOCK_SIZE bytes
+     * @return -1 on error, 0 on success
+     */
+    int (*read)(kblock_dev_t *dev, int block, int count, void *buf);
+    int (*write)(kblock_dev_t *dev, int block, int count, void *buf);
+
+    /**
+     * Starts an interrupt driven read of consecutive blocks (may be NULL)
+     * @param dev - the device (not busy)
+     * @param block - first block number (already bounds checked)
+     * @param count - number of blocks (already bounds checked)
+     * @param buf - memory for count * BLOCK_SIZE bytes
+     * @return -1 on error, 0 if the read was started
+     */
+    int (*start)(kblock_dev_t *dev, int block, int count, void *buf);
+
+    /**
+     * Waits for the interrupt driven read in progress, reporting it
+     * through kblock_done (required with start)
+     * @param dev - the device (busy)
+     */
+    void (*finish)(kblock_dev_t *dev);
+
+    void *data;             // Driver private data
+
+    int id;                 // Device id, set when registered
+    int busy;               // An interrupt driven read is in progress
+    void (*done)(int id, int rc);   // Called when the read completes
+
+    int reads;              // Read requests issued to the driver
+    int writes;             // Write requests issued to the driver
+    int blocks_read;        // Blocks read from the device
+    int blocks_written;     // Blocks written to the device
+};
+
+/**
+ * Initializes the block device table
+ */
+void kblock_init(void);
+
+/**
+ * Registers a block device
+ * @param dev - the device (must remain valid while registered)
+ * @return -1 on error, otherwise the device id
+ */
+int kblock_register(kblock_dev_t *dev);
+
+/**
+ * Looks up a block device by name
+ * @param name - device name
+ * @return -1 if not found, otherwise the device id
+ */
+int kblock_find(char *name);
+
+/**
+ * Returns a registered block device
+ * @param id - device id
+ * @return NULL if not registered, otherwise the device
+ */
+kblock_dev_t *kblock_get(int id);
+
+/**
+ * Reads consecutive blocks from a device
+ * @param id - device id
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory for count * BLOCK_SIZE bytes
+ * @return -1 on error, 0 on success
+ */
+int kblock_read(int id, int block, int count, void *buf);
+
+/**
+ * Writes consecutive blocks to a device
+ * @param id - device id
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory holding count * BLOCK_SIZE bytes
+ * @return -1 on error, 0 on success
+ */
+int kblock_write(int id, int block, int count, void *buf);
+
+/**
+ * Starts an interrupt driven read of consecutive blocks
+ * @param id - device id
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory for count * BLOCK_SIZE bytes
+ * @param done - called from the device IRQ with the device id and the
+ *               result (-1 on error, 0 on success) once the read completes
+ * @return -1 if the device is busy, lacks interrupt driven reads or the
+ *         read could not be started, 0 if it was started
+ */
+int kblock_start(int id, int block, int count, void *buf, void (*done)(int id, int rc));
+
+/**
+ * Waits until no interrupt driven read is in progress on the device
+ * Used where a block is needed before the device IRQ can be taken
+ * @param id - device id
+ */
+void kblock_finish(int id);
+
+/**
+ * Reports the end of an interrupt driven read; called by drivers
+ * @param dev - the device
+ * @param rc - -1 on error, 0 on success
+ */
+void kblock_done(kblock_dev_t *dev, int rc);
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Buffer Cache
+ *
+ * Caches device blocks in a fixed set of buffers. Buffers are found
+ * through a hash of (device, block) and recycled in least recently used
+ * order. When a device is read sequentially, the following blocks are
+ * read ahead into the cache. Modified buffers are written back when they
+ * are recycled or synced.
+ *
+ * On devices with interrupt driven reads, kbuf_try reads missing blocks
+ * (and read ahead blocks) in the background so that the requesting
+ * process can sleep with kbuf_wait while other processes run.
+ */
+#ifndef KBUF_H
+#define KBUF_H
+
+#include "kblock.h"
+
+#define KBUF_COUNT      64      // Number of cached blocks
+#define KBUF_HASH_SIZE  64      // Hash buckets (power of two)
+#define KBUF_READ_AHEAD 4       // Blocks read ahead of a sequential reader
+
+// Buffer flags
+#define KBUF_VALID      0x1     // Data holds the block contents
+#define KBUF_DIRTY      0x2     // Data was modified and must be written back
+#define KBUF_AHEAD      0x4     // Read ahead and not yet requested
+#define KBUF_BUSY       0x8     // Background read into the buffer in progress
+
+// kbuf_try result when the block is being read in the background
+#define KBUF_PENDING    1
+
+typedef struct kbuf_t {
+    int dev;                    // Block device id (-1 if unused)
+    int block;                  // Block number on the device
+    int flags;                  // KBUF_* flags
+    int refs;                   // Holders of the buffer; only 0 may be recycled
+    unsigned char *data;        // BLOCK_SIZE bytes of block contents
+    struct kbuf_t *hash_next;   // Next buffer in the same hash bucket
+    struct kbuf_t *lru_next;    // Next less recently used buffer
+    struct kbuf_t *lru_prev;    // Next more recently used buffer
+} kbuf_t;
+
+// Buffer cache statistics
+typedef struct kbuf_stats_t {
+    int hits;                   // Requests served from the cache
+    int misses;                 // Requests that read the device
+    int read_ahead;             // Blocks read ahead
+    int read_ahead_hits;        // Requests served by a read ahead block
+    int evictions;              // Valid buffers recycled for another block
+    int write_backs;            // Dirty buffers written to the device
+} kbuf_stats_t;
+
+/**
+ * Initializes the buffer cache
+ */
+void kbuf_init(void);
+
+/**
+ * Obtains the buffer holding a block, reading it if it is not cached
+ * The buffer must be released with kbuf_put
+ * @param dev - block device id
+ * @param block - block number
+ * @return NULL on error (bad block, device error or every buffer held),
+ *         otherwise the buffer
+ */
+kbuf_t *kbuf_get(int dev, int block);
+
+/**
+ * Obtains the buffer holding a block without waiting on an interrupt
+ * driven device; other devices are read as with kbuf_get
+ * A missing block is read in the background and KBUF_PENDING returned,
+ * after which the caller may sleep with kbuf_wait and try again.
+ * @param dev - block device id
+ * @param block - block number
+ * @param buf - set to the held buffer on success; release with kbuf_put
+ * @return -1 on error, KBUF_PENDING if the block is not yet available,
+ *         0 on success
+ */
+int kbuf_try(int dev, int block, kbuf_t **buf);
+
+/**
+ * Blocks the active process until the device's background read completes
+ * @param dev - block device id
+ * @return -1 if no read is in progress or the process could not be
+ *         queued, 0 on success
+ */
+int kbuf_wait(int dev);
+
+/**
+ * Releases a buffer obtained with kbuf_get
+ * @param buf - the buffer
+ */
+void kbuf_put(kbuf_t *buf);
+
+/**
+ * Marks a held buffer as modified so that it is written back
+ * @param buf - the buffer
+ */
+void kbuf_dirty(kbuf_t *buf);
+
+/**
+ * Writes back every modified buffer
+ * @return -1 if any write failed, 0 on success
+ */
+int kbuf_sync(void);
+
+/**
+ * Fills in the buffer cache statistics
+ * @param stats - pointer to the statistics to fill in
+ */
+void kbuf_stats(kbuf_stats_t *stats);
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Condition Variables
+ */
+#ifndef KCOND_H
+#define KCOND_H
+
+#include "kproc.h"
+#include "queue.h"
+
+// Maximum number of condition variables supported
+#ifndef COND_MAX
+#define COND_MAX 16
+#endif
+
+typedef struct cond_t {
+    int allocated;          // Indicates that this condition has been allocated
+    int mutex;              // The mutex id the condition is bound to
+    queue_t wait_queue;     // The processes waiting on the condition
+} cond_t;
+
+/**
+ * Initializes kernel condition variable data structures
+ * @return -1 on error, 0 on success
+ */
+int kconds_init(void);
+
+/**
+ * Allocates/Creates a condition variable bound to a mutex
+ * @param mutex - the mutex id that protects the condition
+ * @return -1 on error, otherwise the condition id that was allocated
+ */
+int kcond_init(int mutex);
+
+/**
+ * Frees the specified condition variable
+ * @param id - the condition id
+ * @return 0 on success, -1 on error
+ */
+int kcond_destroy(int id);
+
+/**
+ * Releases the bound mutex and waits for the condition to be signaled
+ * The mutex is held again by the process when it is rescheduled
+ * @param id - the condition id
+ * @return -1 on error, 0 on success
+ */
+int kcond_wait(int id);
+
+/**
+ * Wakes one process waiting on the condition
+ * @param id - the condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int kcond_signal(int id);
+
+/**
+ * Wakes all processes waiting on the condition
+ * @param id - the condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int kcond_broadcast(int id);
+#endif
@@ -0,0 +1,87 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel ELF Loader
+ *
+ * Loads statically linked ELF32 executables into a process' private
+ * memory. Program images are built from the user/ directory and placed in
+ * an image table (kelf_images) that is linked into the kernel image.
+ */
+#ifndef KELF_H
+#define KELF_H
+
+#include "kproc.h"
+
+// ELF identification
+#define ELF_MAGIC       0x464c457f  // "\177ELF" as a little endian word
+#define ELF_CLASS_32    1           // e_ident[EI_CLASS]
+#define ELF_DATA_LSB    1           // e_ident[EI_DATA]
+#define ELF_TYPE_EXEC   2           // e_type
+#define ELF_MACHINE_386 3           // e_machine
+
+// Program header types and flags
+#define ELF_PT_LOAD     1           // Loadable segment
+#define ELF_PF_W        0x2         // Segment is writable
+
+// ELF file header
+typedef struct elf_header_t {
+    unsigned int magic;             // ELF_MAGIC
+    unsigned char ident[12];        // Class, data encoding, version, padding
+    unsigned short type;            // Object file type
+    unsigned short machine;         // Target architecture
+    unsigned int version;           // Object file version
+    unsigned int entry;             // Entry point virtual address
+    unsigned int phoff;             // Program header table file offset
+    unsigned int shoff;             // Section header table file offset
+    unsigned int flags;             // Processor-specific flags
+    unsigned short ehsize;          // ELF header size
+    unsigned short phentsize;       // Program header table entry size
+    unsigned short phnum;           // Program header table entry count
+    unsigned short shentsize;       // Section header table entry size
+    unsigned short shnum;           // Section header table entry count
+    unsigned short shstrndx;        // Section name string table index
+} elf_header_t;
+
+// ELF program header
+typedef struct elf_phdr_t {
+    unsigned int type;              // Segment type
+    unsigned int offset;            // Segment file offset
+    unsigned int vaddr;             // Segment virtual address
+    unsigned int paddr;             // Segment physical address
+    unsigned int filesz;            // Segment size in the file
+    unsigned int memsz;             // Segment size in memory
+    unsigned int flags;             // Segment flags
+    unsigned int align;             // Segment alignment
+} elf_phdr_t;
+
+// Program image table entry
+typedef struct kelf_image_t {
+    char *name;                     // Program name
+    unsigned char *data;            // ELF file contents
+    int size;                       // ELF file size in bytes
+} kelf_image_t;
+
+/**
+ * Looks up a program image by name
+ * @param name - program name
+ * @return NULL if not found, otherwise the image table entry
+ */
+kelf_image_t *kelf_find(char *name);
+
+/**
+ * Loads an ELF executable into a process' private memory
+ * Pages holding file contents are mapped and copied; pages that only hold
+ * BSS are left unmapped and zero filled when first touched
+ * @param proc - the process to load into (with no private memory mapped
+ *               where the segments go)
+ * @param data - ELF file contents
+ * @param size - ELF file size in bytes
+ * @param entry - set to the entry point address
+ * @return -1 if the image is not a valid executable or memory is
+ *         exhausted, 0 on success
+ */
+int kelf_load(proc_t *proc, unsigned char *data, int size, unsigned int *entry);
+
+#endif
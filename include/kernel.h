@@ -129,6 +129,8 @@ void kernel_context_enter(trapframe_t *trapframe);
 __BEGIN_DECLS
 /**
  * Exits the kernel context and restores the process context
+ * @param trapframe - pointer to the process' trapframe
+ * @param cr3 - page directory to load, or 0 to keep the current one
  */
 extern void kernel_context_exit();
 __END_DECLS
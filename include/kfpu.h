@@ -0,0 +1,73 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel FPU State
+ *
+ * The x87/SSE registers are switched lazily. The FPU registers belong to
+ * one process at a time, the owner. When any other process runs, CR0.TS is
+ * set so that its first FPU or SSE instruction raises a device not
+ * available exception (#NM). The handler saves the owner's registers,
+ * loads the faulting process' registers (or a clean state) and makes it
+ * the owner. Processes that never use the FPU are never saved or loaded.
+ */
+#ifndef KFPU_H
+#define KFPU_H
+
+#include "kproc.h"
+
+// FXSAVE area size; the FSAVE area used without FXSR is smaller
+#define FPU_STATE_SIZE  512
+
+// FPU switching statistics
+typedef struct fpu_stats_t {
+    int traps;                  // #NM exceptions taken
+    int saves;                  // Register saves
+    int restores;               // Register loads
+} fpu_stats_t;
+
+/**
+ * Enables the FPU (and SSE where supported) and registers the #NM handler
+ */
+void kfpu_init(void);
+
+/**
+ * Sets CR0.TS unless the process about to run owns the FPU registers
+ * Called on every exit from the kernel context
+ * @param proc - the process about to run
+ */
+void kfpu_switch(proc_t *proc);
+
+/**
+ * #NM handler: hands the FPU registers to the active process
+ */
+void kfpu_trap(void);
+
+/**
+ * #NM handler for the kernel context: the owner's registers are saved and
+ * the kernel uses the FPU without an owner
+ */
+void kfpu_trap_kernel(void);
+
+/**
+ * Copies a process' FPU state to a new process created by fork
+ * @param parent - the process being copied
+ * @param child - the new process
+ * @return -1 if out of memory, 0 on success
+ */
+int kfpu_fork(proc_t *parent, proc_t *child);
+
+/**
+ * Drops a process' FPU state; its next FPU use starts from a clean state
+ * @param proc - the process
+ */
+void kfpu_release(proc_t *proc);
+
+/**
+ * Fills in the FPU switching statistics
+ * @param stats - pointer to the statistics to fill in
+ */
+void kfpu_stats(fpu_stats_t *stats);
+
+#endif
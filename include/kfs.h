@@ -0,0 +1,107 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Filesystem
+ *
+ * A read-only filesystem laid out for fast reads. The disk starts with a
+ * superblock, followed by a flat directory and then the file data. Each
+ * file is stored in up to FS_EXTENTS runs of consecutive blocks (the image
+ * builder, tools/mkfs.py, writes every file as a single extent), so file
+ * offsets map to disk blocks without any indirect blocks.
+ *
+ * Open files occupy process I/O slots (IO_TYPE_FILE). Reads copy straight
+ * from the buffer cache into the caller's buffer.
+ */
+#ifndef KFS_H
+#define KFS_H
+
+#include "kproc.h"
+
+#define FS_MAGIC        0x3153464b  // "KFS1"
+#define FS_NAME_LEN     28          // Name bytes, including the terminator
+#define FS_EXTENTS      4           // Extents per file
+#define FS_FILE_MAX     16          // Open files across all processes
+
+// On-disk extent: a run of consecutive blocks
+typedef struct fs_extent_t {
+    unsigned int start;             // First block
+    unsigned int count;             // Number of blocks
+} fs_extent_t;
+
+// On-disk superblock, in block 0
+typedef struct fs_super_t {
+    unsigned int magic;             // FS_MAGIC
+    unsigned int blocks;            // Blocks in the filesystem
+    unsigned int dir_start;         // First directory block
+    unsigned int dir_blocks;        // Number of directory blocks
+    unsigned int files;             // Number of directory entries in use
+} fs_super_t;
+
+// On-disk directory entry
+typedef struct fs_dirent_t {
+    char name[FS_NAME_LEN];         // File name (empty if unused)
+    unsigned int size;              // File size in bytes
+    fs_extent_t extents[FS_EXTENTS];// File data, in file order
+} fs_dirent_t;
+
+// Open file
+typedef struct fs_file_t {
+    int refs;                       // I/O slots referring to the file (0 if free)
+    unsigned int pos;               // Current offset
+    fs_dirent_t entry;              // Copy of the directory entry
+} fs_file_t;
+
+/**
+ * Mounts the filesystem on a block device
+ * @param dev - block device id
+ * @return -1 if the device does not hold a filesystem, 0 on success
+ */
+int kfs_mount(int dev);
+
+/**
+ * Opens a file into a free I/O slot of the active process
+ * @param name - file name
+ * @return -1 on error, otherwise the I/O slot
+ */
+int kfs_open(char *name);
+
+/**
+ * Reads from an open file of the active process
+ * Called from the io_read system call: when a block has to come from an
+ * interrupt driven device first, the process sleeps and repeats the call.
+ * @param io - the I/O slot
+ * @param buf - destination buffer
+ * @param n - maximum number of bytes to read
+ * @return -1 on error, otherwise the number of bytes read (0 at end of file)
+ */
+int kfs_read(int io, char *buf, int n);
+
+/**
+ * Moves the offset of an open file of the active process
+ * @param io - the I/O slot
+ * @param offset - offset relative to whence
+ * @param whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * @return -1 on error, otherwise the new offset
+ */
+int kfs_seek(int io, int offset, int whence);
+
+/**
+ * Counts another reference to the file in a process' I/O slot
+ * Used when the slot has been copied into a new process by fork
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a file, 0 on success
+ */
+int kfs_dup(proc_t *proc, int io);
+
+/**
+ * Closes the file in a process' I/O slot
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a file, 0 on success
+ */
+int kfs_close(proc_t *proc, int io);
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Latency Histograms
+ *
+ * kernel_context_enter reads the time stamp counter on entry and again
+ * just before exiting the kernel context. The difference is recorded in
+ * a log2 bucketed histogram for the interrupt number and, for system
+ * calls, another for the system call id. Interrupts are disabled in the
+ * kernel context, so each measurement covers the handler and the
+ * scheduler without being interrupted.
+ */
+#ifndef KLAT_H
+#define KLAT_H
+
+#include "syscall_common.h"
+
+/**
+ * Reads the time stamp counter
+ * @return CPU cycles since reset
+ */
+unsigned long long klat_rdtsc(void);
+
+/**
+ * Records the latency of a kernel context entry
+ * @param irq - interrupt number
+ * @param syscall - system call id when irq is IRQ_SYSCALL
+ * @param start - time stamp counter on entry
+ */
+void klat_record(int irq, int syscall, unsigned long long start);
+
+/**
+ * Copies the histograms that have samples, in id order
+ * @param kind - LAT_IRQ or LAT_SYSCALL
+ * @param hists - destination for up to n histograms
+ * @param n - maximum number of histograms
+ * @return -1 on error, otherwise the number of histograms copied
+ */
+int klat_snapshot(int kind, lat_hist_t *hists, int n);
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Heap
+ */
+#ifndef KMALLOC_H
+#define KMALLOC_H
+
+#include <spede/stddef.h>
+
+#include "kpage.h"
+#include "syscall_common.h"
+
+// Smallest size class is 1 << KMALLOC_MIN_SHIFT bytes
+#define KMALLOC_MIN_SHIFT 4
+
+// Largest size class; bigger allocations take whole pages
+#define KMALLOC_MAX_SIZE (1 << (KMALLOC_MIN_SHIFT + MEM_CLASSES - 1))
+
+#if KMALLOC_MAX_SIZE > KPAGE_SIZE
+#error "The largest kmalloc size class must fit in a page"
+#endif
+
+/**
+ * Initializes the kernel heap
+ */
+void kmalloc_init(void);
+
+/**
+ * Allocates kernel memory
+ * Sizes up to KMALLOC_MAX_SIZE are rounded up to a power of two and taken
+ * from that size class in O(1); larger sizes take contiguous pages
+ * @param size - number of bytes
+ * @return NULL if out of memory, otherwise the allocated memory
+ */
+void *kmalloc(size_t size);
+
+/**
+ * Frees memory returned by kmalloc
+ * @param ptr - the memory to free (may be NULL)
+ */
+void kfree(void *ptr);
+
+/**
+ * Fills in the heap and page allocator statistics
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 on error, 0 on success
+ */
+int kmalloc_stats(mem_stats_t *stats);
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Mailboxes
+ */
+#ifndef KMBOX_H
+#define KMBOX_H
+
+#include "kproc.h"
+#include "queue.h"
+#include "syscall_common.h"
+
+// Maximum number of mailboxes supported (at most 32, for select masks)
+#ifndef MBOX_MAX
+#define MBOX_MAX 16
+#endif
+
+// Number of message slots in each mailbox
+#ifndef MBOX_SLOTS
+#define MBOX_SLOTS 8
+#endif
+
+typedef struct mbox_t {
+    int allocated;              // Indicates that this mailbox has been allocated
+    int head;                   // Slot of the oldest message
+    int tail;                   // Slot where the next message is stored
+    int count;                  // Number of messages in the mailbox
+    int sizes[MBOX_SLOTS];      // Size of the message in each slot
+    char *slots;                // Message slots in the mailbox arena
+    queue_t send_queue;         // Processes waiting for a free slot
+    queue_t recv_queue;         // Processes waiting for a message
+    queue_t select_queue;       // Processes waiting on several mailboxes
+} mbox_t;
+
+/**
+ * Initializes kernel mailbox data structures
+ * @return -1 on error, 0 on success
+ */
+int kmboxes_init(void);
+
+/**
+ * Allocates/Creates a mailbox
+ * @return -1 on error, otherwise the mailbox id that was allocated
+ */
+int kmbox_init(void);
+
+/**
+ * Frees the specified mailbox
+ * @param id - the mailbox id
+ * @return 0 on success, -1 on error
+ */
+int kmbox_destroy(int id);
+
+/**
+ * Sends a message to the mailbox
+ * The message is queued in a slot and a process waiting to receive is
+ * woken to take it; if all slots are full, the sender blocks and sends
+ * again once a slot is freed
+ * @param id - the mailbox id
+ * @param buf - the message to send
+ * @param size - size of the message (at most MBOX_MSG_SIZE)
+ * @return -1 on error, 0 on success
+ */
+int kmbox_send(int id, char *buf, int size);
+
+/**
+ * Receives the oldest message from the mailbox, blocking if it is empty
+ * @param id - the mailbox id
+ * @param buf - buffer to copy the message to
+ * @param size - size of the buffer; longer messages are truncated
+ * @return -1 on error, otherwise the number of bytes received
+ */
+int kmbox_recv(int id, char *buf, int size);
+
+/**
+ * Waits until any of the selected mailboxes holds a message
+ * @param mask - bitmask of mailbox ids (bit n selects mailbox n)
+ * @return -1 on error, otherwise the id of a mailbox with a message
+ */
+int kmbox_select(int mask);
+#endif
@@ -21,6 +21,7 @@ typedef struct mutex_t {
     int locks;              // The current number of locks held
     proc_t *owner;          // The process that currently holds the mutex
     queue_t wait_queue;     // The processes waiting on the mutex
+    lock_stat_t stats;      // Contention statistics
 } mutex_t;
 
 /**
@@ -55,4 +56,37 @@ int kmutex_lock(int id);
  * @return -1 on error, otherwise the current lock count
  */
 int kmutex_unlock(int id);
+
+/**
+ * Locks the specified mutex on behalf of a process that is not running
+ * The process is added to the scheduler once it owns the mutex, otherwise
+ * it is left waiting in the mutex wait queue
+ * @param id - the mutex id
+ * @param proc - the process to take the lock for
+ * @return -1 on error, otherwise the current lock count
+ */
+int kmutex_lock_proc(int id, proc_t *proc);
+
+/**
+ * Returns the process that currently holds the mutex
+ * @param id - the mutex id
+ * @return NULL if unlocked or on error, otherwise the owning process
+ */
+proc_t *kmutex_owner(int id);
+
+/**
+ * Releases the mutexes held by a process that is exiting
+ * Each mutex is handed to its next waiter, or unlocked
+ * @param proc - the process
+ */
+void kmutex_release(proc_t *proc);
+
+/**
+ * Gets the contention statistics of a mutex
+ * @param id - the mutex id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the mutex is not allocated, 0 on success
+ */
+int kmutex_stats(int id, lock_stat_t *stats);
+
 #endif
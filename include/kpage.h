@@ -0,0 +1,92 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Physical Page Frame Allocator
+ */
+#ifndef KPAGE_H
+#define KPAGE_H
+
+#define KPAGE_SIZE 4096
+
+// Physical memory managed by the allocator
+// The SPEDE loader does not pass a memory map, so the range is configured
+// here; it must lie above the kernel image and within installed memory
+#ifndef KPAGE_MEM_START
+#define KPAGE_MEM_START 0x00400000  // 4 MB, above the kernel image
+#endif
+
+#ifndef KPAGE_MEM_END
+#define KPAGE_MEM_END   0x01000000  // 16 MB
+#endif
+
+#define KPAGE_COUNT ((KPAGE_MEM_END - KPAGE_MEM_START) / KPAGE_SIZE)
+
+#if (KPAGE_COUNT % 32) != 0
+#error "The page allocator range must be a multiple of 32 pages"
+#endif
+
+// Number of words in the page bitmap
+#define KPAGE_WORDS (KPAGE_COUNT / 32)
+
+// Page allocator statistics
+typedef struct kpage_stats_t {
+    int total;              // Pages managed by the allocator
+    int free;               // Pages that are free
+    int largest_free;       // Pages in the largest free run
+    int free_runs;          // Number of separate free runs
+    int allocs;             // Successful allocation calls
+    int frees;              // Successful free calls
+    int failures;           // Allocation calls that failed
+} kpage_stats_t;
+
+/**
+ * Initializes the page allocator with all pages free
+ */
+void kpages_init(void);
+
+/**
+ * Allocates a single page
+ * @return NULL if out of memory, otherwise the physical address of the page
+ */
+void *kpage_alloc(void);
+
+/**
+ * Allocates physically contiguous pages
+ * @param count - number of pages
+ * @return NULL if no run of free pages is long enough, otherwise the
+ *         physical address of the first page
+ */
+void *kpage_alloc_contig(int count);
+
+/**
+ * Frees a single page
+ * @param page - physical address of the page
+ * @return -1 on error, 0 on success
+ */
+int kpage_free(void *page);
+
+/**
+ * Frees physically contiguous pages
+ * @param page - physical address of the first page
+ * @param count - number of pages
+ * @return -1 on error, 0 on success
+ */
+int kpage_free_contig(void *page, int count);
+
+/**
+ * Translates a physical address to a page number
+ * @param addr - physical address
+ * @return -1 if not a page managed by the allocator, otherwise the page
+ */
+int kpage_number(void *addr);
+
+/**
+ * Fills in the allocator statistics, including fragmentation of the free
+ * memory (number of free runs and the largest one)
+ * @param stats - pointer to the statistics to fill in
+ */
+void kpage_stats(kpage_stats_t *stats);
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Paging
+ *
+ * Physical memory used by the kernel is identity mapped with 4 MB pages
+ * that are shared by every address space. Each process additionally has
+ * private memory, mapped with 4 KB pages in the private region, in its own
+ * page directory.
+ *
+ * Every process stack is mapped at the same address, at the top of the
+ * private region, so a forked copy finds its locals where the parent left
+ * them. Stack pages are pinned: they belong to the stack pools in kproc,
+ * are not reference counted and are not shared by fork. Processes run in
+ * ring 0 and take interrupts on their own stack, so a read-only stack page
+ * would turn the next interrupt into a double fault; fork copies the stack
+ * instead. The kernel reaches a stack, and the trapframe on it, through
+ * the identity mapped stack pool (see kproc_stack_to_kernel).
+ *
+ * The rest of the stack region, below the stack, is never mapped. A
+ * process that runs off the base of its stack faults there, and as the
+ * fault cannot be pushed onto the same stack the CPU raises a double
+ * fault. The double fault runs on its own task and stack and the process
+ * is killed (see ktss.h).
+ *
+ * Private pages are reference counted so that fork can share them
+ * copy-on-write: both processes map the page read-only and the first write
+ * from either side copies it (or, if the other side is gone, simply makes
+ * it writable again).
+ *
+ * Private memory can only be reached while its process' page directory is
+ * loaded, which during a system call is the caller's. The kernel therefore
+ * never copies to or from the buffers of another process: a process that
+ * blocks in a system call (pipes, mailboxes, poll) has the call restarted
+ * (see ksyscall_restart) and does its own copy once it runs again, and
+ * anything the kernel needs from it while it is blocked is staged in
+ * kernel memory when it blocks.
+ */
+#ifndef KPAGING_H
+#define KPAGING_H
+
+#include "kpage.h"
+#include "kproc.h"
+#include "syscall_common.h"
+
+// Page directory/table entry flags
+#define PAGE_PRESENT    0x001   // Entry is valid
+#define PAGE_WRITE      0x002   // Page is writable
+#define PAGE_USER       0x004   // Page is accessible from ring 3
+#define PAGE_ACCESSED   0x020   // Set by the CPU when the page is accessed
+#define PAGE_DIRTY      0x040   // Set by the CPU when the page is written
+#define PAGE_LARGE      0x080   // Directory entry maps a 4 MB page
+#define PAGE_GLOBAL     0x100   // Mapping survives CR3 reloads
+#define PAGE_COW        0x200   // Shared read-only until written (available bit)
+#define PAGE_PINNED     0x400   // Frame owned outside of paging (available bit)
+
+// Page fault error code bits
+#define PAGE_FAULT_PRESENT  0x1 // Fault on a present page (protection)
+#define PAGE_FAULT_WRITE    0x2 // Fault caused by a write
+
+#define PAGE_FRAME_MASK 0xfffff000
+
+// Entries in a page directory or page table
+#define KPAGING_ENTRIES 1024
+
+// Size of a 4 MB large page
+#define KPAGING_LARGE_SIZE 0x00400000
+
+// Identity mapped kernel memory, rounded up to whole large pages
+#define KPAGING_KERNEL_END \
+    ((KPAGE_MEM_END + KPAGING_LARGE_SIZE - 1) & ~(KPAGING_LARGE_SIZE - 1))
+
+// Region where process private memory is mapped
+#define KPAGING_PRIVATE_START 0x40000000
+#define KPAGING_PRIVATE_END   0x80000000
+
+// Region holding the process stack, at the top of the private region;
+// only the stack itself is mapped, with the space below it left unmapped
+#define KPAGING_STACK_START (KPAGING_PRIVATE_END - KPAGING_LARGE_SIZE)
+#define KPAGING_STACK_END   KPAGING_PRIVATE_END
+
+// Kernel page directory, used by processes without private memory
+extern unsigned int *kpaging_kernel_dir;
+
+// Page directory currently loaded into CR3
+extern unsigned int kpaging_loaded;
+
+/**
+ * Builds the kernel page directory and enables paging
+ */
+void kpaging_init(void);
+
+/**
+ * Maps newly allocated, zeroed pages into a process' private region
+ * Creates the process page directory and page tables as needed
+ * @param proc - pointer to the process entry
+ * @param vaddr - page aligned virtual address in the private region
+ * @param pages - number of pages to map
+ * @param flags - PAGE_* flags for the mapping (PAGE_PRESENT is implied)
+ * @return -1 on error, 0 on success
+ */
+int kpaging_map(proc_t *proc, unsigned int vaddr, int pages, int flags);
+
+/**
+ * Maps an existing physical page into a process' private region
+ * The mapping holds a reference to the page; pages from the page allocator
+ * are freed when their last mapping is released. Pages mapped PAGE_PINNED
+ * hold no reference and are never freed or shared by fork.
+ * @param proc - pointer to the process entry
+ * @param vaddr - page aligned virtual address in the private region
+ * @param frame - physical address of the page
+ * @param flags - PAGE_* flags for the mapping (PAGE_PRESENT is implied)
+ * @return -1 on error, 0 on success
+ */
+int kpaging_map_frame(proc_t *proc, unsigned int vaddr, unsigned int frame, int flags);
+
+/**
+ * Looks up the page table entry for a private virtual address
+ * @param proc - pointer to the process entry
+ * @param vaddr - virtual address in the private region
+ * @param create - non-zero to create the page directory and table if needed
+ * @return NULL if there is no page table for the address, otherwise a
+ *         pointer to the page table entry
+ */
+unsigned int *kpaging_pte(proc_t *proc, unsigned int vaddr, int create);
+
+/**
+ * Shares a process' private memory with a new process copy-on-write
+ * Pinned pages (the stack) are left out
+ * @param parent - the process being copied
+ * @param child - the new process, with no private memory besides its stack
+ * @return -1 on error, 0 on success
+ */
+int kpaging_fork(proc_t *parent, proc_t *child);
+
+/**
+ * Resolves a write to a copy-on-write page
+ * @param proc - the process that wrote to the page
+ * @param vaddr - the faulting virtual address
+ * @return -1 if the page is not copy-on-write or memory is exhausted,
+ *         0 if the page is now writable
+ */
+int kpaging_cow(proc_t *proc, unsigned int vaddr);
+
+/**
+ * Releases a process' private memory, page tables and page directory
+ * @param proc - pointer to the process entry
+ */
+void kpaging_proc_destroy(proc_t *proc);
+
+/**
+ * Selects the page directory to load when returning to a process
+ * @param proc - the process being returned to
+ * @return physical address of the page directory to load into CR3, or 0
+ *         if the loaded page directory is already correct
+ */
+unsigned int kpaging_switch(proc_t *proc);
+
+/**
+ * Forces a CR3 reload on every return to a process
+ * Used to measure the cost of reloading CR3 and refilling the TLB
+ * @param enabled - non-zero to always reload, zero to reload on change only
+ */
+void kpaging_always_reload(int enabled);
+
+/**
+ * Fills in the page table memory counters
+ * @param stats - pointer to the statistics to fill in
+ */
+void kpaging_stats(mem_stats_t *stats);
+
+#endif
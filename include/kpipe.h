@@ -0,0 +1,102 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Pipes
+ */
+#ifndef KPIPE_H
+#define KPIPE_H
+
+#include "kproc.h"
+#include "queue.h"
+#include "ringbuf.h"
+#include "syscall_common.h"
+
+// Maximum number of pipes supported
+#ifndef PIPE_MAX
+#define PIPE_MAX 8
+#endif
+
+typedef struct pipe_t {
+    int allocated;          // Indicates that this pipe has been allocated
+    int readers;            // Number of open read ends
+    int writers;            // Number of open write ends
+    ringbuf_t buf;          // Data written but not yet read
+    queue_t read_queue;     // The processes waiting for data
+    queue_t write_queue;    // The processes waiting for buffer space
+} pipe_t;
+
+/**
+ * Initializes kernel pipe data structures
+ * @return -1 on error, 0 on success
+ */
+int kpipes_init(void);
+
+/**
+ * Allocates a pipe and installs its ends into the given I/O slots
+ * The slots must not already be in use
+ * @param reader - process receiving the read end
+ * @param read_io - I/O slot of the read end
+ * @param writer - process receiving the write end
+ * @param write_io - I/O slot of the write end
+ * @return -1 on error, otherwise the pipe id that was allocated
+ */
+int kpipe_attach(proc_t *reader, int read_io, proc_t *writer, int write_io);
+
+/**
+ * Allocates a pipe with both ends installed in free I/O slots of the
+ * active process
+ * @param fds - fds[0] is set to the read end, fds[1] to the write end
+ * @return -1 on error, 0 on success
+ */
+int kpipe_open(int *fds);
+
+/**
+ * Reads up to n bytes from the pipe in the active process' I/O slot
+ * Blocks while the pipe is empty and a writer is still open
+ * @param io - the I/O slot of the read end
+ * @param buf - the buffer to copy to
+ * @param n - number of bytes to read
+ * @return -1 on error, 0 at end of file, otherwise the bytes read
+ */
+int kpipe_read(int io, char *buf, int n);
+
+/**
+ * Writes n bytes to the pipe in the active process' I/O slot
+ * Blocks until all bytes have been written or the last reader closes
+ * @param io - the I/O slot of the write end
+ * @param buf - the buffer to copy from
+ * @param n - number of bytes to write
+ * @return -1 on error (including no open readers), otherwise the
+ *         bytes written
+ */
+int kpipe_write(int io, char *buf, int n);
+
+/**
+ * Reports the readiness of the pipe end in a process' I/O slot
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return POLL_IN and/or POLL_OUT bits, 0 if not ready or not a pipe
+ */
+int kpipe_poll(proc_t *proc, int io);
+
+/**
+ * Counts another reference to the pipe end in a process' I/O slot
+ * Used when the slot has been copied into a new process by fork
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a pipe end, 0 on success
+ */
+int kpipe_dup(proc_t *proc, int io);
+
+/**
+ * Closes the pipe end in a process' I/O slot
+ * Waiting readers see end of file once the last writer closes, and
+ * waiting writers are released once the last reader closes
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a pipe end, 0 on success
+ */
+int kpipe_close(proc_t *proc, int io);
+#endif
@@ -0,0 +1,66 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel I/O Polling
+ */
+#ifndef KPOLL_H
+#define KPOLL_H
+
+#include "kproc.h"
+#include "ringbuf.h"
+#include "spscbuf.h"
+#include "syscall_common.h"
+
+// Maximum number of processes that may be blocked in poll at once
+#ifndef POLL_MAX
+#define POLL_MAX 32
+#endif
+
+// Maximum number of I/O buffers in a single poll
+#define POLL_FDS_MAX PROC_IO_MAX
+
+// Process blocked in poll
+typedef struct poller_t {
+    proc_t *proc;           // The waiting process (NULL if the entry is free)
+    pollfd_t fds[POLL_FDS_MAX]; // Copy of the I/O buffers being polled
+    int n;                  // Number of entries in fds
+    int timeout;            // Ticks left before the poll expires, -1 for none
+} poller_t;
+
+/**
+ * Initializes kernel poll data structures
+ * @return -1 on error, 0 on success
+ */
+int kpolls_init(void);
+
+/**
+ * Waits until any of the active process' I/O buffers is ready
+ * @param fds - I/O buffers and requested events; revents is filled in
+ * @param n - number of entries in fds
+ * @param timeout - ticks to wait, 0 to return immediately, -1 to wait forever
+ * @return -1 on error, otherwise the number of ready entries (0 on timeout)
+ */
+int kpoll(pollfd_t *fds, int n, int timeout);
+
+/**
+ * Readiness hook for ring buffers being polled
+ * Wakes every waiting process that has become ready
+ * @param buf - the ring buffer whose contents changed
+ */
+void kpoll_notify(ringbuf_t *buf);
+
+/**
+ * Readiness hook for SPSC buffers being polled
+ * May be called from an IRQ handler
+ * @param buf - the SPSC buffer whose contents changed
+ */
+void kpoll_notify_spsc(spscbuf_t *buf);
+
+/**
+ * Removes a process from the poll waiters (if it is polling)
+ * @param proc - the process entry
+ */
+void kpoll_cancel(proc_t *proc);
+#endif
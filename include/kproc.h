@@ -10,16 +10,24 @@
 
 #include "trapframe.h"
 #include "ringbuf.h"
+#include "spscbuf.h"
 #include "queue.h"
+#include "kslab.h"
+#include "syscall_common.h"
 
-#ifndef PROC_MAX
-#define PROC_MAX        20   // maximum number of processes to support
-#endif
+#define PROC_MAX        4096 // maximum number of processes to support
 
 #define PROC_IO_MAX     4    // Maximum process I/O buffers
 
 #define PROC_NAME_LEN   32   // Maximum length of a process name
-#define PROC_STACK_SIZE 8192 // Process stack size
+
+#define PROC_HASH_SIZE  256  // Buckets in the process id lookup table
+
+#define PROC_STACK_DEFAULT STACK_CLASS_8K // Stack class for ordinary processes
+
+#define PROC_STACK_CANARY 0x57AC0FF5 // Stored in the lowest word of each stack
+
+#define PROC_STACK_SCRUB_CHUNK 512 // Bytes of stack zeroed per interrupt-free step
 
 // Process types
 typedef enum proc_type_t {
@@ -29,6 +37,50 @@ typedef enum proc_type_t {
 } proc_type_t;
 
 
+// Process I/O buffer types
+typedef enum io_type_t {
+    IO_TYPE_RINGBUF,    // Plain ring buffer (such as a TTY output buffer)
+    IO_TYPE_SPSC,       // Lock-free ring buffer filled from an IRQ (TTY input)
+    IO_TYPE_PIPE_READ,  // Read end of a pipe
+    IO_TYPE_PIPE_WRITE, // Write end of a pipe
+    IO_TYPE_FILE        // Open file (read only)
+} io_type_t;
+
+
+// Process stack size classes
+typedef enum stack_class_t {
+    STACK_CLASS_4K,     // Small worker processes
+    STACK_CLASS_8K,     // Ordinary processes
+    STACK_CLASS_32K,    // Processes with deep call chains
+    STACK_CLASS_128K,   // Deeply recursive processes
+    STACK_CLASS_MAX
+} stack_class_t;
+
+
+// Process stack states
+typedef enum stack_state_t {
+    STACK_CLEAN,        // Free and zeroed
+    STACK_DIRTY,        // Free, still holding data from the last process
+    STACK_ZEROING,      // Free, being zeroed by the idle process
+    STACK_IN_USE        // Allocated to a process
+} stack_state_t;
+
+
+// Bookkeeping kept beside each process stack (slab metadata)
+typedef struct stack_slot_t {
+    stack_state_t state;    // State of the stack
+    int dirty_prev;         // Previous stack waiting to be zeroed, -1 for none
+    int dirty_next;         // Next stack waiting to be zeroed, -1 for none
+} stack_slot_t;
+
+
+// Pool of process stacks of a single size class
+typedef struct stack_pool_t {
+    kslab_t slab;           // The stacks, with a stack_slot_t each
+    int dirty;              // First stack waiting to be zeroed, -1 for none
+} stack_pool_t;
+
+
 // Process States
 typedef enum state_t {
     NONE,               // Process has no state (doesn't exist)
@@ -39,10 +91,19 @@ typedef enum state_t {
 } state_t;
 
 
+// Queue of processes, linked through the process entries
+typedef struct proc_queue_t {
+    struct proc_t *head;    // First process in the queue
+    struct proc_t *tail;    // Last process in the queue
+    int size;               // Number of processes in the queue
+} proc_queue_t;
+
+
 // Process control block
 // Contains all details to describe a process
 typedef struct proc_t {
     int pid;                        // Process id
+    int entry;                      // Index of the entry in the process table
     state_t state;                  // Process state
     proc_type_t type;               // Process type (kernel or user)
 
@@ -53,12 +114,29 @@ typedef struct proc_t {
     int cpu_time;                   // Current CPU time the process has used
     int sleep_time;                 // Time that a process should be sleeping
 
-    queue_t *scheduler_queue;       // Pointer to the queue where the process resides
+    int state_time;                 // Time the process became runnable or blocked
+    sched_stats_t sched;            // Context switch and scheduling delay statistics
+
+    int wait_done;                  // Bytes a blocked pipe write has already written
 
-    ringbuf_t *io[PROC_IO_MAX];     // Process input/output buffers
+    proc_queue_t *scheduler_queue;  // Pointer to the queue where the process resides
+    struct proc_t *queue_next;      // Next process in the scheduler queue
+    struct proc_t *queue_prev;      // Previous process in the scheduler queue
 
-    unsigned char *stack;           // Pointer to the process stack
-    trapframe_t *trapframe;         // Pointer to the trapframe
+    struct proc_t *hash_next;       // Next process in the same process id bucket
+
+    void *io[PROC_IO_MAX];          // Process input/output buffers (see io_type)
+    io_type_t io_type[PROC_IO_MAX]; // Type of each input/output buffer
+
+    unsigned char *stack;           // Pointer to the process stack, as the kernel sees it
+    int stack_size;                 // Size of the process stack
+    stack_class_t stack_class;      // Size class of the process stack
+    int stack_slot;                 // Slot of the stack in its class pool
+    unsigned char *fpu_state;       // Saved FPU registers (NULL until the FPU is used)
+    unsigned int *page_dir;         // Private page directory, mapping the stack
+    unsigned int zero_start;        // Start of private memory zero filled on first touch
+    unsigned int zero_end;          // End of private memory zero filled on first touch
+    trapframe_t *trapframe;         // Pointer to the trapframe, as the kernel sees it
 } proc_t;
 
 
@@ -79,9 +157,31 @@ void kproc_init(void);
  * @param proc_ptr - address of process to execute
  * @param proc_name - "friendly" process name
  * @param proc_type - process type (kernel or user)
+ * @param stack_class - size class of the process stack
  * @return process id of the created process, -1 on error
  */
-int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type);
+int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type, stack_class_t stack_class);
+
+/**
+ * Creates a copy of a process
+ * The copy gets its own stack holding the parent's stack contents, mapped
+ * at the same address, shares the parent's I/O buffers and shares its
+ * private memory copy-on-write. It resumes from the parent's trapframe
+ * with 0 as the syscall result.
+ * @param parent - the process to copy
+ * @return process id of the new process, -1 on error
+ */
+int kproc_fork(proc_t *parent);
+
+/**
+ * Replaces a process' program with a program image
+ * The new program is loaded into a separate address space first, so on
+ * error the process continues unchanged. I/O buffers stay open.
+ * @param proc - pointer to the process entry
+ * @param name - name of the program image
+ * @return -1 on error, 0 on success
+ */
+int kproc_exec(proc_t *proc, char *name);
 
 /**
  * Destroys a process
@@ -105,6 +205,62 @@ proc_t *pid_to_proc(int pid);
  */
 proc_t *entry_to_proc(int entry);
 
+/**
+ * Translates a process pointer to the entry index into the process table
+ * @param proc - pointer to a process entry
+ * @return the index into the process table, -1 on error
+ */
+int proc_to_entry(proc_t *proc);
+
+/**
+ * Closes a process' I/O buffer
+ * Pipe ends are released so the other end sees the close
+ * @param proc - pointer to the process entry
+ * @param io - the I/O buffer to close
+ * @return 0 on success, -1 on error
+ */
+int kproc_io_close(proc_t *proc, int io);
+
+/**
+ * Zeroes the stack of one exited process
+ * Called by the idle process so that stacks do not need to be cleared when
+ * processes are created or destroyed
+ * @return 1 if a stack was zeroed, 0 if no stack needed zeroing
+ */
+int kproc_stack_scrub(void);
+
+/**
+ * Translates an address on a process' stack from where the process sees it
+ * (the stack region of its page directory) to where the kernel sees it
+ * @param proc - pointer to the process entry
+ * @param addr - address in the process' stack region
+ * @return the kernel address, or addr if it is not in the stack region
+ */
+void *kproc_stack_to_kernel(proc_t *proc, void *addr);
+
+/**
+ * Translates an address on a process' stack from where the kernel sees it
+ * to where the process sees it
+ * @param proc - pointer to the process entry
+ * @param addr - kernel address in the process' stack
+ * @return the address in the process' stack region, or addr if it is not
+ *         in the process' stack
+ */
+void *kproc_stack_to_proc(proc_t *proc, void *addr);
+
+/**
+ * Checks that a process has not overflowed its stack
+ * Called on every entry into the kernel. Kills the process if it entered
+ * with its trapframe off its stack (after running off the base of the
+ * stack, see ktss.h) or if the canary word at the base of the stack was
+ * overwritten.
+ * @param proc - pointer to the process entry
+ * @param trapframe - the trapframe the process entered the kernel with, as
+ *                    the process sees it
+ * @return -1 if the process overflowed its stack and was killed, 0 otherwise
+ */
+int kproc_stack_check(proc_t *proc, trapframe_t *trapframe);
+
 /**
  * Test process
  */
@@ -0,0 +1,52 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Sampling Profiler
+ *
+ * While profiling, the timer IRQ records the instruction address and pid
+ * of the interrupted process every few ticks. Samples are counted in a
+ * fixed size hash table keyed by (eip, pid), so a profile costs no memory
+ * or instrumentation beyond the table. The kernel context runs with
+ * interrupts disabled, so time spent handling interrupts and system calls
+ * is charged to the process that was interrupted.
+ *
+ * When profiling stops, the profile is written to the kernel log as
+ * "prof eip=... pid=... count=..." lines for tools/profsym.py.
+ */
+#ifndef KPROF_H
+#define KPROF_H
+
+#include "syscall_common.h"
+
+#define PROF_BUCKETS    1024    // Histogram entries (power of two)
+#define PROF_PROBES     16      // Entries searched before a sample is dropped
+
+/**
+ * Starts profiling, clearing the previous profile
+ * @param interval - timer ticks between samples (1 samples on every tick)
+ * @return -1 on error, 0 on success
+ */
+int kprof_start(int interval);
+
+/**
+ * Stops profiling and writes the profile to the kernel log
+ * @return -1 if not profiling, otherwise the number of samples taken
+ */
+int kprof_stop(void);
+
+/**
+ * Copies the profile, most frequent entries first
+ * @param samples - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int kprof_dump(prof_sample_t *samples, int n);
+
+/**
+ * Records a sample of the active process; called from the timer IRQ
+ */
+void kprof_tick(void);
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * RAM Disk Block Device
+ *
+ * Serves blocks from a disk image that is built with the kernel and
+ * embedded in the DLI (see kramdisk_image.S). Writes change the in-memory
+ * image only.
+ */
+#ifndef KRAMDISK_H
+#define KRAMDISK_H
+
+#define RAMDISK_NAME "ram0"
+
+/**
+ * Registers the RAM disk as a block device
+ * @return -1 on error, otherwise the block device id
+ */
+int kramdisk_init(void);
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Reader-Writer Locks
+ */
+#ifndef KRWLOCK_H
+#define KRWLOCK_H
+
+#include "kproc.h"
+#include "queue.h"
+#include "syscall_common.h"
+
+// Maximum number of reader-writer locks supported
+#ifndef RWLOCK_MAX
+#define RWLOCK_MAX 16
+#endif
+
+typedef struct rwlock_t {
+    int allocated;          // Indicates that this lock has been allocated
+    int mode;               // Reader or writer preferring (RWLOCK_PREFER_*)
+    queue_t readers;        // The processes holding the lock for reading
+    proc_t *writer;         // The process that currently holds the write lock
+    queue_t read_queue;     // The processes waiting to read
+    queue_t write_queue;    // The processes waiting to write
+} rwlock_t;
+
+/**
+ * Initializes kernel reader-writer lock data structures
+ * @return -1 on error, 0 on success
+ */
+int krwlocks_init(void);
+
+/**
+ * Allocates/Creates a reader-writer lock
+ * @param mode - RWLOCK_PREFER_READER or RWLOCK_PREFER_WRITER
+ * @return -1 on error, otherwise the lock id that was allocated
+ */
+int krwlock_init(int mode);
+
+/**
+ * Frees the specified reader-writer lock
+ * @param id - the lock id
+ * @return 0 on success, -1 on error
+ */
+int krwlock_destroy(int id);
+
+/**
+ * Takes the lock for reading
+ * @param id - the lock id
+ * @return -1 on error, 0 on success
+ * @note Blocks while a writer holds the lock (or, when writer preferring,
+ *       while any writer is waiting)
+ */
+int krwlock_rdlock(int id);
+
+/**
+ * Takes the lock for writing
+ * @param id - the lock id
+ * @return -1 on error, 0 on success
+ * @note Blocks while any reader or writer holds the lock
+ */
+int krwlock_wrlock(int id);
+
+/**
+ * Releases the lock held by the active process (read or write)
+ * @param id - the lock id
+ * @return -1 on error (including the active process not holding the lock),
+ *         0 on success
+ */
+int krwlock_unlock(int id);
+#endif
@@ -20,6 +20,7 @@ typedef struct sem_t {
     int allocated;          // Indicates that this semaphore has been allocated
     int count;              // The current semaphore count
     queue_t wait_queue;     // The processes waiting on the semaphore
+    lock_stat_t stats;      // Contention statistics
 } sem_t;
 
 /**
@@ -55,4 +56,13 @@ int ksem_wait(int id);
  * @return -1 on error, otherwise the current semaphore count
  */
 int ksem_post(int id);
+
+/**
+ * Gets the contention statistics of a semaphore
+ * @param id - the semaphore id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the semaphore is not allocated, 0 on success
+ */
+int ksem_stats(int id, lock_stat_t *stats);
+
 #endif
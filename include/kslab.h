@@ -0,0 +1,110 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Slab Allocator
+ *
+ * Hands out fixed-size objects identified by an index. Memory is added one
+ * slab (a group of up to 32 objects) at a time from the page allocator as
+ * the cache fills. Each slab keeps a bitmap of its free objects and the
+ * slabs with a free object are kept on a list, so both allocation and free
+ * are O(1). The slab directory is itself allocated from the page allocator
+ * and doubles in size when it fills, so a cache is only limited by the
+ * maximum number of slabs it was created with.
+ *
+ * A cache may keep a few bytes of metadata for each object. The metadata
+ * is stored after the objects of each slab rather than inside them, so it
+ * stays valid while the object is free and objects keep their alignment.
+ */
+#ifndef KSLAB_H
+#define KSLAB_H
+
+#include <spede/stdbool.h>
+
+// Maximum number of objects in a single slab
+#define KSLAB_OBJS_PER_SLAB_MAX 32
+
+// A slab of objects
+typedef struct kslab_slab_t {
+    unsigned char *mem;         // Memory of the objects, followed by their metadata
+    unsigned int free;          // Bit per free object
+    int next_partial;           // Next slab with a free object, -1 for none
+} kslab_slab_t;
+
+typedef struct kslab_t {
+    char *name;                 // Name for log messages
+    int size;                   // Size of each object in bytes
+    int meta_size;              // Size of the metadata of each object in bytes
+    int per_slab;               // Number of objects in each slab
+    int max_slabs;              // Maximum number of slabs
+    int slabs;                  // Number of slabs allocated
+    int used;                   // Number of objects allocated
+    int partial;                // First slab with a free object, -1 for none
+    kslab_slab_t *dir;          // Slab directory
+    int dir_pages;              // Pages allocated for the slab directory
+} kslab_t;
+
+/**
+ * Initializes an empty slab cache
+ * No memory is allocated until the first object is allocated
+ * @param slab - pointer to the slab cache
+ * @param name - name of the cache
+ * @param size - size of each object in bytes
+ * @param meta_size - size of the metadata of each object in bytes (may be 0)
+ * @param per_slab - number of objects in each slab (1 - 32)
+ * @param max_slabs - maximum number of slabs
+ * @return -1 on error, 0 on success
+ */
+int kslab_init(kslab_t *slab, char *name, int size, int meta_size, int per_slab, int max_slabs);
+
+/**
+ * Allocates an object, adding a slab to the cache if it is full
+ * @param slab - pointer to the slab cache
+ * @return -1 if no object could be allocated, otherwise the object index
+ */
+int kslab_alloc(kslab_t *slab);
+
+/**
+ * Frees an object
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return -1 on error, 0 on success
+ */
+int kslab_free(kslab_t *slab, int index);
+
+/**
+ * Returns the memory of an object
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return NULL if the index is not backed by a slab, otherwise the object
+ */
+void *kslab_get(kslab_t *slab, int index);
+
+/**
+ * Returns the metadata of an object
+ * The metadata is not initialized when a slab is added; it is kept while
+ * the object is free
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return NULL if the index is not backed by a slab or the cache keeps no
+ *         metadata, otherwise the metadata of the object
+ */
+void *kslab_meta(kslab_t *slab, int index);
+
+/**
+ * Indicates if an object is allocated
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return true if allocated, false if free or not backed by a slab
+ */
+bool kslab_is_allocated(kslab_t *slab, int index);
+
+/**
+ * Returns the number of objects backed by slabs
+ * @param slab - pointer to the slab cache
+ * @return number of objects (allocated and free)
+ */
+int kslab_capacity(kslab_t *slab);
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Scheduler Trace
+ *
+ * Scheduling decisions, wake-ups, sleeps, blocks and kernel entries are
+ * recorded as fixed size binary events with a time stamp counter value in
+ * a ring. Recording an event is a TSC read and a store, so tracing is
+ * always on. When the ring is full the oldest unread events are
+ * overwritten and counted as dropped.
+ *
+ * Events are consumed either by a process (trace_read) or by writing them
+ * to the kernel log as "trace tsc=... type=..." lines (trace_dump), which
+ * tools/trace2json.py converts to the Chrome trace event format.
+ */
+#ifndef KTRACE_H
+#define KTRACE_H
+
+#include "syscall_common.h"
+
+#define TRACE_EVENTS    2048    // Ring size in events (power of two)
+
+/**
+ * Records a trace event
+ * @param type - event type (TRACE_*)
+ * @param pid - process the event is about (-1 if none)
+ * @param other - related process (-1 if none)
+ * @param irq - interrupt number
+ */
+void ktrace_event(int type, int pid, int other, int irq);
+
+/**
+ * Copies and consumes the oldest unread trace events
+ * @param events - destination for up to n events
+ * @param n - maximum number of events
+ * @return -1 on error, otherwise the number of events copied
+ */
+int ktrace_read(trace_event_t *events, int n);
+
+/**
+ * Writes the unread trace events to the kernel log and consumes them
+ * @return the number of events written
+ */
+int ktrace_dump(void);
+
+#endif
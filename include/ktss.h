@@ -0,0 +1,69 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Task State Segments
+ *
+ * Processes run in ring 0, so an exception is pushed onto the stack that
+ * raised it. A process that runs off the base of its stack faults on the
+ * unmapped page below it, the page fault cannot be pushed either and the
+ * CPU raises a double fault. Double faults are delivered through a task
+ * gate instead: the CPU switches to a separate task with its own stack,
+ * which sends the interrupted task into the kernel context on a scratch
+ * trapframe so that the process is killed (see kproc_stack_check).
+ */
+#ifndef KTSS_H
+#define KTSS_H
+
+// Size of the double fault task's stack
+#define KTSS_STACK_SIZE 4096
+
+// Maximum number of GDT entries, including the two TSS descriptors
+#define KTSS_GDT_MAX    64
+
+// i386 task state segment
+typedef struct tss_t {
+    unsigned int link;          // Selector of the task to return to
+    unsigned int esp0;          // Privilege level stacks (unused in ring 0)
+    unsigned int ss0;
+    unsigned int esp1;
+    unsigned int ss1;
+    unsigned int esp2;
+    unsigned int ss2;
+    unsigned int cr3;           // Page directory, loaded on a switch to the task
+    unsigned int eip;           // Registers, saved on a switch away from the task
+    unsigned int eflags;
+    unsigned int eax;
+    unsigned int ecx;
+    unsigned int edx;
+    unsigned int ebx;
+    unsigned int esp;
+    unsigned int ebp;
+    unsigned int esi;
+    unsigned int edi;
+    unsigned int es;
+    unsigned int cs;
+    unsigned int ss;
+    unsigned int ds;
+    unsigned int fs;
+    unsigned int gs;
+    unsigned int ldt;
+    unsigned short trap;        // Debug trap on a switch to the task
+    unsigned short io_map;      // Offset of the I/O permission bitmap
+} tss_t;
+
+/**
+ * Loads the kernel's task register and installs the double fault task
+ */
+void ktss_init(void);
+
+/**
+ * Handles a double fault, running in the double fault task
+ * A process that ran off the base of its stack is sent into the kernel
+ * context to be killed; any other double fault panics
+ */
+void ktss_double_fault(void);
+
+extern void ktss_fault_task();
+#endif
@@ -0,0 +1,66 @@
+#ifndef PROG_BENCH_H
+#define PROG_BENCH_H
+
+// TTY that benchmark processes write their results to
+#ifndef BENCH_TTY
+#define BENCH_TTY 1
+#endif
+
+// Number of timer ticks in each benchmark measurement window
+#ifndef BENCH_WINDOW_TICKS
+#define BENCH_WINDOW_TICKS 200
+#endif
+
+// Number of reader processes started for the rwlock benchmark
+#ifndef BENCH_RWLOCK_READERS
+#define BENCH_RWLOCK_READERS 4
+#endif
+
+// Locks shared by the rwlock benchmark readers, created by kproc_init
+extern int bench_rwlock_mutex;
+extern int bench_rwlock_lock;
+
+// I/O slot connecting the pipe benchmark writer and reader
+#define BENCH_PIPE_IO 2
+
+// Benchmarks in the order they are run
+typedef enum bench_id_t {
+    BENCH_ID_RWLOCK,
+    BENCH_ID_MSG,
+    BENCH_ID_PIPE,
+    BENCH_ID_SOLO,
+    BENCH_ID_PAIR,
+    BENCH_ID_SPAWN,
+    BENCH_ID_SPSC,
+    BENCH_ID_PAGE,
+    BENCH_ID_KMALLOC,
+    BENCH_ID_PAGING,
+    BENCH_ID_FORK,
+    BENCH_ID_EXEC,
+    BENCH_ID_BLOCK,
+    BENCH_ID_FS,
+    BENCH_ID_ATA,
+    BENCH_ID_FPU,
+    BENCH_ID_STACK,
+    BENCH_ID_MAX
+} bench_id_t;
+
+/**
+ * Waits until the given benchmark is allowed to run
+ * @param bench - benchmark id
+ */
+void bench_wait_turn(int bench);
+
+/**
+ * Allows the next benchmark to run
+ */
+void bench_end_turn(void);
+
+void prog_bench_rwlock(void);
+void prog_bench_msg(void);
+void prog_bench_pipe_writer(void);
+void prog_bench_pipe_reader(void);
+void prog_bench_solo(void);
+void prog_bench_pair(void);
+
+#endif
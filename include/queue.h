@@ -46,6 +46,15 @@ int queue_in(queue_t *queue, int item);
  */
 int queue_out(queue_t *queue, int *item);
 
+/**
+ * Removes every occurrence of an item from the queue
+ * The order of the remaining items is maintained
+ * @param  queue - pointer to the queue
+ * @param  item  - the item to remove
+ * @return -1 on error; otherwise the number of items removed
+ */
+int queue_remove(queue_t *queue, int item);
+
 /**
  * Indicates if the queue is empty
  * @param queue - pointer to the queue structure
@@ -21,6 +21,9 @@ typedef struct ringbuf_t {
     int tail;                   // Tail of the buffer
     int size;                   // Current size of the buffer
     char data[RINGBUF_SIZE];   // Data in buffer
+
+    // Readiness hook, called after data is written, read or flushed
+    void (*notify)(struct ringbuf_t *buf);
 } ringbuf_t;
 
 /**
@@ -45,4 +45,13 @@ void scheduler_remove(proc_t *proc);
  */
 void scheduler_sleep(proc_t *proc, int seconds);
 
+/**
+ * Fills in a process' scheduler statistics, including the time spent so
+ * far in its current state
+ * @param pid - the process id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the process does not exist, 0 on success
+ */
+int scheduler_stats(int pid, sched_stats_t *stats);
+
 #endif
@@ -0,0 +1,111 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Single-producer/single-consumer ring buffer
+ *
+ * The producer only ever writes the tail index and the consumer only ever
+ * writes the head index, so one writer (such as an IRQ handler) and one
+ * reader (such as a process) may use the buffer at the same time without
+ * disabling interrupts or taking a lock.
+ */
+
+#ifndef SPSCBUF_H
+#define SPSCBUF_H
+
+#include <spede/stdbool.h>    // For bool type
+#include <spede/stddef.h>     // For size_t
+
+#ifndef SPSCBUF_SIZE
+#define SPSCBUF_SIZE 2048
+#endif
+
+#if (SPSCBUF_SIZE & (SPSCBUF_SIZE - 1)) != 0
+#error "SPSCBUF_SIZE must be a power of two"
+#endif
+
+#define SPSCBUF_MASK (SPSCBUF_SIZE - 1)
+
+typedef struct spscbuf_t {
+    // Free-running indexes; the buffer holds (tail - head) bytes
+    volatile unsigned int head; // Bytes read so far (written by the consumer)
+    volatile unsigned int tail; // Bytes written so far (written by the producer)
+    char data[SPSCBUF_SIZE];    // Data in buffer
+
+    // Readiness hook, called by either side after data moves
+    void (*notify)(struct spscbuf_t *buf);
+} spscbuf_t;
+
+/**
+ * Initializes an empty buffer
+ * Must not be used while a producer or consumer is active
+ *
+ * @param  buf - pointer to the buffer
+ * @return -1 on error; 0 on success
+ */
+int spscbuf_init(spscbuf_t *buf);
+
+/**
+ * Writes a byte to the buffer (producer only)
+ * @param  buf   - pointer to the buffer
+ * @param  byte  - the byte to write
+ * @return -1 on error or if full; 0 on success
+ */
+int spscbuf_write(spscbuf_t *buf, char byte);
+
+/**
+ * Reads a byte from the buffer (consumer only)
+ * @param  buf - pointer to the buffer
+ * @param  byte - pointer to the byte to be stored
+ * @return -1 on error or if empty; 0 on success
+ */
+int spscbuf_read(spscbuf_t *buf, char *byte);
+
+/**
+ * Copies multiple bytes into the buffer (producer only)
+ * @param buf - pointer to the buffer
+ * @param mem - pointer to the memory location to copy from
+ * @param size - number of bytes to copy
+ * @return -1 on error or if all bytes do not fit, 0 on success
+ */
+int spscbuf_write_mem(spscbuf_t *buf, char *mem, size_t size);
+
+/**
+ * Copies up to size bytes out of the buffer (consumer only)
+ * @param buf - pointer to the buffer
+ * @param mem - pointer to the memory location to copy to
+ * @param size - maximum number of bytes to copy
+ * @return -1 on error, otherwise the number of bytes copied
+ */
+int spscbuf_read_mem(spscbuf_t *buf, char *mem, size_t size);
+
+/**
+ * Discards all data in the buffer (consumer only)
+ * @param buf - pointer to the buffer
+ * @return -1 on error, 0 on success
+ */
+int spscbuf_flush(spscbuf_t *buf);
+
+/**
+ * Returns the number of bytes in the buffer
+ * @param buf - pointer to the buffer
+ * @return number of bytes that can be read
+ */
+int spscbuf_count(spscbuf_t *buf);
+
+/**
+ * Indicates if the buffer is empty
+ * @param buf - pointer to the buffer
+ * @return true if empty, false if not empty
+ */
+bool spscbuf_is_empty(spscbuf_t *buf);
+
+/**
+ * Indicates if the buffer is full
+ * @param buf - pointer to the buffer
+ * @return true if full, false if not full
+ */
+bool spscbuf_is_full(spscbuf_t *buf);
+
+#endif
@@ -128,4 +128,255 @@ int sem_wait(int sem);
  */
 int sem_post(int sem);
 
+/**
+ * Gets the number of timer ticks since startup
+ * @return system time in timer ticks
+ */
+int sys_get_ticks(void);
+
+/**
+ * Allocates a reader-writer lock from the kernel
+ * @param mode - RWLOCK_PREFER_READER or RWLOCK_PREFER_WRITER
+ * @return -1 on error, all other values indicate the lock id
+ */
+int rwlock_init(int mode);
+
+/**
+ * Destroys a reader-writer lock
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ */
+int rwlock_destroy(int rwlock);
+
+/**
+ * Takes a reader-writer lock for reading
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ * @note If a writer holds the lock, process will block/wait.
+ */
+int rwlock_rdlock(int rwlock);
+
+/**
+ * Takes a reader-writer lock for writing
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ * @note If the lock is held, process will block/wait.
+ */
+int rwlock_wrlock(int rwlock);
+
+/**
+ * Releases a reader-writer lock
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ */
+int rwlock_unlock(int rwlock);
+
+/**
+ * Allocates a condition variable bound to a mutex
+ * @param mutex - mutex id protecting the condition
+ * @return -1 on error, all other values indicate the condition id
+ */
+int cond_init(int mutex);
+
+/**
+ * Destroys a condition variable
+ * @param cond - condition id
+ * @return -1 on error, 0 on success
+ */
+int cond_destroy(int cond);
+
+/**
+ * Releases the bound mutex and waits on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, 0 on success
+ * @note The mutex is held again when the process resumes.
+ */
+int cond_wait(int cond);
+
+/**
+ * Wakes one process waiting on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int cond_signal(int cond);
+
+/**
+ * Wakes all processes waiting on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int cond_broadcast(int cond);
+
+/**
+ * Allocates a mailbox from the kernel
+ * @return -1 on error, all other values indicate the mailbox id
+ */
+int mbox_init(void);
+
+/**
+ * Destroys a mailbox
+ * @param mbox - mailbox id
+ * @return -1 on error, 0 on success
+ */
+int mbox_destroy(int mbox);
+
+/**
+ * Sends a message to a mailbox
+ * @param mbox - mailbox id
+ * @param buf - the message to send
+ * @param n - message size (at most MBOX_MSG_SIZE bytes)
+ * @return -1 on error, 0 on success
+ * @note If the mailbox is full, process will block/wait.
+ */
+int msg_send(int mbox, char *buf, int n);
+
+/**
+ * Receives a message from a mailbox
+ * @param mbox - mailbox id
+ * @param buf - the buffer to copy the message to
+ * @param n - size of the buffer
+ * @return -1 on error or value indicating number of bytes received
+ * @note If the mailbox is empty, process will block/wait.
+ */
+int msg_recv(int mbox, char *buf, int n);
+
+/**
+ * Waits until any of the selected mailboxes holds a message
+ * @param mask - bitmask of mailbox ids (bit n selects mailbox n)
+ * @return -1 on error, otherwise the id of a mailbox with a message
+ */
+int msg_select(int mask);
+
+/**
+ * Closes the specified IO buffer
+ * @param io - the IO buffer to close
+ * @return -1 on error or 0 on success
+ * @note Closing the last write end of a pipe signals end of file to readers
+ */
+int io_close(int io);
+
+/**
+ * Creates a pipe in two free IO buffers of the process
+ * @param fds - fds[0] is set to the read end, fds[1] to the write end
+ * @return -1 on error or 0 on success
+ */
+int pipe(int *fds);
+
+/**
+ * Waits until any of the specified IO buffers is ready
+ * @param fds - IO buffers and requested events; revents is filled in
+ * @param n - number of IO buffers in fds
+ * @param timeout - ticks to wait, 0 to return immediately, -1 to wait forever
+ * @return -1 on error, otherwise the number of ready IO buffers (0 on timeout)
+ */
+int poll(pollfd_t *fds, int n, int timeout);
+
+/**
+ * Obtains kernel heap, page allocator and page table statistics
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 on error, 0 on success
+ */
+int mem_stats(mem_stats_t *stats);
+
+/**
+ * Creates a copy of the calling process
+ * The copy shares the caller's memory copy-on-write and its I/O buffers
+ * @return -1 on error, 0 in the new process, otherwise the process id of
+ *         the new process
+ */
+int fork(void);
+
+/**
+ * Replaces the calling process' program with a program image
+ * I/O buffers stay open; on success the call does not return
+ * @param name - name of the program image
+ * @return -1 on error
+ */
+int exec(char *name);
+
+/**
+ * Opens a file from the filesystem into a free IO buffer slot
+ * The slot is read with io_read and released with io_close
+ * @param name - file name
+ * @return -1 on error, otherwise the IO buffer slot
+ */
+int io_open(char *name);
+
+/**
+ * Moves the offset of an open file
+ * @param io - the IO buffer slot of the file
+ * @param offset - offset relative to whence
+ * @param whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * @return -1 on error, otherwise the new offset
+ */
+int io_seek(int io, int offset, int whence);
+
+/**
+ * Starts the sampling profiler, clearing the previous profile
+ * @param interval - timer ticks between samples
+ * @return -1 on error, 0 on success
+ */
+int prof_start(int interval);
+
+/**
+ * Stops the sampling profiler and writes the profile to the kernel log
+ * @return -1 if not profiling, otherwise the number of samples taken
+ */
+int prof_stop(void);
+
+/**
+ * Copies the profile, most frequent entries first
+ * @param samples - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int prof_dump(prof_sample_t *samples, int n);
+
+/**
+ * Copies the kernel latency histograms that have samples, in id order
+ * @param kind - LAT_IRQ or LAT_SYSCALL
+ * @param hists - destination for up to n histograms
+ * @param n - maximum number of histograms
+ * @return -1 on error, otherwise the number of histograms copied
+ */
+int lat_snapshot(int kind, lat_hist_t *hists, int n);
+
+/**
+ * Gets a process' context switch and scheduling delay statistics
+ * @param pid - the process id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the process does not exist, 0 on success
+ */
+int proc_stats(int pid, sched_stats_t *stats);
+
+/**
+ * Gets the contention statistics of the allocated mutexes and semaphores,
+ * sorted by total wait time (longest first)
+ * @param stats - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int lockstat(lock_stat_t *stats, int n);
+
+/**
+ * Copies and consumes the oldest unread scheduler trace events
+ * @param events - destination for up to n events
+ * @param n - maximum number of events
+ * @return -1 on error, otherwise the number of events copied
+ */
+int trace_read(trace_event_t *events, int n);
+
+/**
+ * Writes the unread scheduler trace events to the kernel log and consumes them
+ * @return the number of events written
+ */
+int trace_dump(void);
+
+/**
+ * Writes a line to the kernel log, which the host receives over the serial port
+ * @param msg - the message (without a newline)
+ * @return -1 on error, 0 on success
+ */
+int sys_log(char *msg);
+
 #endif
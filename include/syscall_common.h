@@ -11,6 +11,120 @@
 #define PROC_IO_IN      0       // IO Input Id
 #define PROC_IO_OUT     1       // IO Output Id
 
+#define POLL_IN         0x1     // IO buffer has data to read (or end of file)
+#define POLL_OUT        0x2     // IO buffer has space to write
+
+#define SEEK_SET        0       // Seek relative to the start of a file
+#define SEEK_CUR        1       // Seek relative to the current offset
+#define SEEK_END        2       // Seek relative to the end of a file
+
+#define MBOX_MSG_SIZE   64      // Maximum mailbox message size in bytes
+
+#define RWLOCK_PREFER_READER    0   // Readers may enter while writers wait
+#define RWLOCK_PREFER_WRITER    1   // Waiting writers block new readers
+
+// Number of kmalloc size classes (16 bytes to 2 KB)
+#define MEM_CLASSES 8
+
+// Kernel memory statistics
+typedef struct mem_stats_t {
+    int class_size[MEM_CLASSES];    // Object size of each size class
+    int class_pages[MEM_CLASSES];   // Pages holding objects of each class
+    int class_used[MEM_CLASSES];    // Objects allocated from each class
+    int class_free[MEM_CLASSES];    // Objects cached on each class free list
+    int large_allocs;               // Allocations larger than a size class
+    int large_pages;                // Pages used by large allocations
+    int pages_total;                // Pages managed by the page allocator
+    int pages_free;                 // Pages that are free
+    int free_runs;                  // Number of separate runs of free pages
+    int largest_free;               // Pages in the largest free run
+    int page_dirs;                  // Page directories (kernel and per-process)
+    int page_tables;                // Page tables for private memory
+    int mapped_pages;               // Private pages mapped into processes
+    int cr3_loads;                  // Page directory loads on context switch
+    int cow_faults;                 // Writes to copy-on-write pages
+    int cow_copies;                 // Pages copied by copy-on-write faults
+    int zero_fills;                 // Pages zero filled on first touch
+} mem_stats_t;
+
+// Per-process scheduler statistics; times are in timer ticks
+typedef struct sched_stats_t {
+    int voluntary;              // Switches away to block, sleep, yield or exit
+    int involuntary;            // Switches away to another process on timeslice expiry
+    int timeslices;             // Timeslice expiries
+    int run_ticks;              // Time running
+    int ready_ticks;            // Time runnable on the run queue
+    int wait_ticks;             // Time blocked on locks, semaphores, messages or I/O
+    int sleep_ticks;            // Time sleeping
+} sched_stats_t;
+
+// Lock types (see lockstat)
+#define LOCK_MUTEX      0
+#define LOCK_SEM        1
+
+// Lock contention statistics; times are in timer ticks
+typedef struct lock_stat_t {
+    int type;                   // LOCK_MUTEX or LOCK_SEM
+    int id;                     // Mutex or semaphore id
+    int owner;                  // Owner (mutex) or last taker (semaphore) pid, -1 if none
+    int acquisitions;           // Lock or wait operations
+    int contended;              // Operations that had to block
+    int wait_ticks;             // Total time blocked
+    int max_wait;               // Longest time blocked
+    int max_queue;              // Most processes blocked at once
+} lock_stat_t;
+
+// Scheduler trace event types
+#define TRACE_SWITCH_IN     1   // pid starts running, other was running before
+#define TRACE_SWITCH_OUT    2   // pid stops running, other runs next
+#define TRACE_WAKE          3   // pid is made runnable while other runs
+#define TRACE_SLEEP         4   // pid goes to sleep
+#define TRACE_BLOCK         5   // pid blocks on a lock, message or I/O
+#define TRACE_IRQ_ENTER     6   // irq interrupts pid
+#define TRACE_IRQ_EXIT      7   // irq handling ends, resuming pid
+
+// Scheduler trace event
+typedef struct trace_event_t {
+    unsigned int tsc_lo;        // Time stamp counter, low word
+    unsigned int tsc_hi;        // Time stamp counter, high word
+    unsigned short type;        // Event type (TRACE_*)
+    unsigned short irq;         // Interrupt number (IRQ events)
+    int pid;                    // Process the event is about (-1 if none)
+    int other;                  // Related process (-1 if none)
+} trace_event_t;
+
+// Profile histogram entry: timer ticks that interrupted a process at an
+// instruction address
+typedef struct prof_sample_t {
+    unsigned int eip;       // Interrupted instruction address
+    int pid;                // Interrupted process
+    int count;              // Number of samples
+} prof_sample_t;
+
+// Latency histogram kinds (see lat_snapshot)
+#define LAT_IRQ         0       // Kernel context entries by interrupt number
+#define LAT_SYSCALL     1       // System calls by syscall_t id
+
+// Bucket n counts latencies of 2^n to 2^(n+1) - 1 cycles (bucket 0 also 0)
+#define LAT_BUCKETS     32
+
+// Latency histogram of kernel context entries, measured in TSC cycles
+// from entry to exit (including the scheduler)
+typedef struct lat_hist_t {
+    int id;                     // Interrupt number or system call id
+    unsigned int count;         // Number of entries
+    unsigned int min;           // Shortest latency
+    unsigned int max;           // Longest latency
+    unsigned int buckets[LAT_BUCKETS];
+} lat_hist_t;
+
+// IO buffer to be polled
+typedef struct pollfd_t {
+    int io;                 // IO buffer id
+    int events;             // Requested events (POLL_IN, POLL_OUT)
+    int revents;            // Returned events
+} pollfd_t;
+
 // Syscall identifiers
 typedef enum {
     SYSCALL_NONE,
@@ -30,7 +144,41 @@ typedef enum {
     SYSCALL_SEM_INIT,
     SYSCALL_SEM_DESTROY,
     SYSCALL_SEM_WAIT,
-    SYSCALL_SEM_POST
+    SYSCALL_SEM_POST,
+    SYSCALL_SYS_GET_TICKS,
+    SYSCALL_RWLOCK_INIT,
+    SYSCALL_RWLOCK_DESTROY,
+    SYSCALL_RWLOCK_RDLOCK,
+    SYSCALL_RWLOCK_WRLOCK,
+    SYSCALL_RWLOCK_UNLOCK,
+    SYSCALL_COND_INIT,
+    SYSCALL_COND_DESTROY,
+    SYSCALL_COND_WAIT,
+    SYSCALL_COND_SIGNAL,
+    SYSCALL_COND_BROADCAST,
+    SYSCALL_MBOX_INIT,
+    SYSCALL_MBOX_DESTROY,
+    SYSCALL_MSG_SEND,
+    SYSCALL_MSG_RECV,
+    SYSCALL_MSG_SELECT,
+    SYSCALL_IO_CLOSE,
+    SYSCALL_PIPE,
+    SYSCALL_POLL,
+    SYSCALL_MEM_STATS,
+    SYSCALL_FORK,
+    SYSCALL_EXEC,
+    SYSCALL_IO_OPEN,
+    SYSCALL_IO_SEEK,
+    SYSCALL_PROF_START,
+    SYSCALL_PROF_STOP,
+    SYSCALL_PROF_DUMP,
+    SYSCALL_LAT_SNAPSHOT,
+    SYSCALL_PROC_STATS,
+    SYSCALL_LOCKSTAT,
+    SYSCALL_TRACE_READ,
+    SYSCALL_TRACE_DUMP,
+    SYSCALL_SYS_LOG,
+    SYSCALL_MAX
 } syscall_t;
 
 #endif
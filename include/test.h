@@ -14,6 +14,22 @@
 #include "tty.h"
 #include "kproc.h"
 
+#ifdef BENCH
+#include "interrupts.h"
+#include "kata.h"
+#include "kblock.h"
+#include "kfpu.h"
+#include "kbuf.h"
+#include "kmalloc.h"
+#include "kpage.h"
+#include "kpaging.h"
+#include "kramdisk.h"
+#include "prog_bench.h"
+#include "scheduler.h"
+#include "spscbuf.h"
+#include "syscall.h"
+#endif
+
 /**
  * Displays a "spinner" to show activity at the top-right corner of the
  * VGA output
@@ -61,7 +77,7 @@ void test_proc_list(void) {
     snprintf(buf, VGA_WIDTH, "Entry    PID   State    Time     CPU    Name");
     vga_puts_at(0, 0, bg_color, fg_color, buf);
 
-    for (int i = 0; i < PROC_MAX; i++) {
+    for (int i = 0; i < PROC_MAX && row < VGA_HEIGHT; i++) {
         snprintf(buf, VGA_WIDTH, "%*s", VGA_WIDTH, " ");
 
         proc_t *proc = entry_to_proc(i);
@@ -112,6 +128,1027 @@ void test_proc_list(void) {
 
 }
 
+#ifdef BENCH
+/*
+ * Reports a kernel benchmark result as a "bench <name> key=value ..." line
+ * in the kernel log, where tools/benchcmp.py reads it
+ */
+#define test_bench_report(fmt, ...) kernel_log_info("bench " fmt, ##__VA_ARGS__)
+
+/*
+ * SPSC buffer stress test
+ *
+ * A timer callback (IRQ context) produces a byte sequence in bursts using
+ * both single byte and bulk writes while a process consumes it with odd
+ * sized reads, so that reads and writes interleave at every offset and
+ * wrap around the end of the buffer. The consumer checks that every byte
+ * arrives in order.
+ */
+#define TEST_SPSC_TICKS      1000  // Timer ticks to produce data for
+#define TEST_SPSC_BURST      1500  // Bytes produced per tick
+#define TEST_SPSC_CHUNK      97    // Bytes consumed per read
+
+spscbuf_t test_spsc_buf;
+int test_spsc_running = 0;
+int test_spsc_ticks = 0;
+int test_spsc_drops = 0;
+unsigned char test_spsc_next = 0;
+
+/**
+ * Produces a burst of sequence bytes into the test buffer
+ */
+void test_spsc_producer(void) {
+    char chunk[TEST_SPSC_CHUNK];
+    int produced = 0;
+    int size;
+
+    // Wait for the consumer to start its turn
+    if (!test_spsc_running || test_spsc_ticks >= TEST_SPSC_TICKS) {
+        return;
+    }
+
+    test_spsc_ticks++;
+
+    while (produced < TEST_SPSC_BURST) {
+        // Alternate between single bytes and variable size bulk writes
+        size = (produced % 3) ? 1 : 1 + (produced + test_spsc_ticks) % TEST_SPSC_CHUNK;
+
+        for (int i = 0; i < size; i++) {
+            chunk[i] = (char)(test_spsc_next + i);
+        }
+
+        if (size == 1) {
+            if (spscbuf_write(&test_spsc_buf, chunk[0]) != 0) {
+                test_spsc_drops++;
+                return;
+            }
+        } else if (spscbuf_write_mem(&test_spsc_buf, chunk, size) != 0) {
+            test_spsc_drops++;
+            return;
+        }
+
+        test_spsc_next += size;
+        produced += size;
+    }
+}
+
+/**
+ * Consumes the test buffer and verifies the byte sequence
+ */
+void test_spsc_consumer(void) {
+    char chunk[TEST_SPSC_CHUNK];
+    unsigned char expected = 0;
+    int errors = 0;
+    int bytes = 0;
+    int start;
+    int count;
+
+    bench_wait_turn(BENCH_ID_SPSC);
+
+    start = sys_get_ticks();
+    test_spsc_running = 1;
+
+    while (1) {
+        count = spscbuf_read_mem(&test_spsc_buf, chunk, sizeof(chunk));
+
+        if (count <= 0) {
+            if (test_spsc_ticks >= TEST_SPSC_TICKS) {
+                break;
+            }
+
+            // Nothing to read yet; give up the CPU
+            proc_sleep(0);
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if ((unsigned char)chunk[i] != expected) {
+                errors++;
+                expected = (unsigned char)chunk[i];
+            }
+
+            expected++;
+        }
+
+        bytes += count;
+    }
+
+    test_bench_report("spsc bytes=%d errors=%d drops=%d ticks=%d",
+                      bytes, errors, test_spsc_drops, sys_get_ticks() - start);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Process spawn/exit benchmark
+ *
+ * Repeatedly creates and destroys a process for a fixed number of ticks
+ * and reports the number of round trips per second. Then grows the process
+ * table by creating up to TEST_SPAWN_MAX processes that are kept off the
+ * run queue, and reports how long creating and destroying them took.
+ */
+#define TEST_SPAWN_TICKS     200   // Timer ticks to run for
+#define TEST_SPAWN_MAX       1000  // Processes to hold at once
+
+int test_spawn_pids[TEST_SPAWN_MAX];
+
+/**
+ * Measures process create/destroy round trips
+ */
+void test_spawn_bench(void) {
+    int rounds = 0;
+    int errors = 0;
+    int start;
+    int end;
+    int pid;
+
+    // Run alone so that other processes do not compete for the CPU
+    bench_wait_turn(BENCH_ID_SPAWN);
+
+    start = timer_get_ticks();
+    end = start + TEST_SPAWN_TICKS;
+
+    while (timer_get_ticks() < end) {
+        // Create and destroy without the scheduler running the process
+        asm("cli");
+        pid = kproc_create(kproc_test, "test_spawn_child", PROC_TYPE_KERNEL, STACK_CLASS_4K);
+        if (pid < 0 || kproc_destroy(pid_to_proc(pid)) != 0) {
+            errors++;
+        }
+        asm("sti");
+
+        rounds++;
+    }
+
+    end = timer_get_ticks();
+
+    test_bench_report("spawn_kproc rounds=%d errors=%d ticks=%d rounds_per_sec=%d",
+                      rounds, errors, end - start, rounds * 100 / (end - start));
+
+    // Hold as many processes as possible at once
+    int spawned = 0;
+    int create_ticks;
+
+    start = timer_get_ticks();
+
+    while (spawned < TEST_SPAWN_MAX) {
+        asm("cli");
+        pid = kproc_create(kproc_test, "test_spawn_child", PROC_TYPE_KERNEL, STACK_CLASS_4K);
+        if (pid >= 0) {
+            // Park the process so it never runs
+            proc_t *proc = pid_to_proc(pid);
+
+            scheduler_remove(proc);
+            proc->state = WAITING;
+            test_spawn_pids[spawned++] = pid;
+        }
+        asm("sti");
+
+        if (pid < 0) {
+            break;
+        }
+    }
+
+    create_ticks = timer_get_ticks() - start;
+    start = timer_get_ticks();
+
+    for (int i = 0; i < spawned; i++) {
+        asm("cli");
+        kproc_destroy(pid_to_proc(test_spawn_pids[i]));
+        asm("sti");
+    }
+
+    end = timer_get_ticks();
+
+    test_bench_report("spawn_hold max=%d created=%d create_ticks=%d destroy_ticks=%d",
+                      TEST_SPAWN_MAX, spawned, create_ticks, end - start);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Page allocator benchmark
+ *
+ * Measures single page allocate/free pairs per second, then allocates a
+ * mix of run lengths and frees every other allocation to report how the
+ * free memory fragments.
+ */
+#define TEST_PAGE_TICKS      100   // Timer ticks to run the rate test for
+#define TEST_PAGE_RUNS       64    // Contiguous allocations in the mix
+
+void *test_page_runs[TEST_PAGE_RUNS];
+
+/**
+ * Logs the page allocator statistics
+ * @param label - description of the allocator state
+ */
+void test_page_report(char *label) {
+    kpage_stats_t stats;
+
+    kpage_stats(&stats);
+    test_bench_report("page_%s total=%d free=%d free_runs=%d largest_free=%d failures=%d",
+                      label, stats.total, stats.free, stats.free_runs,
+                      stats.largest_free, stats.failures);
+}
+
+/**
+ * Measures the page allocator
+ */
+void test_page_bench(void) {
+    int pairs = 0;
+    int start;
+    int end;
+    void *page;
+
+    bench_wait_turn(BENCH_ID_PAGE);
+
+    test_page_report("start");
+
+    start = timer_get_ticks();
+    end = start + TEST_PAGE_TICKS;
+
+    while (timer_get_ticks() < end) {
+        asm("cli");
+        page = kpage_alloc();
+        if (page) {
+            kpage_free(page);
+        }
+        asm("sti");
+
+        pairs++;
+    }
+
+    end = timer_get_ticks();
+    test_bench_report("page alloc_free_pairs=%d ticks=%d pairs_per_sec=%d",
+                      pairs, end - start, pairs * 100 / (end - start));
+
+    // Runs of 1 to 8 pages, then free every other one
+    asm("cli");
+    for (int i = 0; i < TEST_PAGE_RUNS; i++) {
+        test_page_runs[i] = kpage_alloc_contig(1 + i % 8);
+    }
+
+    for (int i = 0; i < TEST_PAGE_RUNS; i += 2) {
+        if (test_page_runs[i]) {
+            kpage_free_contig(test_page_runs[i], 1 + i % 8);
+        }
+    }
+    asm("sti");
+
+    test_page_report("fragmented");
+
+    asm("cli");
+    for (int i = 1; i < TEST_PAGE_RUNS; i += 2) {
+        if (test_page_runs[i]) {
+            kpage_free_contig(test_page_runs[i], 1 + i % 8);
+        }
+    }
+    asm("sti");
+
+    test_page_report("end");
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Kernel heap benchmark
+ *
+ * Measures kmalloc/kfree pairs per second over a mix of sizes, then holds
+ * a batch of allocations and logs the per-class usage.
+ */
+#define TEST_KMALLOC_TICKS   100   // Timer ticks to run the rate test for
+#define TEST_KMALLOC_BATCH   256   // Allocations held at once
+
+void *test_kmalloc_ptrs[TEST_KMALLOC_BATCH];
+
+/**
+ * Logs the kernel heap statistics
+ * @param label - description of the heap state
+ */
+void test_kmalloc_report(char *label) {
+    mem_stats_t stats;
+
+    kmalloc_stats(&stats);
+
+    for (int i = 0; i < MEM_CLASSES; i++) {
+        test_bench_report("kmalloc_%s class=%d pages=%d used=%d free=%d", label,
+                          stats.class_size[i], stats.class_pages[i],
+                          stats.class_used[i], stats.class_free[i]);
+    }
+}
+
+/**
+ * Measures the kernel heap
+ */
+void test_kmalloc_bench(void) {
+    int pairs = 0;
+    int start;
+    int end;
+    void *ptr;
+
+    bench_wait_turn(BENCH_ID_KMALLOC);
+
+    start = timer_get_ticks();
+    end = start + TEST_KMALLOC_TICKS;
+
+    while (timer_get_ticks() < end) {
+        asm("cli");
+        ptr = kmalloc(8 + (pairs * 37) % KMALLOC_MAX_SIZE);
+        kfree(ptr);
+        asm("sti");
+
+        pairs++;
+    }
+
+    end = timer_get_ticks();
+    test_bench_report("kmalloc alloc_free_pairs=%d ticks=%d pairs_per_sec=%d",
+                      pairs, end - start, pairs * 100 / (end - start));
+
+    asm("cli");
+    for (int i = 0; i < TEST_KMALLOC_BATCH; i++) {
+        test_kmalloc_ptrs[i] = kmalloc(8 + (i * 37) % KMALLOC_MAX_SIZE);
+    }
+    asm("sti");
+
+    test_kmalloc_report("held");
+
+    asm("cli");
+    for (int i = 0; i < TEST_KMALLOC_BATCH; i++) {
+        kfree(test_kmalloc_ptrs[i]);
+    }
+    asm("sti");
+
+    test_kmalloc_report("freed");
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Page directory switch benchmark
+ *
+ * Maps private pages into the process, then counts syscall round trips
+ * that touch every private page. Each round trip exits the kernel once, so
+ * forcing a CR3 reload on every exit shows the cost of the reload plus
+ * refilling the TLB for the private pages.
+ */
+#define TEST_PAGING_TICKS    100   // Timer ticks to run each pass for
+#define TEST_PAGING_PAGES    16    // Private pages touched per round trip
+
+/**
+ * Counts syscall round trips that touch the private pages
+ * @return number of round trips completed in TEST_PAGING_TICKS
+ */
+int test_paging_pass(void) {
+    volatile unsigned int *page;
+    int trips = 0;
+    int end;
+
+    end = sys_get_ticks() + TEST_PAGING_TICKS;
+
+    while (sys_get_ticks() < end) {
+        for (int i = 0; i < TEST_PAGING_PAGES; i++) {
+            page = (unsigned int *)(KPAGING_PRIVATE_START + i * KPAGE_SIZE);
+            *page += 1;
+        }
+
+        trips++;
+    }
+
+    return trips;
+}
+
+/**
+ * Measures context switch cost with and without CR3 reloads
+ */
+void test_paging_bench(void) {
+    mem_stats_t stats;
+    int trips_switch;
+    int trips_reload;
+
+    bench_wait_turn(BENCH_ID_PAGING);
+
+    asm("cli");
+    if (kpaging_map(active_proc, KPAGING_PRIVATE_START, TEST_PAGING_PAGES, PAGE_WRITE) != 0) {
+        asm("sti");
+        kernel_log_error("paging unable to map private pages");
+        bench_end_turn();
+        proc_exit(-1);
+    }
+    asm("sti");
+
+    // The first syscall exit loads the new page directory
+    trips_switch = test_paging_pass();
+
+    kpaging_always_reload(1);
+    trips_reload = test_paging_pass();
+    kpaging_always_reload(0);
+
+    test_bench_report("paging pages=%d trips_switch_only=%d trips_always_reload=%d ticks=%d",
+                      TEST_PAGING_PAGES, trips_switch, trips_reload, TEST_PAGING_TICKS);
+
+    mem_stats(&stats);
+    test_bench_report("paging_tables page_dirs=%d page_tables=%d mapped_pages=%d cr3_loads=%d",
+                      stats.page_dirs, stats.page_tables, stats.mapped_pages, stats.cr3_loads);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Copy-on-write fork benchmark
+ *
+ * Gives the process 64 KB of private memory, then measures fork/destroy
+ * pairs per second and the number of pages copied after a real fork where
+ * the child writes one page before exiting.
+ */
+#define TEST_FORK_TICKS  100   // Timer ticks to run the rate test for
+#define TEST_FORK_BATCH  32    // Copies held at once in the rate test
+#define TEST_FORK_PAGES  16    // Private pages (64 KB)
+
+int test_fork_pids[TEST_FORK_BATCH];
+
+/**
+ * Writes to each private page
+ * @param pages - number of pages to write to
+ */
+void test_fork_touch(int pages) {
+    volatile unsigned int *page;
+
+    for (int i = 0; i < pages; i++) {
+        page = (unsigned int *)(KPAGING_PRIVATE_START + i * KPAGE_SIZE);
+        *page += 1;
+    }
+}
+
+/**
+ * Measures fork of a 64 KB resident process
+ */
+void test_fork_bench(void) {
+    mem_stats_t before;
+    mem_stats_t after;
+    proc_t *proc;
+    int forks = 0;
+    int start;
+    int end;
+    int pid;
+
+    bench_wait_turn(BENCH_ID_FORK);
+
+    asm("cli");
+    if (kpaging_map(active_proc, KPAGING_PRIVATE_START, TEST_FORK_PAGES, PAGE_WRITE) != 0) {
+        asm("sti");
+        kernel_log_error("fork unable to map private pages");
+        bench_end_turn();
+        proc_exit(-1);
+    }
+    asm("sti");
+
+    // The first syscall exit loads the new page directory
+    sys_get_ticks();
+    test_fork_touch(TEST_FORK_PAGES);
+
+    // The copies are never scheduled, so the rate covers only creating and
+    // destroying them (as with the spawn benchmark)
+    start = timer_get_ticks();
+    end = start + TEST_FORK_TICKS;
+
+    while (timer_get_ticks() < end) {
+        asm("cli");
+        for (int i = 0; i < TEST_FORK_BATCH; i++) {
+            test_fork_pids[i] = kproc_fork(active_proc);
+            proc = pid_to_proc(test_fork_pids[i]);
+            if (proc) {
+                scheduler_remove(proc);
+                proc->state = WAITING;
+                forks++;
+            }
+        }
+        asm("sti");
+
+        asm("cli");
+        for (int i = 0; i < TEST_FORK_BATCH; i++) {
+            proc = pid_to_proc(test_fork_pids[i]);
+            if (proc) {
+                kproc_destroy(proc);
+            }
+        }
+        asm("sti");
+    }
+
+    end = timer_get_ticks();
+    test_bench_report("fork resident_kb=%d forks=%d ticks=%d fork_destroy_pairs_per_sec=%d",
+                      TEST_FORK_PAGES * KPAGE_SIZE / 1024, forks, end - start,
+                      forks * 100 / (end - start));
+
+    // Fork for real: the child writes one page and exits, then the parent
+    // writes every page once the child is gone
+    mem_stats(&before);
+
+    pid = fork();
+    if (pid == 0) {
+        test_fork_touch(1);
+        proc_exit(0);
+    }
+
+    proc_sleep(1);
+    test_fork_touch(TEST_FORK_PAGES);
+
+    mem_stats(&after);
+    test_bench_report("fork_cow resident_pages=%d pages_copied=%d cow_faults=%d",
+                      TEST_FORK_PAGES, after.cow_copies - before.cow_copies,
+                      after.cow_faults - before.cow_faults);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Program startup benchmark
+ *
+ * Counts round trips of fork, exec of the "true" image (which exits from
+ * its first instructions) and exit, against round trips of fork and exit
+ * alone. The difference is the time from exec to the program's first
+ * instruction. The parent waits for each child through a pipe: reading
+ * returns end of file once the child, holding the write end, exits.
+ */
+#define TEST_EXEC_TICKS  100   // Timer ticks to run each pass for
+
+/**
+ * Counts process round trips
+ * @param image - program image for the child to run, NULL to just exit
+ * @return number of round trips completed in TEST_EXEC_TICKS
+ */
+int test_exec_pass(char *image) {
+    int trips = 0;
+    int fds[2];
+    int end;
+    char c;
+
+    end = sys_get_ticks() + TEST_EXEC_TICKS;
+
+    while (sys_get_ticks() < end) {
+        if (pipe(fds) != 0) {
+            return -1;
+        }
+
+        if (fork() == 0) {
+            if (image) {
+                exec(image);
+            }
+
+            proc_exit(0);
+        }
+
+        io_close(fds[1]);
+        io_read(fds[0], &c, 1);
+        io_close(fds[0]);
+
+        trips++;
+    }
+
+    return trips;
+}
+
+/**
+ * Measures the time from exec to a program's first instruction
+ */
+void test_exec_bench(void) {
+    int trips_fork;
+    int trips_exec;
+    int usecs;
+
+    bench_wait_turn(BENCH_ID_EXEC);
+
+    trips_fork = test_exec_pass(NULL);
+    trips_exec = test_exec_pass("true");
+
+    if (trips_fork <= 0 || trips_exec <= 0) {
+        kernel_log_error("exec unable to run the benchmark");
+        bench_end_turn();
+        proc_exit(-1);
+    }
+
+    // Time per round trip in microseconds, at 100 ticks per second
+    usecs = TEST_EXEC_TICKS * 10000 / trips_exec - TEST_EXEC_TICKS * 10000 / trips_fork;
+
+    test_bench_report("exec trips_fork_exit=%d trips_fork_exec_exit=%d ticks=%d exec_to_first_usecs=%d",
+                      trips_fork, trips_exec, TEST_EXEC_TICKS, usecs);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Buffer cache benchmark
+ *
+ * Reads RAM disk blocks through the buffer cache in three patterns and
+ * logs the cache hit rate of each: a sequential scan (served by read
+ * ahead), a working set that fits in the cache, and random blocks across
+ * the disk. Then logs sequential block reads per second.
+ */
+#define TEST_BLOCK_TICKS     100   // Timer ticks to run the rate test for
+#define TEST_BLOCK_WORKING   (KBUF_COUNT / 2)
+#define TEST_BLOCK_RANDOM    2000  // Reads in the random pattern
+
+/**
+ * Reads a block through the cache
+ * @param dev - block device id
+ * @param block - block number
+ * @return -1 on error, 0 on success
+ */
+int test_block_read(int dev, int block) {
+    kbuf_t *buf;
+
+    asm("cli");
+    buf = kbuf_get(dev, block);
+    if (buf) {
+        kbuf_put(buf);
+    }
+    asm("sti");
+
+    return buf ? 0 : -1;
+}
+
+/**
+ * Logs the cache hit rate since a previous snapshot
+ * @param label - name of the access pattern
+ * @param start - statistics before the pattern ran
+ */
+void test_block_report(char *label, kbuf_stats_t *start) {
+    kbuf_stats_t end;
+    int hits;
+    int misses;
+
+    kbuf_stats(&end);
+    hits = end.hits - start->hits;
+    misses = end.misses - start->misses;
+
+    test_bench_report("block_%s reads=%d hits=%d misses=%d hit_pct=%d read_ahead=%d read_ahead_hits=%d",
+                      label, hits + misses, hits, misses, hits * 100 / (hits + misses),
+                      end.read_ahead - start->read_ahead,
+                      end.read_ahead_hits - start->read_ahead_hits);
+
+    *start = end;
+}
+
+/**
+ * Measures the buffer cache
+ */
+void test_block_bench(void) {
+    kbuf_stats_t stats;
+    unsigned int seed = 1;
+    int dev = kblock_find(RAMDISK_NAME);
+    int blocks;
+    int reads = 0;
+    int start;
+    int end;
+
+    bench_wait_turn(BENCH_ID_BLOCK);
+
+    if (dev < 0) {
+        kernel_log_error("block unable to find %s", RAMDISK_NAME);
+        bench_end_turn();
+        proc_exit(-1);
+    }
+
+    blocks = kblock_get(dev)->blocks;
+    kbuf_stats(&stats);
+
+    for (int i = 0; i < blocks; i++) {
+        test_block_read(dev, i);
+    }
+    test_block_report("sequential", &stats);
+
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < TEST_BLOCK_WORKING; i++) {
+            test_block_read(dev, i * 7 % blocks);
+        }
+    }
+    test_block_report("working_set", &stats);
+
+    for (int i = 0; i < TEST_BLOCK_RANDOM; i++) {
+        seed = seed * 1103515245 + 12345;
+        test_block_read(dev, (seed >> 8) % blocks);
+    }
+    test_block_report("random", &stats);
+
+    start = timer_get_ticks();
+    end = start + TEST_BLOCK_TICKS;
+
+    while (timer_get_ticks() < end) {
+        test_block_read(dev, reads % blocks);
+        reads++;
+    }
+
+    end = timer_get_ticks();
+    test_bench_report("block sequential_reads=%d ticks=%d reads_per_sec=%d kb_per_sec=%d",
+                      reads, end - start, reads * 100 / (end - start),
+                      reads * 100 / (end - start) * BLOCK_SIZE / 1024);
+    test_block_report("sequential_rate", &stats);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+#define TEST_FS_FILE        "bench.dat"
+#define TEST_FS_TICKS       100     // Timer ticks to run each read size for
+#define TEST_FS_BUF_SIZE    16384   // Largest read size
+
+unsigned char test_fs_buf[TEST_FS_BUF_SIZE];
+
+/**
+ * Reads the benchmark file from the start in reads of the given size
+ * until the time runs out, restarting at the end of the file
+ * @param fd - the open file
+ * @param size - bytes per read
+ */
+void test_fs_read_rate(int fd, int size) {
+    int bytes = 0;
+    int start;
+    int end;
+    int n;
+
+    io_seek(fd, 0, SEEK_SET);
+    start = timer_get_ticks();
+    end = start + TEST_FS_TICKS;
+
+    while (timer_get_ticks() < end) {
+        n = io_read(fd, (char *)test_fs_buf, size);
+
+        if (n <= 0) {
+            io_seek(fd, 0, SEEK_SET);
+            continue;
+        }
+
+        bytes += n;
+    }
+
+    end = timer_get_ticks();
+    test_bench_report("fs_read read_size=%d bytes=%d ticks=%d kb_per_sec=%d",
+                      size, bytes, end - start, bytes / 1024 * 100 / (end - start));
+}
+
+/**
+ * Measures sequential reads of a 1 MB file through the filesystem
+ */
+void test_fs_bench(void) {
+    static int sizes[] = { 1, 64, 1024, TEST_FS_BUF_SIZE };
+    unsigned int *words = (unsigned int *)test_fs_buf;
+    unsigned int offset = 0;
+    int fd;
+    int start;
+    int n;
+
+    bench_wait_turn(BENCH_ID_FS);
+
+    fd = io_open(TEST_FS_FILE);
+    if (fd < 0) {
+        kernel_log_error("fs unable to open %s", TEST_FS_FILE);
+        bench_end_turn();
+        proc_exit(-1);
+    }
+
+    // Each word of the file holds its own offset
+    start = timer_get_ticks();
+
+    while ((n = io_read(fd, (char *)test_fs_buf, TEST_FS_BUF_SIZE)) > 0) {
+        for (int i = 0; i < n / 4; i++) {
+            if (words[i] != offset + i * 4) {
+                kernel_log_error("fs data mismatch at offset %d", offset + i * 4);
+                io_close(fd);
+                bench_end_turn();
+                proc_exit(-1);
+            }
+        }
+
+        offset += n;
+    }
+
+    test_bench_report("fs verified=%d ticks=%d", offset, timer_get_ticks() - start);
+
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        test_fs_read_rate(fd, sizes[i]);
+    }
+
+    io_close(fd);
+    bench_end_turn();
+    proc_exit(0);
+}
+
+#define TEST_ATA_TICKS      100     // Timer ticks to run each mode for
+#define TEST_ATA_CHUNK      16      // Blocks per multi-block read
+
+unsigned char test_ata_buf[TEST_ATA_CHUNK * BLOCK_SIZE];
+
+/**
+ * Reads the disk sequentially in reads of the given size until the time
+ * runs out
+ * Reads run with interrupts disabled, as they would in the kernel context.
+ * @param dev - block device id of the disk
+ * @param mode - ATA_MODE_PIO or ATA_MODE_DMA
+ * @param count - blocks per read
+ */
+void test_ata_read_rate(int dev, int mode, int count) {
+    int blocks = kblock_get(dev)->blocks / count * count;
+    int block = 0;
+    int reads = 0;
+    int errors = 0;
+    int start;
+    int end;
+
+    if (kata_mode(mode) != 0) {
+        kernel_log_info("ata mode=%s unavailable", mode == ATA_MODE_DMA ? "dma" : "pio");
+        return;
+    }
+
+    start = timer_get_ticks();
+    end = start + TEST_ATA_TICKS;
+
+    while (timer_get_ticks() < end) {
+        interrupts_disable();
+        if (kblock_read(dev, block, count, test_ata_buf) != 0) {
+            errors++;
+        }
+        interrupts_enable();
+
+        block = (block + count) % blocks;
+        reads++;
+    }
+
+    end = timer_get_ticks();
+    test_bench_report("ata_%s read_blocks=%d reads=%d errors=%d ticks=%d kb_per_sec=%d",
+                      mode == ATA_MODE_DMA ? "dma" : "pio", count, reads, errors, end - start,
+                      reads * count * (BLOCK_SIZE / 1024) * 100 / (end - start));
+}
+
+/**
+ * Compares PIO and DMA read throughput of the ATA disk
+ */
+void test_ata_bench(void) {
+    int dev;
+
+    bench_wait_turn(BENCH_ID_ATA);
+
+    dev = kblock_find(ATA_NAME);
+    if (dev < 0) {
+        kernel_log_info("ata no disk attached (see make disk)");
+        bench_end_turn();
+        proc_exit(0);
+    }
+
+    test_ata_read_rate(dev, ATA_MODE_PIO, 1);
+    test_ata_read_rate(dev, ATA_MODE_DMA, 1);
+    test_ata_read_rate(dev, ATA_MODE_PIO, TEST_ATA_CHUNK);
+    test_ata_read_rate(dev, ATA_MODE_DMA, TEST_ATA_CHUNK);
+
+    // Leave the faster mode for the buffer cache
+    kata_mode(ATA_MODE_DMA);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+#define TEST_FPU_WORKERS    3       // Processes doing floating point math
+#define TEST_FPU_ITERATIONS 2000000 // Additions per worker
+
+int test_fpu_done = 0;
+
+/**
+ * Accumulates a value that depends on the process, while being preempted
+ * by the other workers; a result off by another worker's terms means FPU
+ * registers leaked between processes
+ */
+void test_fpu_worker(void) {
+    int pid = proc_get_pid();
+    double step = 0.5 + pid;
+    double sum = 0.0;
+    double expected = step * TEST_FPU_ITERATIONS;
+    fpu_stats_t stats;
+    int start;
+    int last;
+
+    // The workers run together, so that they preempt each other
+    bench_wait_turn(BENCH_ID_FPU);
+
+    start = timer_get_ticks();
+
+    for (int i = 0; i < TEST_FPU_ITERATIONS; i++) {
+        sum += step;
+    }
+
+    kfpu_stats(&stats);
+    test_bench_report("fpu ok=%d ticks=%d traps=%d saves=%d restores=%d",
+                      sum == expected, timer_get_ticks() - start,
+                      stats.traps, stats.saves, stats.restores);
+
+    // The last worker to finish ends the turn
+    asm("cli");
+    last = ++test_fpu_done == TEST_FPU_WORKERS;
+    asm("sti");
+
+    if (last) {
+        bench_end_turn();
+    }
+
+    proc_exit(sum == expected ? 0 : -1);
+}
+
+/*
+ * Stack overflow test
+ *
+ * Runs a process off the base of its stack next to another process with
+ * the same stack class, and checks that only the process that overflowed
+ * is killed while its neighbour keeps running.
+ */
+#define TEST_STACK_TICKS    200     // Timer ticks to wait for the overflow
+
+volatile int test_stack_count = 0;
+volatile int test_stack_stop = 0;
+
+/**
+ * Recurses until the stack runs out
+ * @param depth - the current depth
+ * @return the depth reached (never returns while the stack lasts)
+ */
+unsigned int test_stack_recurse(unsigned int depth) {
+    volatile unsigned int frame[64];
+
+    frame[0] = depth;
+    if (depth == 0xffffffff) {
+        return frame[0];
+    }
+
+    return test_stack_recurse(depth + 1) + frame[0];
+}
+
+/**
+ * Runs off the base of its stack
+ */
+void test_stack_victim(void) {
+    test_stack_recurse(0);
+    proc_exit(0);
+}
+
+/**
+ * Keeps counting until told to stop
+ */
+void test_stack_neighbour(void) {
+    while (!test_stack_stop) {
+        test_stack_count++;
+        proc_sleep(0);
+    }
+
+    proc_exit(0);
+}
+
+/**
+ * Overflows a process stack and checks that only that process dies
+ */
+void test_stack_bench(void) {
+    int neighbour;
+    int victim;
+    int start;
+    int end;
+    int count;
+    int killed;
+    int alive;
+
+    bench_wait_turn(BENCH_ID_STACK);
+
+    neighbour = kproc_create(test_stack_neighbour, "test_stack_ok", PROC_TYPE_KERNEL, STACK_CLASS_4K);
+    victim = kproc_create(test_stack_victim, "test_stack_overflow", PROC_TYPE_KERNEL, STACK_CLASS_4K);
+
+    start = timer_get_ticks();
+    end = start + TEST_STACK_TICKS;
+
+    while (pid_to_proc(victim) && timer_get_ticks() < end) {
+        proc_sleep(0);
+    }
+
+    killed = victim >= 0 && pid_to_proc(victim) == NULL;
+
+    // The neighbour must still be running
+    count = test_stack_count;
+    end = timer_get_ticks() + 10;
+    while (timer_get_ticks() < end) {
+        proc_sleep(0);
+    }
+    alive = neighbour >= 0 && pid_to_proc(neighbour) != NULL && test_stack_count > count;
+
+    test_bench_report("stack_overflow ok=%d killed=%d neighbour_alive=%d ticks=%d",
+                      killed && alive, killed, alive, timer_get_ticks() - start);
+
+    test_stack_stop = 1;
+
+    bench_end_turn();
+    proc_exit(0);
+}
+#endif
+
 /**
  * Initializes all tests
  */
@@ -126,6 +1163,44 @@ void test_init(void) {
 
     // Register the process list to update at a rate of 10 times per second
     timer_callback_register(&test_proc_list, 10, -1);
+
+#ifdef BENCH
+    // Stress the SPSC buffer from the timer IRQ and a consumer process
+    spscbuf_init(&test_spsc_buf);
+    timer_callback_register(&test_spsc_producer, 1, -1);
+    kproc_create(test_spsc_consumer, "test_spsc", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Measure process spawn/exit round trips
+    kproc_create(test_spawn_bench, "test_spawn", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Measure the page allocator
+    kproc_create(test_page_bench, "test_page", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Measure the kernel heap
+    kproc_create(test_kmalloc_bench, "test_kmalloc", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Measure page directory switches
+    kproc_create(test_paging_bench, "test_paging", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Measure copy-on-write fork
+    kproc_create(test_fork_bench, "test_fork", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Measure program startup
+    kproc_create(test_exec_bench, "test_exec", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Measure the buffer cache
+    kproc_create(test_block_bench, "test_block", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+    kproc_create(test_fs_bench, "test_fs", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+    kproc_create(test_ata_bench, "test_ata", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+
+    // Check that FPU registers are switched between processes
+    for (int i = 0; i < TEST_FPU_WORKERS; i++) {
+        kproc_create(test_fpu_worker, "test_fpu", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+    }
+
+    // Check that a stack overflow only kills the process that overflowed
+    kproc_create(test_stack_bench, "test_stack", PROC_TYPE_KERNEL, PROC_STACK_DEFAULT);
+#endif
 }
 
 #endif
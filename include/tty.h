@@ -43,7 +43,7 @@ typedef struct tty_t {
 
     int echo;                   // If the TTY should echo or not
 
-    ringbuf_t io_input;         // Input buffer
+    spscbuf_t io_input;         // Input buffer (written by the keyboard IRQ)
     ringbuf_t io_output;        // Output buffer
 } tty_t;
 
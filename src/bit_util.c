@@ -13,11 +13,13 @@
  * @return number of bits that are set
  */
 int bit_count(int value) {
+    // Shift unsigned so that the sign bit is not copied down forever
+    unsigned int bits = value;
     int count = 0;
-    while (value) {
-	if (value & 1)
+    while (bits) {
+	if (bits & 1)
 		count++;
-	value = value >> 1;
+	bits = bits >> 1;
     }
     return count;
 }
@@ -62,3 +64,54 @@ int bit_clear(int value, int bit) {
 int bit_toggle(int value, int bit) {
     return value = value ^ (1 << bit);
 }
+
+/**
+ * Finds the lowest bit that is set
+ * @param value - the value to search
+ * @return index of the lowest set bit, -1 if no bits are set
+ */
+int bit_ffs(unsigned int value) {
+    if (!value) {
+        return -1;
+    }
+
+    // Compiles to a single bsf instruction
+    return __builtin_ctz(value);
+}
+
+/**
+ * Finds the highest bit that is set
+ * @param value - the value to search
+ * @return index of the highest set bit, -1 if no bits are set
+ */
+int bit_fls(unsigned int value) {
+    if (!value) {
+        return -1;
+    }
+
+    // Compiles to a single bsr instruction
+    return 31 - __builtin_clz(value);
+}
+
+/**
+ * Finds the lowest bit that is clear
+ * @param value - the value to search
+ * @return index of the lowest clear bit, -1 if all bits are set
+ */
+int bit_ffz(unsigned int value) {
+    return bit_ffs(~value);
+}
+
+/**
+ * Counts the number of bits that are set, without looping over each bit
+ * @param value - the value to count bits in
+ * @return number of bits that are set
+ */
+int bit_popcount(unsigned int value) {
+    // Sum adjacent bits, then pairs, then nibbles, then add up the bytes
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    value = (value + (value >> 4)) & 0x0f0f0f0f;
+
+    return (value * 0x01010101) >> 24;
+}
@@ -13,9 +13,6 @@
 #include "kernel.h"
 #include "interrupts.h"
 
-// Maximum number of ISR handlers
-#define IRQ_MAX      0xf0
-
 // PIC Definitions
 #define PIC1_BASE   0x20            // base address for PIC primary controller
 #define PIC2_BASE   0xa0            // base address for PIC secondary controller
@@ -113,6 +110,25 @@ void interrupts_irq_register(int irq, void (*entry)(), void (*handler)()) {
     kernel_log_info("interrupts: IRQ %d (0x%02x) registered)", irq, irq);
 }
 
+/**
+ * Registers a task gate in the IDT for the specified interrupt
+ * The interrupt switches to the task instead of entering the kernel
+ * context, so no handler function is registered
+ *
+ * @param irq - interrupt number
+ * @param tss - selector of the task's TSS descriptor
+ */
+void interrupts_task_register(int irq, int tss) {
+    if (irq < 0 || irq >= IRQ_MAX) {
+        kernel_panic("interrupts: Invalid IRQ %d (0x%02x)", irq, irq);
+        return;
+    }
+
+    fill_gate(&idt[irq], 0, tss, ACC_TASK_GATE, 0);
+
+    kernel_log_info("interrupts: IRQ %d (0x%02x) registered to task 0x%02x", irq, irq, tss);
+}
+
 /**
  * Enables the specified IRQ on the PIC
  *
@@ -126,10 +142,15 @@ void pic_irq_enable(int irq) {
     // Isolate only the first nibble; handles remapping
     irq &= 0xf;
 
-    // Select the secondary PIC if the IRQ is associated with it
+    // Select the secondary PIC if the IRQ is associated with it; its
+    // IRQs only arrive while the cascade IRQ is enabled on the primary
     if (irq >= 0x8) {
         port = PIC2_DATA;
         irq -= 0x8;
+
+        if (!pic_irq_enabled(IRQ_CASCADE)) {
+            pic_irq_enable(IRQ_CASCADE);
+        }
     }
 
     // Read the current mask
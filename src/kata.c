@@ -0,0 +1,659 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * ATA Disk Block Device
+ */
+
+#include <spede/string.h>
+#include <spede/machine/io.h>
+
+#include "interrupts.h"
+#include "kernel.h"
+#include "kata.h"
+#include "kblock.h"
+#include "kpage.h"
+#include "kpaging.h"
+
+// Primary channel task file registers
+#define ATA_DATA            0x1f0
+#define ATA_ERROR           0x1f1
+#define ATA_SECCOUNT        0x1f2
+#define ATA_LBA_LO          0x1f3
+#define ATA_LBA_MID         0x1f4
+#define ATA_LBA_HI          0x1f5
+#define ATA_DRIVE           0x1f6
+#define ATA_STATUS          0x1f7
+#define ATA_COMMAND         0x1f7
+#define ATA_ALT_STATUS      0x3f6
+
+// Status register bits
+#define ATA_SR_ERR          0x01
+#define ATA_SR_DRQ          0x08
+#define ATA_SR_DF           0x20
+#define ATA_SR_BSY          0x80
+
+// Drive register: master drive, LBA addressing
+#define ATA_DRIVE_MASTER    0xa0
+#define ATA_DRIVE_LBA       0x40
+
+// Commands
+#define ATA_CMD_READ        0x20
+#define ATA_CMD_WRITE       0x30
+#define ATA_CMD_READ_DMA    0xc8
+#define ATA_CMD_FLUSH       0xe7
+#define ATA_CMD_IDENTIFY    0xec
+
+#define ATA_SECTOR_SIZE     512
+#define ATA_SECTOR_WORDS    (ATA_SECTOR_SIZE / 2)
+#define ATA_BLOCK_SECTORS   (BLOCK_SIZE / ATA_SECTOR_SIZE)
+#define ATA_MAX_SECTORS     128         // Sectors per command (64 KB)
+#define ATA_TIMEOUT         1000000     // Status polls before giving up
+
+// Bus-master IDE registers, relative to the controller's BAR4
+#define BM_CMD              0x0
+#define BM_STATUS           0x2
+#define BM_PRD              0x4
+
+#define BM_CMD_START        0x01
+#define BM_CMD_READ         0x08        // Transfer from the drive to memory
+#define BM_STATUS_ERR       0x02
+#define BM_STATUS_INTR      0x04
+
+// Physical region descriptors; a region may not cross a 64 KB boundary
+#define ATA_PRD_MAX         4
+#define ATA_PRD_EOT         0x8000
+
+// PCI configuration space access
+#define PCI_CONFIG_ADDR     0xcf8
+#define PCI_CONFIG_DATA     0xcfc
+#define PCI_ENABLE          0x80000000
+#define PCI_REG_ID          0x00
+#define PCI_REG_COMMAND     0x04
+#define PCI_REG_CLASS       0x08
+#define PCI_REG_BAR4        0x20
+#define PCI_CMD_IO          0x1
+#define PCI_CMD_MASTER      0x4
+#define PCI_CLASS_IDE       0x0101      // Mass storage, IDE controller
+
+// Identify data words
+#define ATA_ID_CAPS         49
+#define ATA_ID_CAPS_DMA     0x100
+#define ATA_ID_SECTORS      60
+
+typedef struct ata_prd_t {
+    unsigned int addr;          // Physical address of the region
+    unsigned short size;        // Bytes in the region (0 for 64 KB)
+    unsigned short flags;       // ATA_PRD_EOT on the last region
+} ata_prd_t;
+
+// Interrupt driven read in progress
+typedef struct ata_request_t {
+    int active;                 // A read is in progress
+    int mode;                   // ATA_MODE_PIO or ATA_MODE_DMA
+    int sectors;                // Sectors left to transfer (PIO)
+    unsigned short *buf;        // Destination of the next sector (PIO)
+} ata_request_t;
+
+kblock_dev_t kata_dev;
+ata_request_t kata_req;
+
+int kata_read_mode = ATA_MODE_PIO;
+int kata_dma_ok;                // The disk and controller support DMA
+unsigned int kata_bm;           // Bus-master register base
+ata_prd_t *kata_prd;            // PRD table (in a kernel page)
+
+/**
+ * Waits about 400ns for the drive to update its status after a command
+ */
+static void kata_delay(void) {
+    for (int i = 0; i < 4; i++) {
+        inportb(ATA_ALT_STATUS);
+    }
+}
+
+/**
+ * Polls the status register until the drive is not busy and the masked
+ * status bits match; reading the status also acknowledges the drive's
+ * interrupt
+ * @param mask - status bits to check
+ * @param value - expected value of the bits
+ * @return -1 on a drive error or timeout, 0 on success
+ */
+static int kata_wait(int mask, int value) {
+    int status;
+
+    for (int i = 0; i < ATA_TIMEOUT; i++) {
+        status = inportb(ATA_STATUS);
+
+        if (status & ATA_SR_BSY) {
+            continue;
+        }
+
+        if (status & (ATA_SR_ERR | ATA_SR_DF)) {
+            return -1;
+        }
+
+        if ((status & mask) == value) {
+            return 0;
+        }
+    }
+
+    kernel_log_warn("ata: timeout, status 0x%02x", inportb(ATA_STATUS));
+    return -1;
+}
+
+/**
+ * Issues a command for a run of sectors
+ * @param sector - first sector (LBA)
+ * @param sectors - number of sectors (1 to 256)
+ * @param cmd - the command
+ * @return -1 if the drive did not become ready, 0 on success
+ */
+static int kata_command(unsigned int sector, int sectors, int cmd) {
+    if (kata_wait(ATA_SR_BSY, 0) != 0) {
+        return -1;
+    }
+
+    outportb(ATA_DRIVE, ATA_DRIVE_MASTER | ATA_DRIVE_LBA | ((sector >> 24) & 0x0f));
+    outportb(ATA_SECCOUNT, sectors & 0xff);
+    outportb(ATA_LBA_LO, sector & 0xff);
+    outportb(ATA_LBA_MID, (sector >> 8) & 0xff);
+    outportb(ATA_LBA_HI, (sector >> 16) & 0xff);
+    outportb(ATA_COMMAND, cmd);
+    kata_delay();
+
+    return 0;
+}
+
+/**
+ * Copies one sector out of the data port
+ * @param buf - destination for ATA_SECTOR_WORDS words
+ */
+static void kata_pio_in(unsigned short *buf) {
+    for (int i = 0; i < ATA_SECTOR_WORDS; i++) {
+        buf[i] = inportw(ATA_DATA);
+    }
+}
+
+/**
+ * Copies one sector into the data port
+ * @param buf - source of ATA_SECTOR_WORDS words
+ */
+static void kata_pio_out(unsigned short *buf) {
+    for (int i = 0; i < ATA_SECTOR_WORDS; i++) {
+        outportw(ATA_DATA, buf[i]);
+    }
+}
+
+/**
+ * Fills in the PRD table for a transfer and loads it into the controller
+ * @param buf - transfer memory
+ * @param size - transfer size in bytes
+ * @return -1 if the memory is not identity mapped or needs too many
+ *         regions, 0 on success
+ */
+static int kata_dma_setup(void *buf, int size) {
+    unsigned int addr = (unsigned int)buf;
+    unsigned int len;
+    int n = 0;
+
+    // The controller uses physical addresses
+    if (addr + size > KPAGING_KERNEL_END) {
+        return -1;
+    }
+
+    while (size > 0 && n < ATA_PRD_MAX) {
+        len = 0x10000 - (addr & 0xffff);
+        if (len > (unsigned int)size) {
+            len = size;
+        }
+
+        kata_prd[n].addr = addr;
+        kata_prd[n].size = len & 0xffff;
+        kata_prd[n].flags = 0;
+
+        addr += len;
+        size -= len;
+        n++;
+    }
+
+    if (size > 0) {
+        return -1;
+    }
+
+    kata_prd[n - 1].flags = ATA_PRD_EOT;
+
+    outportb(kata_bm + BM_CMD, BM_CMD_READ);
+    outportl(kata_bm + BM_PRD, (unsigned int)kata_prd);
+    outportb(kata_bm + BM_STATUS, BM_STATUS_ERR | BM_STATUS_INTR);
+
+    return 0;
+}
+
+/**
+ * Starts a DMA read
+ * @param sector - first sector
+ * @param sectors - number of sectors (at most ATA_MAX_SECTORS)
+ * @param buf - identity mapped destination
+ * @return -1 on error, 0 if the read was started
+ */
+static int kata_dma_start(unsigned int sector, int sectors, void *buf) {
+    if (kata_dma_setup(buf, sectors * ATA_SECTOR_SIZE) != 0) {
+        return -1;
+    }
+
+    if (kata_command(sector, sectors, ATA_CMD_READ_DMA) != 0) {
+        return -1;
+    }
+
+    outportb(kata_bm + BM_CMD, BM_CMD_READ | BM_CMD_START);
+    return 0;
+}
+
+/**
+ * Stops the controller after a DMA read and acknowledges the interrupt
+ * @return -1 if the transfer failed, 0 on success
+ */
+static int kata_dma_end(void) {
+    int bm_status = inportb(kata_bm + BM_STATUS);
+    int status;
+
+    outportb(kata_bm + BM_CMD, 0);
+    status = inportb(ATA_STATUS);
+    outportb(kata_bm + BM_STATUS, BM_STATUS_ERR | BM_STATUS_INTR);
+
+    if ((bm_status & BM_STATUS_ERR) || (status & (ATA_SR_ERR | ATA_SR_DF))) {
+        kernel_log_warn("ata: DMA error, status 0x%02x, bus-master status 0x%02x",
+                        status, bm_status);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Polls for the end of a DMA read
+ * @return -1 on error or timeout, 0 on success
+ */
+static int kata_dma_wait(void) {
+    for (int i = 0; i < ATA_TIMEOUT; i++) {
+        if (inportb(kata_bm + BM_STATUS) & (BM_STATUS_INTR | BM_STATUS_ERR)) {
+            return kata_dma_end();
+        }
+    }
+
+    outportb(kata_bm + BM_CMD, 0);
+    kernel_log_warn("ata: DMA timeout");
+    return -1;
+}
+
+/**
+ * Reads sectors, polling the drive
+ * @param sector - first sector
+ * @param sectors - number of sectors (at most ATA_MAX_SECTORS)
+ * @param buf - destination
+ * @return -1 on error, 0 on success
+ */
+static int kata_read_sectors(unsigned int sector, int sectors, unsigned short *buf) {
+    if (kata_read_mode == ATA_MODE_DMA && kata_dma_start(sector, sectors, buf) == 0) {
+        return kata_dma_wait();
+    }
+
+    // PIO, also used for memory the controller cannot reach
+    if (kata_command(sector, sectors, ATA_CMD_READ) != 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < sectors; i++) {
+        if (kata_wait(ATA_SR_DRQ, ATA_SR_DRQ) != 0) {
+            return -1;
+        }
+
+        kata_pio_in(buf + i * ATA_SECTOR_WORDS);
+    }
+
+    return 0;
+}
+
+/**
+ * Reads blocks from the disk, polling the drive
+ * @param dev - the disk
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory for count * BLOCK_SIZE bytes
+ * @return -1 on error, 0 on success
+ */
+static int kata_read(kblock_dev_t *dev, int block, int count, void *buf) {
+    unsigned int sector = block * ATA_BLOCK_SECTORS;
+    int sectors = count * ATA_BLOCK_SECTORS;
+    unsigned short *dst = buf;
+    int n;
+
+    while (sectors > 0) {
+        n = (sectors < ATA_MAX_SECTORS) ? sectors : ATA_MAX_SECTORS;
+
+        if (kata_read_sectors(sector, n, dst) != 0) {
+            return -1;
+        }
+
+        sector += n;
+        sectors -= n;
+        dst += n * ATA_SECTOR_WORDS;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes blocks to the disk with PIO and flushes the drive's write cache
+ * @param dev - the disk
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory holding count * BLOCK_SIZE bytes
+ * @return -1 on error, 0 on success
+ */
+static int kata_write(kblock_dev_t *dev, int block, int count, void *buf) {
+    unsigned int sector = block * ATA_BLOCK_SECTORS;
+    int sectors = count * ATA_BLOCK_SECTORS;
+    unsigned short *src = buf;
+    int n;
+
+    while (sectors > 0) {
+        n = (sectors < ATA_MAX_SECTORS) ? sectors : ATA_MAX_SECTORS;
+
+        if (kata_command(sector, n, ATA_CMD_WRITE) != 0) {
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (kata_wait(ATA_SR_DRQ, ATA_SR_DRQ) != 0) {
+                return -1;
+            }
+
+            kata_pio_out(src);
+            src += ATA_SECTOR_WORDS;
+        }
+
+        sector += n;
+        sectors -= n;
+    }
+
+    if (kata_command(0, 0, ATA_CMD_FLUSH) != 0) {
+        return -1;
+    }
+
+    return kata_wait(ATA_SR_BSY, 0);
+}
+
+/**
+ * Ends the interrupt driven read and reports it to the block layer
+ * @param rc - -1 on error, 0 on success
+ */
+static void kata_complete(int rc) {
+    kata_req.active = 0;
+    kblock_done(&kata_dev, rc);
+}
+
+/**
+ * Starts an interrupt driven read; the drive raises IRQ 14 when a DMA
+ * read completes, or as each sector becomes ready for PIO
+ * @param dev - the disk
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory for count * BLOCK_SIZE bytes
+ * @return -1 on error, 0 if the read was started
+ */
+static int kata_start(kblock_dev_t *dev, int block, int count, void *buf) {
+    unsigned int sector = block * ATA_BLOCK_SECTORS;
+    int sectors = count * ATA_BLOCK_SECTORS;
+
+    if (sectors > ATA_MAX_SECTORS) {
+        return -1;
+    }
+
+    kata_req.sectors = sectors;
+    kata_req.buf = buf;
+
+    if (kata_read_mode == ATA_MODE_DMA && kata_dma_start(sector, sectors, buf) == 0) {
+        kata_req.mode = ATA_MODE_DMA;
+    } else if (kata_command(sector, sectors, ATA_CMD_READ) == 0) {
+        kata_req.mode = ATA_MODE_PIO;
+    } else {
+        return -1;
+    }
+
+    kata_req.active = 1;
+    return 0;
+}
+
+/**
+ * Polls the interrupt driven read in progress to its end
+ * @param dev - the disk
+ */
+static void kata_finish(kblock_dev_t *dev) {
+    if (!kata_req.active) {
+        kblock_done(dev, -1);
+        return;
+    }
+
+    if (kata_req.mode == ATA_MODE_DMA) {
+        kata_complete(kata_dma_wait());
+        return;
+    }
+
+    while (kata_req.sectors > 0) {
+        if (kata_wait(ATA_SR_DRQ, ATA_SR_DRQ) != 0) {
+            kata_complete(-1);
+            return;
+        }
+
+        kata_pio_in(kata_req.buf);
+        kata_req.buf += ATA_SECTOR_WORDS;
+        kata_req.sectors--;
+    }
+
+    kata_complete(0);
+}
+
+/**
+ * ATA IRQ handler
+ * Interrupts left over from reads that were polled to completion find
+ * the drive without data and are only acknowledged.
+ */
+void kata_irq_handler(void) {
+    int status;
+
+    if (kata_req.active && kata_req.mode == ATA_MODE_DMA) {
+        if (inportb(kata_bm + BM_STATUS) & (BM_STATUS_INTR | BM_STATUS_ERR)) {
+            kata_complete(kata_dma_end());
+        }
+        return;
+    }
+
+    // Reading the status acknowledges the interrupt
+    status = inportb(ATA_STATUS);
+
+    if (!kata_req.active || (status & ATA_SR_BSY)) {
+        return;
+    }
+
+    if (status & (ATA_SR_ERR | ATA_SR_DF)) {
+        kernel_log_warn("ata: read error, status 0x%02x, error 0x%02x", status, inportb(ATA_ERROR));
+        kata_complete(-1);
+        return;
+    }
+
+    if (!(status & ATA_SR_DRQ)) {
+        return;
+    }
+
+    kata_pio_in(kata_req.buf);
+    kata_req.buf += ATA_SECTOR_WORDS;
+
+    if (--kata_req.sectors == 0) {
+        kata_complete(0);
+    }
+}
+
+/**
+ * Reads a PCI configuration register
+ * @param bus - PCI bus
+ * @param slot - device number on the bus
+ * @param func - function number
+ * @param reg - register offset (dword aligned)
+ * @return the register value
+ */
+static unsigned int kata_pci_read(int bus, int slot, int func, int reg) {
+    outportl(PCI_CONFIG_ADDR, PCI_ENABLE | (bus << 16) | (slot << 11) | (func << 8) | reg);
+    return inportl(PCI_CONFIG_DATA);
+}
+
+/**
+ * Writes a PCI configuration register
+ * @param bus - PCI bus
+ * @param slot - device number on the bus
+ * @param func - function number
+ * @param reg - register offset (dword aligned)
+ * @param value - the value to write
+ */
+static void kata_pci_write(int bus, int slot, int func, int reg, unsigned int value) {
+    outportl(PCI_CONFIG_ADDR, PCI_ENABLE | (bus << 16) | (slot << 11) | (func << 8) | reg);
+    outportl(PCI_CONFIG_DATA, value);
+}
+
+/**
+ * Finds the IDE controller on PCI bus 0 and enables bus mastering
+ * @return 0 if there is no bus-master IDE controller, otherwise the base
+ *         of its bus-master registers
+ */
+static unsigned int kata_pci_find(void) {
+    unsigned int bar;
+    unsigned int cmd;
+
+    for (int slot = 0; slot < 32; slot++) {
+        for (int func = 0; func < 8; func++) {
+            if ((kata_pci_read(0, slot, func, PCI_REG_ID) & 0xffff) == 0xffff) {
+                continue;
+            }
+
+            if ((kata_pci_read(0, slot, func, PCI_REG_CLASS) >> 16) != PCI_CLASS_IDE) {
+                continue;
+            }
+
+            // BAR4 must be an I/O port range
+            bar = kata_pci_read(0, slot, func, PCI_REG_BAR4);
+            if (!(bar & 0x1)) {
+                continue;
+            }
+
+            cmd = kata_pci_read(0, slot, func, PCI_REG_COMMAND) & 0xffff;
+            kata_pci_write(0, slot, func, PCI_REG_COMMAND, cmd | PCI_CMD_IO | PCI_CMD_MASTER);
+
+            return bar & 0xfffc;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Reads the drive's identify data
+ * @param id - memory for ATA_SECTOR_WORDS words
+ * @return -1 if there is no ATA disk, 0 on success
+ */
+static int kata_identify(unsigned short *id) {
+    outportb(ATA_DRIVE, ATA_DRIVE_MASTER);
+    kata_delay();
+
+    // A floating bus reads as all ones
+    if (inportb(ATA_STATUS) == 0xff) {
+        return -1;
+    }
+
+    outportb(ATA_SECCOUNT, 0);
+    outportb(ATA_LBA_LO, 0);
+    outportb(ATA_LBA_MID, 0);
+    outportb(ATA_LBA_HI, 0);
+    outportb(ATA_COMMAND, ATA_CMD_IDENTIFY);
+    kata_delay();
+
+    if (inportb(ATA_STATUS) == 0) {
+        return -1;
+    }
+
+    if (kata_wait(ATA_SR_BSY, 0) != 0) {
+        return -1;
+    }
+
+    // ATAPI and SATA devices report a signature instead
+    if (inportb(ATA_LBA_MID) || inportb(ATA_LBA_HI)) {
+        return -1;
+    }
+
+    if (kata_wait(ATA_SR_DRQ, ATA_SR_DRQ) != 0) {
+        return -1;
+    }
+
+    kata_pio_in(id);
+    return 0;
+}
+
+/**
+ * Detects the disk and registers it as a block device
+ * @return -1 if there is no disk, otherwise the block device id
+ */
+int kata_init(void) {
+    unsigned short id[ATA_SECTOR_WORDS];
+    unsigned int sectors;
+
+    kernel_log_info("Initializing ATA disk");
+
+    memset(&kata_req, 0, sizeof(kata_req));
+
+    if (kata_identify(id) != 0) {
+        kernel_log_info("ata: no disk found");
+        return -1;
+    }
+
+    sectors = id[ATA_ID_SECTORS] | ((unsigned int)id[ATA_ID_SECTORS + 1] << 16);
+
+    kata_bm = kata_pci_find();
+    kata_prd = kata_bm ? kpage_alloc() : NULL;
+    kata_dma_ok = (kata_prd && (id[ATA_ID_CAPS] & ATA_ID_CAPS_DMA)) ? 1 : 0;
+    kata_read_mode = kata_dma_ok ? ATA_MODE_DMA : ATA_MODE_PIO;
+
+    kernel_log_info("ata: %d sectors, %s reads", sectors, kata_dma_ok ? "DMA" : "PIO");
+
+    memset(&kata_dev, 0, sizeof(kata_dev));
+    kata_dev.name = ATA_NAME;
+    kata_dev.blocks = sectors / ATA_BLOCK_SECTORS;
+    kata_dev.read = kata_read;
+    kata_dev.write = kata_write;
+    kata_dev.start = kata_start;
+    kata_dev.finish = kata_finish;
+
+    interrupts_irq_register(IRQ_ATA, isr_entry_ata, kata_irq_handler);
+
+    return kblock_register(&kata_dev);
+}
+
+/**
+ * Selects the transfer mode used for reads
+ * @param mode - ATA_MODE_PIO or ATA_MODE_DMA
+ * @return -1 if the mode is not available, 0 on success
+ */
+int kata_mode(int mode) {
+    if (mode == ATA_MODE_DMA && !kata_dma_ok) {
+        return -1;
+    }
+
+    if (mode != ATA_MODE_PIO && mode != ATA_MODE_DMA) {
+        return -1;
+    }
+
+    kblock_finish(kata_dev.id);
+    kata_read_mode = mode;
+    return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Block Devices
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kblock.h"
+
+// Registered block devices, indexed by device id
+kblock_dev_t *block_devs[BLOCK_DEV_MAX];
+
+/**
+ * Initializes the block device table
+ */
+void kblock_init(void) {
+    kernel_log_info("Initializing block devices");
+
+    memset(block_devs, 0, sizeof(block_devs));
+}
+
+/**
+ * Registers a block device
+ * @param dev - the device (must remain valid while registered)
+ * @return -1 on error, otherwise the device id
+ */
+int kblock_register(kblock_dev_t *dev) {
+    if (!dev || !dev->name || !dev->read || dev->blocks <= 0 || (dev->start && !dev->finish)) {
+        return -1;
+    }
+
+    for (int id = 0; id < BLOCK_DEV_MAX; id++) {
+        if (!block_devs[id]) {
+            block_devs[id] = dev;
+            dev->id = id;
+            dev->busy = 0;
+            dev->done = NULL;
+
+            kernel_log_info("Block device %s (%d): %d blocks of %d bytes",
+                            dev->name, id, dev->blocks, BLOCK_SIZE);
+            return id;
+        }
+    }
+
+    kernel_log_warn("Unable to register block device %s", dev->name);
+    return -1;
+}
+
+/**
+ * Looks up a block device by name
+ * @param name - device name
+ * @return -1 if not found, otherwise the device id
+ */
+int kblock_find(char *name) {
+    if (!name) {
+        return -1;
+    }
+
+    for (int id = 0; id < BLOCK_DEV_MAX; id++) {
+        if (block_devs[id] && strcmp(block_devs[id]->name, name) == 0) {
+            return id;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Returns a registered block device
+ * @param id - device id
+ * @return NULL if not registered, otherwise the device
+ */
+kblock_dev_t *kblock_get(int id) {
+    if (id < 0 || id >= BLOCK_DEV_MAX) {
+        return NULL;
+    }
+
+    return block_devs[id];
+}
+
+/**
+ * Reads consecutive blocks from a device
+ * @param id - device id
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory for count * BLOCK_SIZE bytes
+ * @return -1 on error, 0 on success
+ */
+int kblock_read(int id, int block, int count, void *buf) {
+    kblock_dev_t *dev = kblock_get(id);
+
+    if (!dev || !buf || block < 0 || count <= 0 || count > dev->blocks - block) {
+        return -1;
+    }
+
+    kblock_finish(id);
+
+    dev->reads++;
+    dev->blocks_read += count;
+
+    return dev->read(dev, block, count, buf);
+}
+
+/**
+ * Writes consecutive blocks to a device
+ * @param id - device id
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory holding count * BLOCK_SIZE bytes
+ * @return -1 on error, 0 on success
+ */
+int kblock_write(int id, int block, int count, void *buf) {
+    kblock_dev_t *dev = kblock_get(id);
+
+    if (!dev || !dev->write || !buf || block < 0 || count <= 0 || count > dev->blocks - block) {
+        return -1;
+    }
+
+    kblock_finish(id);
+
+    dev->writes++;
+    dev->blocks_written += count;
+
+    return dev->write(dev, block, count, buf);
+}
+
+/**
+ * Starts an interrupt driven read of consecutive blocks
+ * @param id - device id
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory for count * BLOCK_SIZE bytes
+ * @param done - called with the device id and result once the read completes
+ * @return -1 if the read could not be started, 0 if it was started
+ */
+int kblock_start(int id, int block, int count, void *buf, void (*done)(int id, int rc)) {
+    kblock_dev_t *dev = kblock_get(id);
+
+    if (!dev || !dev->start || dev->busy || !buf || !done ||
+        block < 0 || count <= 0 || count > dev->blocks - block) {
+        return -1;
+    }
+
+    dev->busy = 1;
+    dev->done = done;
+
+    if (dev->start(dev, block, count, buf) != 0) {
+        dev->busy = 0;
+        dev->done = NULL;
+        return -1;
+    }
+
+    dev->reads++;
+    dev->blocks_read += count;
+    return 0;
+}
+
+/**
+ * Waits until no interrupt driven read is in progress on the device
+ * @param id - device id
+ */
+void kblock_finish(int id) {
+    kblock_dev_t *dev = kblock_get(id);
+
+    // Completion callbacks may start further reads
+    while (dev && dev->busy) {
+        dev->finish(dev);
+    }
+}
+
+/**
+ * Reports the end of an interrupt driven read; called by drivers
+ * @param dev - the device
+ * @param rc - -1 on error, 0 on success
+ */
+void kblock_done(kblock_dev_t *dev, int rc) {
+    void (*done)(int id, int rc);
+
+    if (!dev || !dev->busy) {
+        return;
+    }
+
+    // The callback may start the next read
+    done = dev->done;
+    dev->busy = 0;
+    dev->done = NULL;
+
+    done(dev->id, rc);
+}
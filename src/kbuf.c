@@ -0,0 +1,535 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Buffer Cache
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kblock.h"
+#include "kbuf.h"
+#include "kpage.h"
+#include "kproc.h"
+#include "queue.h"
+#include "scheduler.h"
+
+#if (KBUF_HASH_SIZE & (KBUF_HASH_SIZE - 1)) != 0
+#error "KBUF_HASH_SIZE must be a power of two"
+#endif
+
+kbuf_t kbufs[KBUF_COUNT];
+kbuf_t *kbuf_hash[KBUF_HASH_SIZE];
+
+// Least recently used list: head is the most recently used buffer
+kbuf_t *kbuf_lru_head;
+kbuf_t *kbuf_lru_tail;
+
+// Last block requested from each device, to detect sequential reads
+int kbuf_last_block[BLOCK_DEV_MAX];
+
+kbuf_stats_t kbuf_counters;
+
+// Background reads: the buffer being read on each device, processes
+// waiting for it, and the blocks still to be read ahead
+kbuf_t *kbuf_inflight[BLOCK_DEV_MAX];
+queue_t kbuf_waiters[BLOCK_DEV_MAX];
+int kbuf_ahead_next[BLOCK_DEV_MAX];
+int kbuf_ahead_left[BLOCK_DEV_MAX];
+
+/**
+ * Returns the hash bucket of a block
+ * @param dev - block device id
+ * @param block - block number
+ * @return the bucket
+ */
+static kbuf_t **kbuf_bucket(int dev, int block) {
+    return &kbuf_hash[(block * 31 + dev) & (KBUF_HASH_SIZE - 1)];
+}
+
+/**
+ * Finds the cached buffer of a block
+ * @param dev - block device id
+ * @param block - block number
+ * @return NULL if not cached, otherwise the buffer
+ */
+static kbuf_t *kbuf_lookup(int dev, int block) {
+    kbuf_t *buf = *kbuf_bucket(dev, block);
+
+    while (buf) {
+        if (buf->dev == dev && buf->block == block) {
+            return buf;
+        }
+
+        buf = buf->hash_next;
+    }
+
+    return NULL;
+}
+
+/**
+ * Removes a buffer from its hash bucket
+ * @param buf - the buffer
+ */
+static void kbuf_unhash(kbuf_t *buf) {
+    kbuf_t **link = kbuf_bucket(buf->dev, buf->block);
+
+    while (*link) {
+        if (*link == buf) {
+            *link = buf->hash_next;
+            break;
+        }
+
+        link = &(*link)->hash_next;
+    }
+
+    buf->hash_next = NULL;
+}
+
+/**
+ * Moves a buffer to the most recently used end of the LRU list
+ * @param buf - the buffer
+ */
+static void kbuf_touch(kbuf_t *buf) {
+    if (kbuf_lru_head == buf) {
+        return;
+    }
+
+    // Unlink
+    buf->lru_prev->lru_next = buf->lru_next;
+    if (buf->lru_next) {
+        buf->lru_next->lru_prev = buf->lru_prev;
+    } else {
+        kbuf_lru_tail = buf->lru_prev;
+    }
+
+    // Link at the head
+    buf->lru_prev = NULL;
+    buf->lru_next = kbuf_lru_head;
+    kbuf_lru_head->lru_prev = buf;
+    kbuf_lru_head = buf;
+}
+
+/**
+ * Writes a dirty buffer back to its device
+ * @param buf - the buffer
+ * @return -1 on error, 0 on success
+ */
+static int kbuf_write_back(kbuf_t *buf) {
+    if (!(buf->flags & KBUF_DIRTY)) {
+        return 0;
+    }
+
+    if (kblock_write(buf->dev, buf->block, 1, buf->data) != 0) {
+        kernel_log_warn("kbuf: unable to write block %d of device %d", buf->block, buf->dev);
+        return -1;
+    }
+
+    buf->flags &= ~KBUF_DIRTY;
+    kbuf_counters.write_backs++;
+    return 0;
+}
+
+/**
+ * Assigns the least recently used free buffer to a block; the buffer
+ * becomes the most recently used and holds no data yet
+ * @param dev - block device id
+ * @param block - block number (not cached)
+ * @return NULL if every buffer is held, otherwise the buffer
+ */
+static kbuf_t *kbuf_claim(int dev, int block) {
+    kbuf_t *buf = kbuf_lru_tail;
+
+    while (buf && (buf->refs > 0 || kbuf_write_back(buf) != 0)) {
+        buf = buf->lru_prev;
+    }
+
+    if (!buf) {
+        return NULL;
+    }
+
+    if (buf->flags & KBUF_VALID) {
+        kbuf_counters.evictions++;
+    }
+
+    kbuf_unhash(buf);
+    buf->flags = 0;
+    buf->dev = dev;
+    buf->block = block;
+
+    buf->hash_next = *kbuf_bucket(dev, block);
+    *kbuf_bucket(dev, block) = buf;
+    kbuf_touch(buf);
+
+    return buf;
+}
+
+/**
+ * Returns a claimed buffer whose read failed to the free buffers
+ * @param buf - the buffer
+ */
+static void kbuf_discard(kbuf_t *buf) {
+    kbuf_unhash(buf);
+    buf->flags = 0;
+    buf->dev = -1;
+}
+
+/**
+ * Loads a block into the least recently used free buffer, which becomes
+ * the most recently used
+ * @param dev - block device id
+ * @param block - block number (not cached)
+ * @return NULL if every buffer is held or the read failed, otherwise the
+ *         buffer
+ */
+static kbuf_t *kbuf_fill(int dev, int block) {
+    kbuf_t *buf = kbuf_claim(dev, block);
+    int rc;
+
+    if (!buf) {
+        return NULL;
+    }
+
+    // Hold the buffer while reading; completion callbacks of background
+    // reads run when the device is drained and may claim buffers
+    buf->refs++;
+    rc = kblock_read(dev, block, 1, buf->data);
+    buf->refs--;
+
+    if (rc != 0) {
+        kbuf_discard(buf);
+        return NULL;
+    }
+
+    buf->flags = KBUF_VALID;
+    return buf;
+}
+
+static void kbuf_done(int dev, int rc);
+
+/**
+ * Starts a background read of a block into a free buffer
+ * The buffer is held until the read completes.
+ * @param dev - block device id (not busy)
+ * @param block - block number (not cached)
+ * @param flags - flags added once the read completes
+ * @return -1 on error, 0 if the read was started
+ */
+static int kbuf_start(int dev, int block, int flags) {
+    kbuf_t *buf = kbuf_claim(dev, block);
+
+    if (!buf) {
+        return -1;
+    }
+
+    buf->flags = KBUF_BUSY | flags;
+    buf->refs++;
+    kbuf_inflight[dev] = buf;
+
+    if (kblock_start(dev, block, 1, buf->data, kbuf_done) != 0) {
+        kbuf_inflight[dev] = NULL;
+        buf->refs--;
+        kbuf_discard(buf);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Starts the background read of the next block to read ahead, if any
+ * @param dev - block device id (not busy)
+ */
+static void kbuf_ahead_step(int dev) {
+    kblock_dev_t *device = kblock_get(dev);
+    int block;
+
+    while (kbuf_ahead_left[dev] > 0 && kbuf_ahead_next[dev] < device->blocks) {
+        block = kbuf_ahead_next[dev]++;
+        kbuf_ahead_left[dev]--;
+
+        if (kbuf_lookup(dev, block)) {
+            continue;
+        }
+
+        if (kbuf_start(dev, block, KBUF_AHEAD) == 0) {
+            kbuf_counters.read_ahead++;
+        }
+        return;
+    }
+
+    kbuf_ahead_left[dev] = 0;
+}
+
+/**
+ * Completes a background read; called through kblock_done
+ * Waiting processes are rescheduled and the next read ahead is started.
+ * @param dev - block device id
+ * @param rc - -1 on error, 0 on success
+ */
+static void kbuf_done(int dev, int rc) {
+    kbuf_t *buf = kbuf_inflight[dev];
+    proc_t *proc;
+    int pid;
+
+    kbuf_inflight[dev] = NULL;
+
+    if (buf) {
+        buf->refs--;
+
+        if (rc == 0) {
+            buf->flags = (buf->flags & ~KBUF_BUSY) | KBUF_VALID;
+        } else {
+            kernel_log_warn("kbuf: unable to read block %d of device %d", buf->block, dev);
+            kbuf_discard(buf);
+        }
+    }
+
+    while (queue_out(&kbuf_waiters[dev], &pid) == 0) {
+        proc = pid_to_proc(pid);
+
+        if (proc && proc->state == WAITING) {
+            scheduler_add(proc);
+        }
+    }
+
+    kbuf_ahead_step(dev);
+}
+
+/**
+ * Reads the blocks following a sequential reader into the cache
+ * @param dev - block device id
+ * @param block - block the reader just requested
+ */
+static void kbuf_read_ahead(int dev, int block) {
+    kblock_dev_t *device = kblock_get(dev);
+    kbuf_t *buf;
+
+    for (int i = 1; i <= KBUF_READ_AHEAD && block + i < device->blocks; i++) {
+        if (kbuf_lookup(dev, block + i)) {
+            continue;
+        }
+
+        buf = kbuf_fill(dev, block + i);
+        if (!buf) {
+            return;
+        }
+
+        buf->flags |= KBUF_AHEAD;
+        kbuf_counters.read_ahead++;
+    }
+}
+
+/**
+ * Initializes the buffer cache
+ */
+void kbuf_init(void) {
+    unsigned char *mem;
+
+    kernel_log_info("Initializing buffer cache: %d blocks", KBUF_COUNT);
+
+    mem = kpage_alloc_contig(KBUF_COUNT * BLOCK_SIZE / KPAGE_SIZE);
+    if (!mem) {
+        kernel_panic("Unable to allocate the buffer cache");
+        return;
+    }
+
+    memset(kbuf_hash, 0, sizeof(kbuf_hash));
+    memset(&kbuf_counters, 0, sizeof(kbuf_counters));
+
+    memset(kbuf_inflight, 0, sizeof(kbuf_inflight));
+    memset(kbuf_waiters, 0, sizeof(kbuf_waiters));
+    memset(kbuf_ahead_left, 0, sizeof(kbuf_ahead_left));
+
+    for (int i = 0; i < BLOCK_DEV_MAX; i++) {
+        kbuf_last_block[i] = -1;
+    }
+
+    for (int i = 0; i < KBUF_COUNT; i++) {
+        memset(&kbufs[i], 0, sizeof(kbuf_t));
+        kbufs[i].dev = -1;
+        kbufs[i].data = mem + i * BLOCK_SIZE;
+        kbufs[i].lru_prev = (i > 0) ? &kbufs[i - 1] : NULL;
+        kbufs[i].lru_next = (i < KBUF_COUNT - 1) ? &kbufs[i + 1] : NULL;
+    }
+
+    kbuf_lru_head = &kbufs[0];
+    kbuf_lru_tail = &kbufs[KBUF_COUNT - 1];
+}
+
+/**
+ * Obtains the buffer holding a block, reading it if it is not cached
+ * @param dev - block device id
+ * @param block - block number
+ * @return NULL on error, otherwise the buffer
+ */
+kbuf_t *kbuf_get(int dev, int block) {
+    kblock_dev_t *device = kblock_get(dev);
+    kbuf_t *buf;
+
+    if (!device || block < 0 || block >= device->blocks) {
+        return NULL;
+    }
+
+    buf = kbuf_lookup(dev, block);
+
+    // A background read of the block must finish first
+    if (buf && (buf->flags & KBUF_BUSY)) {
+        kblock_finish(dev);
+        buf = kbuf_lookup(dev, block);
+    }
+
+    if (buf) {
+        kbuf_counters.hits++;
+
+        if (buf->flags & KBUF_AHEAD) {
+            buf->flags &= ~KBUF_AHEAD;
+            kbuf_counters.read_ahead_hits++;
+        }
+    } else {
+        buf = kbuf_fill(dev, block);
+        if (!buf) {
+            return NULL;
+        }
+
+        kbuf_counters.misses++;
+    }
+
+    buf->refs++;
+    kbuf_touch(buf);
+
+    if (block == kbuf_last_block[dev] + 1) {
+        if (device->start) {
+            kbuf_ahead_next[dev] = block + 1;
+            kbuf_ahead_left[dev] = KBUF_READ_AHEAD;
+
+            if (!device->busy) {
+                kbuf_ahead_step(dev);
+            }
+        } else {
+            kbuf_read_ahead(dev, block);
+        }
+    }
+
+    kbuf_last_block[dev] = block;
+
+    return buf;
+}
+
+/**
+ * Obtains the buffer holding a block without waiting on an interrupt
+ * driven device; other devices are read as with kbuf_get
+ * @param dev - block device id
+ * @param block - block number
+ * @param buf - set to the held buffer on success
+ * @return -1 on error, KBUF_PENDING if the block is not yet available,
+ *         0 on success
+ */
+int kbuf_try(int dev, int block, kbuf_t **buf) {
+    kblock_dev_t *device = kblock_get(dev);
+    kbuf_t *cached;
+
+    if (!device || !buf || block < 0 || block >= device->blocks) {
+        return -1;
+    }
+
+    cached = kbuf_lookup(dev, block);
+
+    if (device->start && (!cached || (cached->flags & KBUF_BUSY))) {
+        // Wait for the block, or for the device to read something else
+        if (cached || device->busy) {
+            return KBUF_PENDING;
+        }
+
+        if (kbuf_start(dev, block, 0) != 0) {
+            return -1;
+        }
+
+        kbuf_counters.misses++;
+
+        // Keep a sequential reader's next blocks coming
+        if (block == kbuf_last_block[dev] + 1) {
+            kbuf_ahead_next[dev] = block + 1;
+            kbuf_ahead_left[dev] = KBUF_READ_AHEAD;
+        }
+
+        kbuf_last_block[dev] = block;
+        return KBUF_PENDING;
+    }
+
+    *buf = kbuf_get(dev, block);
+    return *buf ? 0 : -1;
+}
+
+/**
+ * Blocks the active process until the device's background read completes
+ * @param dev - block device id
+ * @return -1 if no read is in progress or the process could not be
+ *         queued, 0 on success
+ */
+int kbuf_wait(int dev) {
+    kblock_dev_t *device = kblock_get(dev);
+
+    if (!device || !device->busy || !active_proc) {
+        return -1;
+    }
+
+    if (queue_in(&kbuf_waiters[dev], active_proc->pid) != 0) {
+        return -1;
+    }
+
+    active_proc->state = WAITING;
+    scheduler_remove(active_proc);
+    return 0;
+}
+
+/**
+ * Releases a buffer obtained with kbuf_get
+ * @param buf - the buffer
+ */
+void kbuf_put(kbuf_t *buf) {
+    if (!buf || buf->refs <= 0) {
+        kernel_log_warn("kbuf: release of a buffer that is not held");
+        return;
+    }
+
+    buf->refs--;
+}
+
+/**
+ * Marks a held buffer as modified so that it is written back
+ * @param buf - the buffer
+ */
+void kbuf_dirty(kbuf_t *buf) {
+    if (buf && (buf->flags & KBUF_VALID)) {
+        buf->flags |= KBUF_DIRTY;
+    }
+}
+
+/**
+ * Writes back every modified buffer
+ * @return -1 if any write failed, 0 on success
+ */
+int kbuf_sync(void) {
+    int rc = 0;
+
+    for (int i = 0; i < KBUF_COUNT; i++) {
+        if (kbuf_write_back(&kbufs[i]) != 0) {
+            rc = -1;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Fills in the buffer cache statistics
+ * @param stats - pointer to the statistics to fill in
+ */
+void kbuf_stats(kbuf_stats_t *stats) {
+    if (stats) {
+        *stats = kbuf_counters;
+    }
+}
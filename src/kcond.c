@@ -0,0 +1,201 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Condition Variables
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kcond.h"
+#include "kmutex.h"
+#include "queue.h"
+#include "scheduler.h"
+
+// Table of all condition variables
+cond_t conds[COND_MAX];
+
+// Condition variable ids to be allocated
+queue_t cond_queue;
+
+/**
+ * Initializes kernel condition variable data structures
+ * @return -1 on error, 0 on success
+ */
+int kconds_init(void) {
+    kernel_log_info("Initializing kernel condition variables");
+
+    // Initialize the condition table
+    memset(&conds, 0, sizeof(conds));
+
+    // Initialize and fill the condition queue
+    queue_init(&cond_queue);
+    for (int i = 0; i < COND_MAX; i++) {
+        if (queue_in(&cond_queue, i) != 0) {
+            kernel_log_warn("cond: unable to queue condition %d", i);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Looks up an allocated condition in the condition table
+ * @param id - the condition id
+ * @return NULL on error, otherwise the condition table entry
+ */
+static cond_t *kcond_get(int id) {
+    if (id >= COND_MAX || id < 0) {
+        return NULL;
+    }
+
+    if (!conds[id].allocated) {
+        return NULL;
+    }
+
+    return &conds[id];
+}
+
+/**
+ * Allocates a condition variable bound to a mutex
+ * @param mutex - the mutex id that protects the condition
+ * @return -1 on error, otherwise the condition id that was allocated
+ */
+int kcond_init(int mutex) {
+    int id = -1;
+
+    if (mutex >= MUTEX_MAX || mutex < 0) {
+        return -1;
+    }
+
+    // Obtain a condition id from the condition queue
+    if (queue_out(&cond_queue, &id) != 0) {
+        return -1;
+    }
+
+    cond_t *cond = &conds[id];
+
+    memset(cond, 0, sizeof(cond_t));
+    cond->allocated = 1;
+    cond->mutex = mutex;
+
+    return id;
+}
+
+/**
+ * Frees the specified condition variable
+ * @param id - the condition id
+ * @return 0 on success, -1 on error
+ */
+int kcond_destroy(int id) {
+    cond_t *cond = kcond_get(id);
+
+    if (!cond) {
+        return -1;
+    }
+
+    // Prevent a condition with waiters from being destroyed
+    if (cond->wait_queue.size > 0) {
+        return -1;
+    }
+
+    memset(cond, 0, sizeof(cond_t));
+
+    // Add the id back into the condition queue to be re-used later
+    queue_in(&cond_queue, id);
+
+    return 0;
+}
+
+/**
+ * Releases the bound mutex and waits for the condition to be signaled
+ * @param id - the condition id
+ * @return -1 on error, 0 on success
+ */
+int kcond_wait(int id) {
+    cond_t *cond = kcond_get(id);
+    proc_t *proc = active_proc;
+
+    if (!cond) {
+        return -1;
+    }
+
+    // The caller must hold the bound mutex
+    if (kmutex_owner(cond->mutex) != proc) {
+        return -1;
+    }
+
+    if (queue_in(&cond->wait_queue, proc->pid) != 0) {
+        return -1;
+    }
+
+    // Release the mutex (possibly handing it to another waiter) and
+    // remove the process from the scheduler until it is signaled
+    kmutex_unlock(cond->mutex);
+
+    proc->state = WAITING;
+    scheduler_remove(proc);
+
+    return 0;
+}
+
+/**
+ * Moves one waiting process from the condition over to the bound mutex
+ * @param cond - pointer to the condition table entry
+ * @return 0 if no process was waiting, 1 if a process was woken
+ */
+static int kcond_wake(cond_t *cond) {
+    int pid;
+    proc_t *proc;
+
+    if (queue_out(&cond->wait_queue, &pid) != 0) {
+        return 0;
+    }
+
+    proc = pid_to_proc(pid);
+    if (!proc) {
+        kernel_log_warn("cond: unable to look up process id %d", pid);
+        return 0;
+    }
+
+    // The process is scheduled once it re-acquires the mutex
+    kmutex_lock_proc(cond->mutex, proc);
+    return 1;
+}
+
+/**
+ * Wakes one process waiting on the condition
+ * @param id - the condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int kcond_signal(int id) {
+    cond_t *cond = kcond_get(id);
+
+    if (!cond) {
+        return -1;
+    }
+
+    return kcond_wake(cond);
+}
+
+/**
+ * Wakes all processes waiting on the condition
+ * @param id - the condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int kcond_broadcast(int id) {
+    cond_t *cond = kcond_get(id);
+    int count = 0;
+
+    if (!cond) {
+        return -1;
+    }
+
+    while (cond->wait_queue.size > 0) {
+        count += kcond_wake(cond);
+    }
+
+    return count;
+}
@@ -0,0 +1,160 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel ELF Loader
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kelf.h"
+#include "kpage.h"
+#include "kpaging.h"
+#include "kproc.h"
+
+#define KELF_PAGE_DOWN(addr) ((addr) & ~(KPAGE_SIZE - 1))
+#define KELF_PAGE_UP(addr)   (((addr) + KPAGE_SIZE - 1) & ~(KPAGE_SIZE - 1))
+
+// Program image table, generated from the user/ directory at build time
+// and terminated by an entry with no name
+extern kelf_image_t kelf_images[];
+
+/**
+ * Looks up a program image by name
+ * @param name - program name
+ * @return NULL if not found, otherwise the image table entry
+ */
+kelf_image_t *kelf_find(char *name) {
+    if (!name) {
+        return NULL;
+    }
+
+    for (int i = 0; kelf_images[i].name; i++) {
+        if (strncmp(kelf_images[i].name, name, PROC_NAME_LEN) == 0) {
+            return &kelf_images[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Loads one segment into a process' private memory
+ * @param proc - the process to load into
+ * @param data - ELF file contents
+ * @param phdr - the segment's program header (already validated)
+ * @return -1 if memory is exhausted, 0 on success
+ */
+static int kelf_load_segment(proc_t *proc, unsigned char *data, elf_phdr_t *phdr) {
+    int flags = (phdr->flags & ELF_PF_W) ? PAGE_WRITE : 0;
+    unsigned int file_end = phdr->vaddr + phdr->filesz;
+    unsigned int mem_end = KELF_PAGE_UP(phdr->vaddr + phdr->memsz);
+    unsigned int page = KELF_PAGE_DOWN(phdr->vaddr);
+    unsigned int from;
+    unsigned int to;
+    unsigned int *pte;
+
+    // Pages holding file contents are copied now; the rest of the last one
+    // is already zero
+    for (; page < file_end; page += KPAGE_SIZE) {
+        pte = kpaging_pte(proc, page, 0);
+
+        // Adjacent segments may share a page
+        if (!pte || !(*pte & PAGE_PRESENT)) {
+            if (kpaging_map(proc, page, 1, flags) != 0) {
+                return -1;
+            }
+
+            pte = kpaging_pte(proc, page, 0);
+        }
+
+        *pte |= flags;
+
+        from = (page > phdr->vaddr) ? page : phdr->vaddr;
+        to = (page + KPAGE_SIZE < file_end) ? page + KPAGE_SIZE : file_end;
+
+        memcpy((unsigned char *)(*pte & PAGE_FRAME_MASK) + (from - page),
+               data + phdr->offset + (from - phdr->vaddr), to - from);
+    }
+
+    if (page >= mem_end) {
+        return 0;
+    }
+
+    // Pages that only hold BSS are zero filled on first touch; a process
+    // has a single such region, so any other segment's BSS is mapped now
+    if (!proc->zero_end) {
+        proc->zero_start = page;
+        proc->zero_end = mem_end;
+        return 0;
+    }
+
+    return kpaging_map(proc, page, (mem_end - page) / KPAGE_SIZE, flags);
+}
+
+/**
+ * Loads an ELF executable into a process' private memory
+ * @param proc - the process to load into
+ * @param data - ELF file contents
+ * @param size - ELF file size in bytes
+ * @param entry - set to the entry point address
+ * @return -1 if the image is not a valid executable or memory is
+ *         exhausted, 0 on success
+ */
+int kelf_load(proc_t *proc, unsigned char *data, int size, unsigned int *entry) {
+    elf_header_t *header = (elf_header_t *)data;
+    elf_phdr_t *phdr;
+
+    if (!proc || !data || !entry || size < (int)sizeof(elf_header_t)) {
+        return -1;
+    }
+
+    if (header->magic != ELF_MAGIC ||
+        header->ident[0] != ELF_CLASS_32 ||
+        header->ident[1] != ELF_DATA_LSB ||
+        header->type != ELF_TYPE_EXEC ||
+        header->machine != ELF_MACHINE_386 ||
+        header->phentsize != sizeof(elf_phdr_t)) {
+        kernel_log_warn("elf: not an i386 executable");
+        return -1;
+    }
+
+    if (header->phoff > (unsigned int)size ||
+        header->phnum > ((unsigned int)size - header->phoff) / sizeof(elf_phdr_t)) {
+        kernel_log_warn("elf: program headers out of bounds");
+        return -1;
+    }
+
+    if (header->entry < KPAGING_PRIVATE_START || header->entry >= KPAGING_STACK_START) {
+        kernel_log_warn("elf: entry 0x%x outside private memory", header->entry);
+        return -1;
+    }
+
+    for (int i = 0; i < header->phnum; i++) {
+        phdr = (elf_phdr_t *)(data + header->phoff) + i;
+
+        if (phdr->type != ELF_PT_LOAD || phdr->memsz == 0) {
+            continue;
+        }
+
+        if (phdr->offset > (unsigned int)size ||
+            phdr->filesz > (unsigned int)size - phdr->offset ||
+            phdr->filesz > phdr->memsz ||
+            phdr->vaddr < KPAGING_PRIVATE_START ||
+            phdr->vaddr >= KPAGING_STACK_START ||
+            phdr->memsz > KPAGING_STACK_START - phdr->vaddr) {
+            kernel_log_warn("elf: segment %d at 0x%x out of bounds", i, phdr->vaddr);
+            return -1;
+        }
+
+        if (kelf_load_segment(proc, data, phdr) != 0) {
+            kernel_log_warn("elf: unable to map segment %d at 0x%x", i, phdr->vaddr);
+            return -1;
+        }
+    }
+
+    *entry = header->entry;
+    return 0;
+}
@@ -12,6 +12,10 @@
 
 #include "interrupts.h"
 #include "kernel.h"
+#include "kfpu.h"
+#include "klat.h"
+#include "ktrace.h"
+#include "kpaging.h"
 #include "scheduler.h"
 #include "trapframe.h"
 #include "vga.h"
@@ -229,13 +233,33 @@ void kernel_exit(void) {
  * @param trapframe - pointer to the current process' trapframe
  */
 void kernel_context_enter(trapframe_t *trapframe) {
+    unsigned long long start = klat_rdtsc();
+    unsigned int cr3;
+
+    // The system call dispatcher replaces eax with the return value
+    int irq = trapframe->interrupt;
+    int syscall = trapframe->eax;
+    int killed = 0;
+
+    // The interrupted process may exit or block before the scheduler runs
+    int prev = active_proc ? active_proc->pid : -1;
+
+    ktrace_event(TRACE_IRQ_ENTER, prev, -1, irq);
+
     if (active_proc) {
-        // Save the currently running trapframe
-        active_proc->trapframe = trapframe;
+        // Save the currently running trapframe where the kernel can reach
+        // it whichever page directory is loaded
+        active_proc->trapframe = kproc_stack_to_kernel(active_proc, trapframe);
+
+        // Catch processes that have run off the base of their stack
+        killed = kproc_stack_check(active_proc, trapframe) != 0;
     }
 
-    // Process the interrupt that occurred
-    interrupts_irq_handler(trapframe->interrupt);
+    // Process the interrupt that occurred; an exception or system call
+    // raised by a process that was just killed is dropped
+    if (!killed || (irq >= IRQ_TIMER && irq != IRQ_SYSCALL)) {
+        interrupts_irq_handler(irq);
+    }
 
     // Run the scheduler
     scheduler_run();
@@ -244,6 +268,17 @@ void kernel_context_enter(trapframe_t *trapframe) {
         kernel_panic("No active process!");
     }
 
+    if (active_proc->pid != prev) {
+        if (prev >= 0) {
+            ktrace_event(TRACE_SWITCH_OUT, prev, active_proc->pid, irq);
+        }
+        ktrace_event(TRACE_SWITCH_IN, active_proc->pid, prev, irq);
+    }
+
     // Exit the kernel context
-    kernel_context_exit(active_proc->trapframe);
+    kfpu_switch(active_proc);
+    cr3 = kpaging_switch(active_proc);
+    klat_record(irq, syscall, start);
+    ktrace_event(TRACE_IRQ_EXIT, active_proc->pid, prev, irq);
+    kernel_context_exit(kproc_stack_to_proc(active_proc, active_proc->trapframe), cr3);
 }
@@ -441,7 +441,7 @@ unsigned int keyboard_decode(unsigned int c) {
                 }
 
                 if (c == 'n' || c == 'N') {
-                    kproc_create(kproc_test, "test", PROC_TYPE_USER);
+                    kproc_create(kproc_test, "test", PROC_TYPE_USER, STACK_CLASS_4K);
                     return KEY_NULL;
                 }
 
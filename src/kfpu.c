@@ -0,0 +1,263 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel FPU State
+ */
+
+#include <spede/string.h>
+
+#include "interrupts.h"
+#include "kernel.h"
+#include "kfpu.h"
+#include "kmalloc.h"
+#include "kproc.h"
+
+#define CR0_MP          0x00000002  // WAIT instructions honor CR0.TS
+#define CR0_EM          0x00000004  // Emulate the FPU (must be clear)
+#define CR0_TS          0x00000008  // Task switched: FPU use raises #NM
+#define CR4_OSFXSR      0x00000200  // FXSAVE/FXRSTOR and SSE enabled
+#define CR4_OSXMMEXCPT  0x00000400  // SSE exceptions raise #XM
+
+#define CPUID_FXSR      (1 << 24)
+#define CPUID_SSE       (1 << 25)
+
+#define MXCSR_DEFAULT   0x1f80      // All SSE exceptions masked
+
+// Process whose state is in the FPU registers (NULL if none)
+proc_t *kfpu_owner;
+
+int kfpu_fxsr;                      // FXSAVE/FXRSTOR are available
+int kfpu_ts;                        // CR0.TS is set
+
+// State loaded for a process' first FPU use (kmalloc objects are aligned
+// to their size, which meets the 16 byte alignment FXSAVE requires)
+unsigned char *kfpu_clean;
+
+fpu_stats_t kfpu_counters;
+
+/**
+ * Sets CR0.TS so that the next FPU instruction raises #NM
+ */
+static void kfpu_stts(void) {
+    unsigned int cr0;
+
+    asm volatile("movl %%cr0, %0" : "=r"(cr0));
+    asm volatile("movl %0, %%cr0" :: "r"(cr0 | CR0_TS));
+    kfpu_ts = 1;
+}
+
+/**
+ * Clears CR0.TS so that FPU instructions run
+ */
+static void kfpu_clts(void) {
+    asm volatile("clts");
+    kfpu_ts = 0;
+}
+
+/**
+ * Saves the FPU registers; FSAVE also reinitializes them
+ * @param state - FPU_STATE_SIZE bytes, 16 byte aligned
+ */
+static void kfpu_save(unsigned char *state) {
+    if (kfpu_fxsr) {
+        asm volatile("fxsave (%0)" :: "r"(state) : "memory");
+    } else {
+        asm volatile("fnsave (%0)" :: "r"(state) : "memory");
+    }
+
+    kfpu_counters.saves++;
+}
+
+/**
+ * Loads the FPU registers
+ * @param state - FPU_STATE_SIZE bytes, 16 byte aligned
+ */
+static void kfpu_restore(unsigned char *state) {
+    if (kfpu_fxsr) {
+        asm volatile("fxrstor (%0)" :: "r"(state));
+    } else {
+        asm volatile("frstor (%0)" :: "r"(state));
+    }
+
+    kfpu_counters.restores++;
+}
+
+/**
+ * Hands the FPU registers to a process, saving the current owner's
+ * @param proc - the new owner (NULL leaves the registers to the kernel)
+ * @return -1 if the process' state could not be allocated, 0 on success
+ */
+static int kfpu_take(proc_t *proc) {
+    kfpu_clts();
+
+    if (kfpu_owner == proc) {
+        return 0;
+    }
+
+    if (kfpu_owner) {
+        kfpu_save(kfpu_owner->fpu_state);
+        kfpu_owner = NULL;
+    }
+
+    if (!proc) {
+        asm volatile("fninit");
+        return 0;
+    }
+
+    if (!proc->fpu_state) {
+        proc->fpu_state = kmalloc(FPU_STATE_SIZE);
+        if (!proc->fpu_state) {
+            return -1;
+        }
+
+        memcpy(proc->fpu_state, kfpu_clean, FPU_STATE_SIZE);
+    }
+
+    kfpu_restore(proc->fpu_state);
+    kfpu_owner = proc;
+    return 0;
+}
+
+/**
+ * Enables the FPU (and SSE where supported) and registers the #NM handler
+ */
+void kfpu_init(void) {
+    unsigned int eax = 1;
+    unsigned int ebx;
+    unsigned int ecx;
+    unsigned int edx;
+    unsigned int cr0;
+    unsigned int cr4;
+    unsigned int mxcsr = MXCSR_DEFAULT;
+
+    kernel_log_info("Initializing FPU");
+
+    asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+    kfpu_fxsr = (edx & CPUID_FXSR) ? 1 : 0;
+
+    asm volatile("movl %%cr0, %0" : "=r"(cr0));
+    cr0 = (cr0 | CR0_MP) & ~(CR0_EM | CR0_TS);
+    asm volatile("movl %0, %%cr0" :: "r"(cr0));
+
+    if (kfpu_fxsr) {
+        asm volatile("movl %%cr4, %0" : "=r"(cr4));
+        cr4 |= CR4_OSFXSR;
+        if (edx & CPUID_SSE) {
+            cr4 |= CR4_OSXMMEXCPT;
+        }
+        asm volatile("movl %0, %%cr4" :: "r"(cr4));
+    }
+
+    kfpu_clean = kmalloc(FPU_STATE_SIZE);
+    if (!kfpu_clean) {
+        kernel_panic("Unable to allocate the FPU state");
+        return;
+    }
+
+    memset(kfpu_clean, 0, FPU_STATE_SIZE);
+    asm volatile("fninit");
+    if (kfpu_fxsr && (edx & CPUID_SSE)) {
+        asm volatile("ldmxcsr %0" :: "m"(mxcsr));
+    }
+    kfpu_save(kfpu_clean);
+
+    kfpu_owner = NULL;
+    memset(&kfpu_counters, 0, sizeof(kfpu_counters));
+
+    kernel_log_info("FPU state saved with %s%s", kfpu_fxsr ? "FXSAVE" : "FSAVE",
+                    (edx & CPUID_SSE) ? ", SSE enabled" : "");
+
+    interrupts_irq_register(IRQ_FPU, isr_entry_fpu, kfpu_trap);
+    kfpu_stts();
+}
+
+/**
+ * Sets CR0.TS unless the process about to run owns the FPU registers
+ * @param proc - the process about to run
+ */
+void kfpu_switch(proc_t *proc) {
+    if (proc == kfpu_owner) {
+        if (kfpu_ts) {
+            kfpu_clts();
+        }
+    } else if (!kfpu_ts) {
+        kfpu_stts();
+    }
+}
+
+/**
+ * #NM handler: hands the FPU registers to the active process
+ */
+void kfpu_trap(void) {
+    kfpu_counters.traps++;
+
+    if (!active_proc) {
+        return;
+    }
+
+    if (kfpu_take(active_proc) != 0) {
+        kernel_log_error("Unable to allocate the FPU state of process %s (%d)",
+                         active_proc->name, active_proc->pid);
+        kproc_destroy(active_proc);
+    }
+}
+
+/**
+ * #NM handler for the kernel context
+ */
+void kfpu_trap_kernel(void) {
+    kfpu_counters.traps++;
+    kfpu_take(NULL);
+}
+
+/**
+ * Copies a process' FPU state to a new process created by fork
+ * @param parent - the process being copied
+ * @param child - the new process
+ * @return -1 if out of memory, 0 on success
+ */
+int kfpu_fork(proc_t *parent, proc_t *child) {
+    if (!parent->fpu_state) {
+        return 0;
+    }
+
+    child->fpu_state = kmalloc(FPU_STATE_SIZE);
+    if (!child->fpu_state) {
+        return -1;
+    }
+
+    // The owner's latest state is still in the registers
+    if (kfpu_owner == parent) {
+        kfpu_clts();
+        kfpu_save(parent->fpu_state);
+        kfpu_restore(parent->fpu_state);
+    }
+
+    memcpy(child->fpu_state, parent->fpu_state, FPU_STATE_SIZE);
+    return 0;
+}
+
+/**
+ * Drops a process' FPU state; its next FPU use starts from a clean state
+ * @param proc - the process
+ */
+void kfpu_release(proc_t *proc) {
+    if (kfpu_owner == proc) {
+        kfpu_owner = NULL;
+    }
+
+    kfree(proc->fpu_state);
+    proc->fpu_state = NULL;
+}
+
+/**
+ * Fills in the FPU switching statistics
+ * @param stats - pointer to the statistics to fill in
+ */
+void kfpu_stats(fpu_stats_t *stats) {
+    if (stats) {
+        *stats = kfpu_counters;
+    }
+}
@@ -0,0 +1,315 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Filesystem
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kblock.h"
+#include "kbuf.h"
+#include "kfs.h"
+#include "kproc.h"
+#include "ksyscall.h"
+#include "syscall_common.h"
+
+#define FS_DIRENTS_PER_BLOCK (BLOCK_SIZE / sizeof(fs_dirent_t))
+
+// Mounted filesystem
+int fs_dev = -1;
+fs_super_t fs_super;
+
+// Open files
+fs_file_t fs_files[FS_FILE_MAX];
+
+/**
+ * Looks up the open file in a process' I/O slot
+ * @param proc - the process
+ * @param io - the I/O slot
+ * @return NULL if the slot is not a file, otherwise the file
+ */
+static fs_file_t *kfs_get(proc_t *proc, int io) {
+    if (!proc || io < 0 || io >= PROC_IO_MAX || proc->io_type[io] != IO_TYPE_FILE) {
+        return NULL;
+    }
+
+    return proc->io[io];
+}
+
+/**
+ * Finds a directory entry by name
+ * @param name - file name
+ * @param entry - set to a copy of the entry
+ * @return -1 if not found, 0 on success
+ */
+static int kfs_lookup(char *name, fs_dirent_t *entry) {
+    fs_dirent_t *dirents;
+    kbuf_t *buf;
+
+    for (unsigned int b = 0; b < fs_super.dir_blocks; b++) {
+        buf = kbuf_get(fs_dev, fs_super.dir_start + b);
+        if (!buf) {
+            return -1;
+        }
+
+        dirents = (fs_dirent_t *)buf->data;
+
+        for (unsigned int i = 0; i < FS_DIRENTS_PER_BLOCK; i++) {
+            if (dirents[i].name[0] && strncmp(dirents[i].name, name, FS_NAME_LEN) == 0) {
+                *entry = dirents[i];
+                kbuf_put(buf);
+                return 0;
+            }
+        }
+
+        kbuf_put(buf);
+    }
+
+    return -1;
+}
+
+/**
+ * Translates a file block to a disk block
+ * @param entry - the file's directory entry
+ * @param block - block number within the file
+ * @return -1 if past the file's extents, otherwise the disk block
+ */
+static int kfs_bmap(fs_dirent_t *entry, unsigned int block) {
+    for (int i = 0; i < FS_EXTENTS; i++) {
+        if (block < entry->extents[i].count) {
+            return entry->extents[i].start + block;
+        }
+
+        block -= entry->extents[i].count;
+    }
+
+    return -1;
+}
+
+/**
+ * Mounts the filesystem on a block device
+ * @param dev - block device id
+ * @return -1 if the device does not hold a filesystem, 0 on success
+ */
+int kfs_mount(int dev) {
+    kblock_dev_t *device = kblock_get(dev);
+    kbuf_t *buf;
+
+    if (!device) {
+        return -1;
+    }
+
+    buf = kbuf_get(dev, 0);
+    if (!buf) {
+        return -1;
+    }
+
+    memcpy(&fs_super, buf->data, sizeof(fs_super_t));
+    kbuf_put(buf);
+
+    if (fs_super.magic != FS_MAGIC || fs_super.blocks > (unsigned int)device->blocks ||
+        fs_super.dir_start + fs_super.dir_blocks > fs_super.blocks) {
+        kernel_log_warn("No filesystem on block device %s", device->name);
+        return -1;
+    }
+
+    memset(fs_files, 0, sizeof(fs_files));
+    fs_dev = dev;
+
+    kernel_log_info("Mounted filesystem on %s: %d files, %d blocks",
+                    device->name, fs_super.files, fs_super.blocks);
+    return 0;
+}
+
+/**
+ * Opens a file into a free I/O slot of the active process
+ * @param name - file name
+ * @return -1 on error, otherwise the I/O slot
+ */
+int kfs_open(char *name) {
+    fs_file_t *file = NULL;
+    int io = -1;
+
+    if (fs_dev < 0 || !active_proc || !name) {
+        return -1;
+    }
+
+    for (int i = 0; i < PROC_IO_MAX; i++) {
+        if (!active_proc->io[i]) {
+            io = i;
+            break;
+        }
+    }
+
+    for (int i = 0; i < FS_FILE_MAX; i++) {
+        if (fs_files[i].refs == 0) {
+            file = &fs_files[i];
+            break;
+        }
+    }
+
+    if (io < 0 || !file) {
+        return -1;
+    }
+
+    if (kfs_lookup(name, &file->entry) != 0) {
+        return -1;
+    }
+
+    file->refs = 1;
+    file->pos = 0;
+
+    active_proc->io[io] = file;
+    active_proc->io_type[io] = IO_TYPE_FILE;
+    return io;
+}
+
+/**
+ * Reads from an open file of the active process
+ * @param io - the I/O slot
+ * @param buf - destination buffer
+ * @param n - maximum number of bytes to read
+ * @return -1 on error, otherwise the number of bytes read (0 at end of file)
+ */
+int kfs_read(int io, char *buf, int n) {
+    proc_t *proc = active_proc;
+    fs_file_t *file = kfs_get(proc, io);
+    unsigned int offset;
+    unsigned int len;
+    int total = 0;
+    int block;
+    int rc;
+    kbuf_t *cached;
+
+    if (!file || !buf || n < 0) {
+        return -1;
+    }
+
+    // Copy block by block straight out of the buffer cache
+    while (total < n && file->pos < file->entry.size) {
+        block = kfs_bmap(&file->entry, file->pos / BLOCK_SIZE);
+        if (block < 0) {
+            break;
+        }
+
+        rc = kbuf_try(fs_dev, block, &cached);
+
+        if (rc == KBUF_PENDING) {
+            // Hand back what is already copied, or sleep until the device
+            // delivers the block and then repeat the read
+            if (total > 0) {
+                return total;
+            }
+
+            if (kbuf_wait(fs_dev) != 0) {
+                return -1;
+            }
+
+            ksyscall_restart(proc);
+            return 0;
+        }
+
+        if (rc != 0) {
+            return total ? total : -1;
+        }
+
+        offset = file->pos % BLOCK_SIZE;
+        len = BLOCK_SIZE - offset;
+
+        if (len > (unsigned int)(n - total)) {
+            len = n - total;
+        }
+
+        if (len > file->entry.size - file->pos) {
+            len = file->entry.size - file->pos;
+        }
+
+        memcpy(buf + total, cached->data + offset, len);
+        kbuf_put(cached);
+
+        file->pos += len;
+        total += len;
+    }
+
+    return total;
+}
+
+/**
+ * Moves the offset of an open file of the active process
+ * @param io - the I/O slot
+ * @param offset - offset relative to whence
+ * @param whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * @return -1 on error, otherwise the new offset
+ */
+int kfs_seek(int io, int offset, int whence) {
+    fs_file_t *file = kfs_get(active_proc, io);
+    int pos;
+
+    if (!file) {
+        return -1;
+    }
+
+    switch (whence) {
+        case SEEK_SET:
+            pos = offset;
+            break;
+
+        case SEEK_CUR:
+            pos = file->pos + offset;
+            break;
+
+        case SEEK_END:
+            pos = file->entry.size + offset;
+            break;
+
+        default:
+            return -1;
+    }
+
+    if (pos < 0) {
+        return -1;
+    }
+
+    file->pos = pos;
+    return pos;
+}
+
+/**
+ * Counts another reference to the file in a process' I/O slot
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a file, 0 on success
+ */
+int kfs_dup(proc_t *proc, int io) {
+    fs_file_t *file = kfs_get(proc, io);
+
+    if (!file) {
+        return -1;
+    }
+
+    file->refs++;
+    return 0;
+}
+
+/**
+ * Closes the file in a process' I/O slot
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a file, 0 on success
+ */
+int kfs_close(proc_t *proc, int io) {
+    fs_file_t *file = kfs_get(proc, io);
+
+    if (!file) {
+        return -1;
+    }
+
+    file->refs--;
+
+    proc->io[io] = NULL;
+    proc->io_type[io] = IO_TYPE_RINGBUF;
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Latency Histograms
+ */
+
+#include "bit_util.h"
+#include "interrupts.h"
+#include "klat.h"
+
+// Histograms indexed by interrupt number and by system call id; id and
+// min are filled in by the first sample
+lat_hist_t klat_irq[IRQ_MAX];
+lat_hist_t klat_syscall[SYSCALL_MAX];
+
+/**
+ * Adds a sample to a histogram
+ * @param hist - the histogram
+ * @param id - interrupt number or system call id
+ * @param cycles - the latency
+ */
+static void klat_add(lat_hist_t *hist, int id, unsigned int cycles) {
+    int bucket = bit_fls(cycles);
+
+    if (hist->count == 0) {
+        hist->id = id;
+        hist->min = cycles;
+    } else if (cycles < hist->min) {
+        hist->min = cycles;
+    }
+
+    if (cycles > hist->max) {
+        hist->max = cycles;
+    }
+
+    hist->count++;
+    hist->buckets[bucket < 0 ? 0 : bucket]++;
+}
+
+/**
+ * Reads the time stamp counter
+ * @return CPU cycles since reset
+ */
+unsigned long long klat_rdtsc(void) {
+    unsigned int lo;
+    unsigned int hi;
+
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+/**
+ * Records the latency of a kernel context entry
+ * @param irq - interrupt number
+ * @param syscall - system call id when irq is IRQ_SYSCALL
+ * @param start - time stamp counter on entry
+ */
+void klat_record(int irq, int syscall, unsigned long long start) {
+    unsigned long long elapsed = klat_rdtsc() - start;
+    unsigned int cycles = elapsed > 0xffffffff ? 0xffffffff : (unsigned int)elapsed;
+
+    if (irq < 0 || irq >= IRQ_MAX) {
+        return;
+    }
+
+    klat_add(&klat_irq[irq], irq, cycles);
+
+    if (irq == IRQ_SYSCALL && syscall > SYSCALL_NONE && syscall < SYSCALL_MAX) {
+        klat_add(&klat_syscall[syscall], syscall, cycles);
+    }
+}
+
+/**
+ * Copies the histograms that have samples, in id order
+ * @param kind - LAT_IRQ or LAT_SYSCALL
+ * @param hists - destination for up to n histograms
+ * @param n - maximum number of histograms
+ * @return -1 on error, otherwise the number of histograms copied
+ */
+int klat_snapshot(int kind, lat_hist_t *hists, int n) {
+    lat_hist_t *table;
+    int size;
+    int copied = 0;
+
+    if (!hists || n < 0) {
+        return -1;
+    }
+
+    if (kind == LAT_IRQ) {
+        table = klat_irq;
+        size = IRQ_MAX;
+    } else if (kind == LAT_SYSCALL) {
+        table = klat_syscall;
+        size = SYSCALL_MAX;
+    } else {
+        return -1;
+    }
+
+    for (int i = 0; i < size && copied < n; i++) {
+        if (table[i].count) {
+            hists[copied++] = table[i];
+        }
+    }
+
+    return copied;
+}
@@ -0,0 +1,215 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Heap
+ *
+ * Each size class carves whole pages into objects and keeps the free
+ * objects on a singly linked list threaded through the objects themselves.
+ * A per-page table records which class a page belongs to, so kfree does
+ * not need a header in front of each object.
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kmalloc.h"
+#include "kpage.h"
+
+// Free object, linked through its first word
+typedef struct kmalloc_free_t {
+    struct kmalloc_free_t *next;
+} kmalloc_free_t;
+
+// Free list of each size class
+kmalloc_free_t *kmalloc_free_list[MEM_CLASSES];
+
+// Counters for each size class
+int kmalloc_class_pages[MEM_CLASSES];
+int kmalloc_class_used[MEM_CLASSES];
+int kmalloc_class_free[MEM_CLASSES];
+
+// Counters for allocations that take whole pages
+int kmalloc_large_allocs;
+int kmalloc_large_pages;
+
+// Owner of each page: 0 if not used by the heap, class + 1 for size class
+// pages, or minus the page count on the first page of a large allocation
+int kmalloc_page_info[KPAGE_COUNT];
+
+/**
+ * Finds the size class for a size
+ * @param size - number of bytes
+ * @return the size class, -1 if the size needs whole pages
+ */
+static int kmalloc_class(size_t size) {
+    int class = 0;
+
+    if (size > KMALLOC_MAX_SIZE) {
+        return -1;
+    }
+
+    while ((1u << (KMALLOC_MIN_SHIFT + class)) < size) {
+        class++;
+    }
+
+    return class;
+}
+
+/**
+ * Adds a page of objects to a size class free list
+ * @param class - the size class
+ * @return -1 if out of memory, 0 on success
+ */
+static int kmalloc_grow(int class) {
+    int size = 1 << (KMALLOC_MIN_SHIFT + class);
+    unsigned char *page = kpage_alloc();
+
+    if (!page) {
+        return -1;
+    }
+
+    kmalloc_page_info[kpage_number(page)] = class + 1;
+    kmalloc_class_pages[class]++;
+
+    // Push from the end so objects are handed out in address order
+    for (int offset = KPAGE_SIZE - size; offset >= 0; offset -= size) {
+        kmalloc_free_t *obj = (kmalloc_free_t *)&page[offset];
+
+        obj->next = kmalloc_free_list[class];
+        kmalloc_free_list[class] = obj;
+        kmalloc_class_free[class]++;
+    }
+
+    return 0;
+}
+
+/**
+ * Initializes the kernel heap
+ */
+void kmalloc_init(void) {
+    kernel_log_info("Initializing kernel heap");
+
+    memset(kmalloc_free_list, 0, sizeof(kmalloc_free_list));
+    memset(kmalloc_class_pages, 0, sizeof(kmalloc_class_pages));
+    memset(kmalloc_class_used, 0, sizeof(kmalloc_class_used));
+    memset(kmalloc_class_free, 0, sizeof(kmalloc_class_free));
+    memset(kmalloc_page_info, 0, sizeof(kmalloc_page_info));
+
+    kmalloc_large_allocs = 0;
+    kmalloc_large_pages = 0;
+}
+
+/**
+ * Allocates kernel memory
+ * @param size - number of bytes
+ * @return NULL if out of memory, otherwise the allocated memory
+ */
+void *kmalloc(size_t size) {
+    int class = kmalloc_class(size);
+    kmalloc_free_t *obj;
+
+    if (size == 0) {
+        return NULL;
+    }
+
+    if (class < 0) {
+        int pages = (size + KPAGE_SIZE - 1) / KPAGE_SIZE;
+        void *mem = kpage_alloc_contig(pages);
+
+        if (!mem) {
+            return NULL;
+        }
+
+        kmalloc_page_info[kpage_number(mem)] = -pages;
+        kmalloc_large_allocs++;
+        kmalloc_large_pages += pages;
+
+        return mem;
+    }
+
+    if (!kmalloc_free_list[class] && kmalloc_grow(class) != 0) {
+        return NULL;
+    }
+
+    obj = kmalloc_free_list[class];
+    kmalloc_free_list[class] = obj->next;
+
+    kmalloc_class_free[class]--;
+    kmalloc_class_used[class]++;
+
+    return obj;
+}
+
+/**
+ * Frees memory returned by kmalloc
+ * @param ptr - the memory to free (may be NULL)
+ */
+void kfree(void *ptr) {
+    kmalloc_free_t *obj = ptr;
+    int page;
+    int info;
+
+    if (!ptr) {
+        return;
+    }
+
+    page = kpage_number((void *)((unsigned int)ptr & ~(KPAGE_SIZE - 1)));
+    info = (page < 0) ? 0 : kmalloc_page_info[page];
+
+    if (info == 0) {
+        kernel_log_warn("kfree: 0x%x was not allocated by kmalloc", ptr);
+        return;
+    }
+
+    if (info < 0) {
+        if ((unsigned int)ptr % KPAGE_SIZE) {
+            kernel_log_warn("kfree: 0x%x is not the start of an allocation", ptr);
+            return;
+        }
+
+        kmalloc_page_info[page] = 0;
+        kmalloc_large_allocs--;
+        kmalloc_large_pages += info;
+        kpage_free_contig(ptr, -info);
+        return;
+    }
+
+    obj->next = kmalloc_free_list[info - 1];
+    kmalloc_free_list[info - 1] = obj;
+
+    kmalloc_class_used[info - 1]--;
+    kmalloc_class_free[info - 1]++;
+}
+
+/**
+ * Fills in the heap and page allocator statistics
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 on error, 0 on success
+ */
+int kmalloc_stats(mem_stats_t *stats) {
+    kpage_stats_t pages;
+
+    if (!stats) {
+        return -1;
+    }
+
+    for (int i = 0; i < MEM_CLASSES; i++) {
+        stats->class_size[i] = 1 << (KMALLOC_MIN_SHIFT + i);
+        stats->class_pages[i] = kmalloc_class_pages[i];
+        stats->class_used[i] = kmalloc_class_used[i];
+        stats->class_free[i] = kmalloc_class_free[i];
+    }
+
+    stats->large_allocs = kmalloc_large_allocs;
+    stats->large_pages = kmalloc_large_pages;
+
+    kpage_stats(&pages);
+    stats->pages_total = pages.total;
+    stats->pages_free = pages.free;
+    stats->free_runs = pages.free_runs;
+    stats->largest_free = pages.largest_free;
+
+    return 0;
+}
@@ -0,0 +1,279 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Mailboxes
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kmbox.h"
+#include "ksyscall.h"
+#include "queue.h"
+#include "scheduler.h"
+
+// Table of all mailboxes
+mbox_t mboxes[MBOX_MAX];
+
+// Mailbox ids to be allocated
+queue_t mbox_queue;
+
+// Message slots for all mailboxes
+char mbox_arena[MBOX_MAX * MBOX_SLOTS * MBOX_MSG_SIZE];
+
+/**
+ * Initializes kernel mailbox data structures
+ * @return -1 on error, 0 on success
+ */
+int kmboxes_init(void) {
+    kernel_log_info("Initializing kernel mailboxes");
+
+    // Initialize the mailbox table
+    memset(&mboxes, 0, sizeof(mboxes));
+
+    // Initialize and fill the mailbox queue
+    queue_init(&mbox_queue);
+    for (int i = 0; i < MBOX_MAX; i++) {
+        if (queue_in(&mbox_queue, i) != 0) {
+            kernel_log_warn("mbox: unable to queue mailbox %d", i);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Looks up an allocated mailbox in the mailbox table
+ * @param id - the mailbox id
+ * @return NULL on error, otherwise the mailbox table entry
+ */
+static mbox_t *kmbox_get(int id) {
+    if (id >= MBOX_MAX || id < 0) {
+        return NULL;
+    }
+
+    if (!mboxes[id].allocated) {
+        return NULL;
+    }
+
+    return &mboxes[id];
+}
+
+/**
+ * Blocks the active process until its send or receive can make progress
+ * The system call is repeated when the process is woken, so the message is
+ * always copied from the process' own context
+ * @param queue - the mailbox wait queue
+ * @return -1 on error, 0 on success
+ */
+static int kmbox_block(queue_t *queue) {
+    if (queue_in(queue, active_proc->pid) != 0) {
+        return -1;
+    }
+
+    ksyscall_restart(active_proc);
+    active_proc->state = WAITING;
+    scheduler_remove(active_proc);
+    return 0;
+}
+
+/**
+ * Reschedules the first process on a mailbox wait queue to repeat its
+ * send or receive
+ * @param queue - the mailbox wait queue
+ * @return -1 if no process was waiting, 0 on success
+ */
+static int kmbox_wake(queue_t *queue) {
+    proc_t *proc;
+    int pid;
+
+    while (queue_out(queue, &pid) == 0) {
+        proc = pid_to_proc(pid);
+        if (proc) {
+            scheduler_add(proc);
+            return 0;
+        }
+
+        kernel_log_warn("mbox: unable to look up process id %d", pid);
+    }
+
+    return -1;
+}
+
+/**
+ * Wakes one process selecting on the mailbox
+ * The process is removed from the select queue of every other mailbox
+ * @param id - the mailbox id
+ */
+static void kmbox_wake_select(int id) {
+    proc_t *proc;
+    int pid;
+
+    if (queue_out(&mboxes[id].select_queue, &pid) != 0) {
+        return;
+    }
+
+    for (int i = 0; i < MBOX_MAX; i++) {
+        queue_remove(&mboxes[i].select_queue, pid);
+    }
+
+    proc = pid_to_proc(pid);
+    if (!proc) {
+        kernel_log_warn("mbox: unable to look up process id %d", pid);
+        return;
+    }
+
+    // Select returns the id of the mailbox holding the message
+    proc->trapframe->eax = (unsigned int)id;
+    scheduler_add(proc);
+}
+
+/**
+ * Allocates a mailbox
+ * @return -1 on error, otherwise the mailbox id that was allocated
+ */
+int kmbox_init(void) {
+    int id = -1;
+
+    // Obtain a mailbox id from the mailbox queue
+    if (queue_out(&mbox_queue, &id) != 0) {
+        return -1;
+    }
+
+    mbox_t *mbox = &mboxes[id];
+
+    memset(mbox, 0, sizeof(mbox_t));
+    mbox->allocated = 1;
+    mbox->slots = &mbox_arena[id * MBOX_SLOTS * MBOX_MSG_SIZE];
+
+    return id;
+}
+
+/**
+ * Frees the specified mailbox
+ * @param id - the mailbox id
+ * @return 0 on success, -1 on error
+ */
+int kmbox_destroy(int id) {
+    mbox_t *mbox = kmbox_get(id);
+
+    if (!mbox) {
+        return -1;
+    }
+
+    // Prevent a mailbox with blocked processes from being destroyed
+    if (mbox->send_queue.size > 0 || mbox->recv_queue.size > 0 ||
+        mbox->select_queue.size > 0) {
+        return -1;
+    }
+
+    memset(mbox, 0, sizeof(mbox_t));
+
+    // Add the id back into the mailbox queue to be re-used later
+    queue_in(&mbox_queue, id);
+
+    return 0;
+}
+
+/**
+ * Sends a message to the mailbox
+ * @param id - the mailbox id
+ * @param buf - the message to send
+ * @param size - size of the message (at most MBOX_MSG_SIZE)
+ * @return -1 on error, 0 on success
+ */
+int kmbox_send(int id, char *buf, int size) {
+    mbox_t *mbox = kmbox_get(id);
+
+    if (!mbox || !buf || size < 0 || size > MBOX_MSG_SIZE) {
+        return -1;
+    }
+
+    // Wait for a free slot if the mailbox is full
+    if (mbox->count == MBOX_SLOTS) {
+        return kmbox_block(&mbox->send_queue);
+    }
+
+    memcpy(&mbox->slots[mbox->tail * MBOX_MSG_SIZE], buf, size);
+    mbox->sizes[mbox->tail] = size;
+    mbox->tail = (mbox->tail + 1) % MBOX_SLOTS;
+    mbox->count++;
+
+    // A waiting receiver takes the message when it runs, otherwise a
+    // selecting process is told about it
+    if (kmbox_wake(&mbox->recv_queue) != 0) {
+        kmbox_wake_select(id);
+    }
+
+    return 0;
+}
+
+/**
+ * Receives the oldest message from the mailbox, blocking if it is empty
+ * @param id - the mailbox id
+ * @param buf - buffer to copy the message to
+ * @param size - size of the buffer; longer messages are truncated
+ * @return -1 on error, otherwise the number of bytes received
+ */
+int kmbox_recv(int id, char *buf, int size) {
+    mbox_t *mbox = kmbox_get(id);
+
+    if (!mbox || !buf || size < 0) {
+        return -1;
+    }
+
+    if (mbox->count == 0) {
+        return kmbox_block(&mbox->recv_queue);
+    }
+
+    if (size > mbox->sizes[mbox->head]) {
+        size = mbox->sizes[mbox->head];
+    }
+
+    memcpy(buf, &mbox->slots[mbox->head * MBOX_MSG_SIZE], size);
+    mbox->head = (mbox->head + 1) % MBOX_SLOTS;
+    mbox->count--;
+
+    // Let a blocked sender move its message into the freed slot
+    kmbox_wake(&mbox->send_queue);
+
+    return size;
+}
+
+/**
+ * Waits until any of the selected mailboxes holds a message
+ * @param mask - bitmask of mailbox ids (bit n selects mailbox n)
+ * @return -1 on error, otherwise the id of a mailbox with a message
+ */
+int kmbox_select(int mask) {
+    int selected = 0;
+
+    for (int i = 0; i < MBOX_MAX; i++) {
+        if (!(mask & (1 << i)) || !kmbox_get(i)) {
+            continue;
+        }
+
+        if (mboxes[i].count > 0) {
+            return i;
+        }
+
+        selected++;
+    }
+
+    if (!selected) {
+        return -1;
+    }
+
+    // Wait on every selected mailbox; the first message wakes the process
+    for (int i = 0; i < MBOX_MAX; i++) {
+        if ((mask & (1 << i)) && kmbox_get(i)) {
+            queue_in(&mboxes[i].select_queue, active_proc->pid);
+        }
+    }
+
+    active_proc->state = WAITING;
+    scheduler_remove(active_proc);
+    return 0;
+}
@@ -12,6 +12,7 @@
 #include "kmutex.h"
 #include "queue.h"
 #include "scheduler.h"
+#include "timer.h"
 
 // Table of all mutexes
 mutex_t mutexes[MUTEX_MAX];
@@ -19,6 +20,32 @@ mutex_t mutexes[MUTEX_MAX];
 // Mutex ids to be allocated
 queue_t mutex_queue;
 
+/**
+ * Records a process blocking on a mutex
+ * @param mutex - the mutex
+ */
+static void kmutex_contended(mutex_t *mutex) {
+    mutex->stats.contended++;
+
+    if (mutex->wait_queue.size > mutex->stats.max_queue) {
+        mutex->stats.max_queue = mutex->wait_queue.size;
+    }
+}
+
+/**
+ * Records the time a process was blocked before being handed a mutex
+ * @param mutex - the mutex
+ * @param proc - the process, blocked since proc->state_time
+ */
+static void kmutex_waited(mutex_t *mutex, proc_t *proc) {
+    int wait = timer_get_ticks() - proc->state_time;
+
+    mutex->stats.wait_ticks += wait;
+    if (wait > mutex->stats.max_wait) {
+        mutex->stats.max_wait = wait;
+    }
+}
+
 /**
  * Initializes kernel mutex data structures
  * @return -1 on error, 0 on success
@@ -54,7 +81,7 @@ int kmutex_init(void) {
         id++;
     }
     // Ensure that the id is within the valid range
-    if(id > MUTEX_MAX || id < 0) {
+    if(id >= MUTEX_MAX || id < 0) {
         return -1;
     }
     // Pointer to the mutex table entry
@@ -64,6 +91,7 @@ int kmutex_init(void) {
     mutex->locks = 0;
     mutex->owner = NULL;
     memset(&mutex->wait_queue, 0, sizeof(mutex->wait_queue));
+    memset(&mutex->stats, 0, sizeof(mutex->stats));
     // return the mutex id
     return id;
 }
@@ -75,7 +103,7 @@ int kmutex_init(void) {
  */
 int kmutex_destroy(int id) {
     // look up the mutex in the mutex table
-    if(id > MUTEX_MAX || id < 0) {
+    if(id >= MUTEX_MAX || id < 0 || !mutexes[id].allocated) {
         return -1;
     }
     mutex_t *mutex = &mutexes[id];
@@ -101,6 +129,9 @@ int kmutex_destroy(int id) {
  */
 int kmutex_lock(int id) {
     // look up the mutex in the mutex table
+    if (id >= MUTEX_MAX || id < 0 || !mutexes[id].allocated) {
+        return -1;
+    }
     mutex_t *mutex = &mutexes[id];
     // If the mutex is already locked
     //   1. Set the active process state to WAITING
@@ -108,11 +139,13 @@ int kmutex_lock(int id) {
     //      the mutex when it is unlocked)
     //   3. Remove the process from the scheduler, allow another
     //      process to be scheduled
+    mutex->stats.acquisitions++;
     if (mutex->owner != NULL) {
-        active_proc->state = WAITING;
         if (queue_in(&mutex->wait_queue, active_proc->pid) != 0) {
             return -1;
         }
+        active_proc->state = WAITING;
+        kmutex_contended(mutex);
         scheduler_remove(active_proc);
     }
     // If the mutex is not locked
@@ -133,13 +166,14 @@ int kmutex_lock(int id) {
  */
 int kmutex_unlock(int id) {
     // look up the mutex in the mutex table
+    if (id >= MUTEX_MAX || id < 0 || !mutexes[id].allocated) {
+        return -1;
+    }
     mutex_t *mutex = &mutexes[id];
     // If the mutex is not locked, there is nothing to do
-    /*
     if (mutex->owner == NULL) {
         return -1;
     }
-    */
     // Decrement the lock count
     mutex->locks = mutex->locks - 1;
     // If there are no more locks held:
@@ -151,18 +185,105 @@ int kmutex_unlock(int id) {
     //    1. Obtain a process from the mutex wait queue
     //    2. Add the process back to the scheduler
     //    3. set the owner of the of the mutex to the process
-    if (mutex->locks > 0) {
-        for (int i = 0; i < MUTEX_MAX; i++) {
-            if (queue_out(&mutex->wait_queue, &i) != 0) {
-                queue_in(&mutex->wait_queue, i);
-            }
-            else {
-                scheduler_add(pid_to_proc(i));
-                mutex->owner = pid_to_proc(i);
-                break;
-            }
-        }
+    //    (without waiters, the owner still holds a recursive lock)
+    int pid;
+    if (mutex->locks > 0 && queue_out(&mutex->wait_queue, &pid) == 0) {
+        kmutex_waited(mutex, pid_to_proc(pid));
+        scheduler_add(pid_to_proc(pid));
+        mutex->owner = pid_to_proc(pid);
     }
     // return the mutex lock count
     return mutex->locks;
 }
+
+/**
+ * Locks the specified mutex on behalf of a process that is not running
+ * @param id - the mutex id
+ * @param proc - the process to take the lock for
+ * @return -1 on error, otherwise the current lock count
+ */
+int kmutex_lock_proc(int id, proc_t *proc) {
+    if (id >= MUTEX_MAX || id < 0 || !proc) {
+        return -1;
+    }
+
+    mutex_t *mutex = &mutexes[id];
+
+    // If the mutex is held, the process waits for it to be handed over
+    // by kmutex_unlock; otherwise it owns the mutex and can run again.
+    // The process has been blocked since it started waiting on the
+    // condition variable, so its mutex wait time includes that wait.
+    mutex->stats.acquisitions++;
+    if (mutex->owner != NULL) {
+        proc->state = WAITING;
+        if (queue_in(&mutex->wait_queue, proc->pid) != 0) {
+            return -1;
+        }
+        kmutex_contended(mutex);
+    } else {
+        mutex->owner = proc;
+        scheduler_add(proc);
+    }
+
+    mutex->locks = mutex->locks + 1;
+    return mutex->locks;
+}
+
+/**
+ * Returns the process that currently holds the mutex
+ * @param id - the mutex id
+ * @return NULL if unlocked or on error, otherwise the owning process
+ */
+proc_t *kmutex_owner(int id) {
+    if (id >= MUTEX_MAX || id < 0) {
+        return NULL;
+    }
+
+    return mutexes[id].owner;
+}
+
+/**
+ * Releases the mutexes held by a process that is exiting
+ * Each mutex is handed to its next waiter, or unlocked
+ * @param proc - the process
+ */
+void kmutex_release(proc_t *proc) {
+    int pid;
+
+    for (int i = 0; i < MUTEX_MAX; i++) {
+        mutex_t *mutex = &mutexes[i];
+
+        if (!mutex->allocated || mutex->owner != proc) {
+            continue;
+        }
+
+        // Drop the locks taken by the process; the rest are the waiters'
+        mutex->locks = mutex->wait_queue.size;
+        mutex->owner = NULL;
+
+        if (queue_out(&mutex->wait_queue, &pid) == 0) {
+            kmutex_waited(mutex, pid_to_proc(pid));
+            scheduler_add(pid_to_proc(pid));
+            mutex->owner = pid_to_proc(pid);
+        }
+    }
+}
+
+/**
+ * Gets the contention statistics of a mutex
+ * @param id - the mutex id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the mutex is not allocated, 0 on success
+ */
+int kmutex_stats(int id, lock_stat_t *stats) {
+    if (id >= MUTEX_MAX || id < 0 || !stats || !mutexes[id].allocated) {
+        return -1;
+    }
+
+    *stats = mutexes[id].stats;
+    stats->type = LOCK_MUTEX;
+    stats->id = id;
+    stats->owner = mutexes[id].owner ? mutexes[id].owner->pid : -1;
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Physical Page Frame Allocator
+ *
+ * Each page is one bit in a bitmap (set when allocated). Searches skip a
+ * whole word at a time when it is full (or, for runs, empty), and use
+ * find-first-zero within a word otherwise.
+ */
+
+#include <spede/string.h>
+
+#include "bit_util.h"
+#include "kernel.h"
+#include "kpage.h"
+
+// Page bitmap, bit set when the page is allocated
+unsigned int kpage_map[KPAGE_WORDS];
+
+// Word to start single page searches from
+int kpage_hint;
+
+// Allocator counters
+int kpage_allocs;
+int kpage_frees;
+int kpage_failures;
+
+/**
+ * Indicates if a page is allocated
+ * @param page - page number
+ * @return 1 if allocated, 0 if free
+ */
+static int kpage_test(int page) {
+    return (kpage_map[page / 32] >> (page % 32)) & 1;
+}
+
+/**
+ * Marks a run of pages as allocated or free
+ * @param page - first page number
+ * @param count - number of pages
+ * @param used - 1 to mark allocated, 0 to mark free
+ */
+static void kpage_mark(int page, int count, int used) {
+    while (count > 0) {
+        int word = page / 32;
+        int bit = page % 32;
+        int n = (32 - bit < count) ? 32 - bit : count;
+        unsigned int mask = (n == 32) ? 0xffffffff : ((1u << n) - 1) << bit;
+
+        if (used) {
+            kpage_map[word] |= mask;
+        } else {
+            kpage_map[word] &= ~mask;
+        }
+
+        page += n;
+        count -= n;
+    }
+}
+
+/**
+ * Translates a physical address to a page number
+ * @param addr - physical address
+ * @return -1 if not a page managed by the allocator, otherwise the page
+ */
+int kpage_number(void *addr) {
+    unsigned int a = (unsigned int)addr;
+
+    if (a < KPAGE_MEM_START || a >= KPAGE_MEM_END || (a % KPAGE_SIZE) != 0) {
+        return -1;
+    }
+
+    return (a - KPAGE_MEM_START) / KPAGE_SIZE;
+}
+
+/**
+ * Translates a page number to a physical address
+ * @param page - page number
+ * @return physical address of the page
+ */
+static void *kpage_addr(int page) {
+    return (void *)(KPAGE_MEM_START + page * KPAGE_SIZE);
+}
+
+/**
+ * Initializes the page allocator with all pages free
+ */
+void kpages_init(void) {
+    kernel_log_info("Initializing page allocator: %d pages at 0x%x",
+                    KPAGE_COUNT, KPAGE_MEM_START);
+
+    memset(kpage_map, 0, sizeof(kpage_map));
+    kpage_hint = 0;
+    kpage_allocs = 0;
+    kpage_frees = 0;
+    kpage_failures = 0;
+}
+
+/**
+ * Allocates a single page
+ * @return NULL if out of memory, otherwise the physical address of the page
+ */
+void *kpage_alloc(void) {
+    for (int i = 0; i < KPAGE_WORDS; i++) {
+        int word = (kpage_hint + i) % KPAGE_WORDS;
+        int bit = bit_ffz(kpage_map[word]);
+
+        if (bit < 0) {
+            continue;
+        }
+
+        kpage_map[word] |= 1u << bit;
+        kpage_allocs++;
+        kpage_hint = word;
+
+        return kpage_addr(word * 32 + bit);
+    }
+
+    kpage_failures++;
+    return NULL;
+}
+
+/**
+ * Allocates physically contiguous pages
+ * Uses the first run of free pages that is long enough
+ * @param count - number of pages
+ * @return NULL if no run of free pages is long enough, otherwise the
+ *         physical address of the first page
+ */
+void *kpage_alloc_contig(int count) {
+    int start = 0;
+    int run = 0;
+    int page = 0;
+
+    if (count <= 0) {
+        return NULL;
+    }
+
+    if (count == 1) {
+        return kpage_alloc();
+    }
+
+    while (page < KPAGE_COUNT) {
+        unsigned int word = kpage_map[page / 32];
+
+        // Whole words can be skipped or taken when aligned
+        if (page % 32 == 0 && word == 0xffffffff) {
+            run = 0;
+            page += 32;
+            continue;
+        }
+
+        if (page % 32 == 0 && word == 0 && count - run >= 32) {
+            if (run == 0) {
+                start = page;
+            }
+
+            run += 32;
+            page += 32;
+        } else {
+            if (kpage_test(page)) {
+                run = 0;
+            } else {
+                if (run == 0) {
+                    start = page;
+                }
+
+                run++;
+            }
+
+            page++;
+        }
+
+        if (run >= count) {
+            kpage_mark(start, count, 1);
+            kpage_allocs++;
+            return kpage_addr(start);
+        }
+    }
+
+    kpage_failures++;
+    return NULL;
+}
+
+/**
+ * Frees a single page
+ * @param page - physical address of the page
+ * @return -1 on error, 0 on success
+ */
+int kpage_free(void *page) {
+    return kpage_free_contig(page, 1);
+}
+
+/**
+ * Frees physically contiguous pages
+ * @param page - physical address of the first page
+ * @param count - number of pages
+ * @return -1 on error, 0 on success
+ */
+int kpage_free_contig(void *page, int count) {
+    int first = kpage_number(page);
+
+    if (first < 0 || count <= 0 || first + count > KPAGE_COUNT) {
+        kernel_log_warn("kpage: invalid free of %d pages at 0x%x", count, page);
+        return -1;
+    }
+
+    for (int i = first; i < first + count; i++) {
+        if (!kpage_test(i)) {
+            kernel_log_warn("kpage: double free of page 0x%x", kpage_addr(i));
+            return -1;
+        }
+    }
+
+    kpage_mark(first, count, 0);
+    kpage_frees++;
+
+    // Single page searches start from the lowest known free word
+    if (first / 32 < kpage_hint) {
+        kpage_hint = first / 32;
+    }
+
+    return 0;
+}
+
+/**
+ * Fills in the allocator statistics, including fragmentation of the free
+ * memory (number of free runs and the largest one)
+ * @param stats - pointer to the statistics to fill in
+ */
+void kpage_stats(kpage_stats_t *stats) {
+    int run = 0;
+
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(kpage_stats_t));
+    stats->total = KPAGE_COUNT;
+    stats->allocs = kpage_allocs;
+    stats->frees = kpage_frees;
+    stats->failures = kpage_failures;
+
+    for (int i = 0; i < KPAGE_WORDS; i++) {
+        stats->free += 32 - bit_popcount(kpage_map[i]);
+    }
+
+    for (int page = 0; page < KPAGE_COUNT; page++) {
+        if (kpage_test(page)) {
+            run = 0;
+            continue;
+        }
+
+        if (run == 0) {
+            stats->free_runs++;
+        }
+
+        run++;
+        if (run > stats->largest_free) {
+            stats->largest_free = run;
+        }
+    }
+}
@@ -0,0 +1,534 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Paging
+ */
+
+#include <spede/string.h>
+#include <spede/machine/proc_reg.h>
+
+#include "interrupts.h"
+#include "kernel.h"
+#include "kpage.h"
+#include "kpaging.h"
+#include "kproc.h"
+
+#define CR0_PG  0x80000000  // Paging enable
+#define CR0_WP  0x00010000  // Enforce read-only pages in ring 0
+#define CR4_PSE 0x00000010  // Page size extensions (4 MB pages)
+#define CR4_PGE 0x00000080  // Global pages
+
+// Kernel page directory, used by processes without private memory
+unsigned int *kpaging_kernel_dir;
+
+// Page directory currently loaded into CR3
+unsigned int kpaging_loaded;
+
+// Reload CR3 on every return to a process
+int kpaging_reload_always;
+
+// Mappings of each page frame, indexed by page number
+unsigned short kpaging_refs[KPAGE_COUNT];
+
+// Page table memory counters
+int kpaging_dirs;
+int kpaging_tables;
+int kpaging_pages;
+int kpaging_cr3_loads;
+int kpaging_cow_faults;
+int kpaging_cow_copies;
+int kpaging_zero_fills;
+
+// Page fault error code, saved by the page fault entry point
+unsigned int kpaging_fault_error;
+
+/**
+ * Allocates a zeroed page for a page directory or page table
+ * @return NULL if out of memory, otherwise the page
+ */
+static unsigned int *kpaging_alloc_table(void) {
+    unsigned int *table = kpage_alloc();
+
+    if (table) {
+        memset(table, 0, KPAGE_SIZE);
+    }
+
+    return table;
+}
+
+/**
+ * Releases one mapping of a page frame, freeing it with the last mapping
+ * @param frame - physical address of the page
+ */
+static void kpaging_frame_put(unsigned int frame) {
+    int page = kpage_number((void *)frame);
+
+    // Frames outside the allocator are never freed
+    if (page < 0) {
+        return;
+    }
+
+    if (--kpaging_refs[page] == 0) {
+        kpage_free((void *)frame);
+    }
+}
+
+/**
+ * Flushes the TLB entry for a virtual address if the process is running
+ * @param proc - pointer to the process entry
+ * @param vaddr - virtual address
+ */
+static void kpaging_flush(proc_t *proc, unsigned int vaddr) {
+    if (proc->page_dir && (unsigned int)proc->page_dir == kpaging_loaded) {
+        asm volatile("invlpg (%0)" :: "r"(vaddr) : "memory");
+    }
+}
+
+/**
+ * Resolves a page fault that private memory management expects: a write to
+ * a copy-on-write page or a touch of a zero filled page
+ * @param proc - the process whose page directory is loaded
+ * @param addr - the faulting virtual address
+ * @return -1 if the fault is an error, 0 if the access can be retried
+ */
+static int kpaging_resolve(proc_t *proc, unsigned int addr) {
+    if (!proc) {
+        return -1;
+    }
+
+    if (kpaging_fault_error & PAGE_FAULT_PRESENT) {
+        if (!(kpaging_fault_error & PAGE_FAULT_WRITE)) {
+            return -1;
+        }
+
+        return kpaging_cow(proc, addr);
+    }
+
+    if (addr < proc->zero_start || addr >= proc->zero_end) {
+        return -1;
+    }
+
+    if (kpaging_map(proc, addr & PAGE_FRAME_MASK, 1, PAGE_WRITE) != 0) {
+        return -1;
+    }
+
+    kpaging_zero_fills++;
+    return 0;
+}
+
+/**
+ * Handles a page fault raised while running a process
+ * Copy-on-write and zero fill faults are resolved and the process resumes;
+ * any other fault destroys the process. Faults in the idle process panic.
+ */
+void kpaging_fault(void) {
+    unsigned int addr;
+
+    asm volatile("movl %%cr2, %0" : "=r"(addr));
+
+    if (kpaging_resolve(active_proc, addr) == 0) {
+        return;
+    }
+
+    // Processes always run with interrupts enabled
+    if (!active_proc || active_proc->pid == 0 ||
+        !(active_proc->trapframe->eflags & EF_INTR)) {
+        kernel_panic("Page fault in kernel at 0x%x (error 0x%x)", addr, kpaging_fault_error);
+        return;
+    }
+
+    kernel_log_error("Page fault in process %s (%d) at 0x%x (eip 0x%x, error 0x%x)",
+                     active_proc->name, active_proc->pid, addr,
+                     active_proc->trapframe->eip, kpaging_fault_error);
+
+    kproc_destroy(active_proc);
+}
+
+/**
+ * Handles a page fault raised by the kernel itself (see context.S)
+ * Runs on the kernel stack without re-entering the kernel context, so the
+ * only faults that can be handled are copy-on-write and zero fill faults
+ * in the process whose page directory is loaded, e.g. a syscall filling a
+ * buffer.
+ */
+void kpaging_fault_kernel(void) {
+    unsigned int addr;
+
+    asm volatile("movl %%cr2, %0" : "=r"(addr));
+
+    if (active_proc && (unsigned int)active_proc->page_dir == kpaging_loaded &&
+        kpaging_resolve(active_proc, addr) == 0) {
+        return;
+    }
+
+    kernel_panic("Page fault in kernel at 0x%x (error 0x%x)", addr, kpaging_fault_error);
+}
+
+/**
+ * Builds the kernel page directory and enables paging
+ */
+void kpaging_init(void) {
+    unsigned int reg;
+
+    kernel_log_info("Initializing paging: %d MB identity mapped with 4 MB pages",
+                    KPAGING_KERNEL_END / 0x100000);
+
+    kpaging_kernel_dir = kpaging_alloc_table();
+    if (!kpaging_kernel_dir) {
+        kernel_panic("Unable to allocate the kernel page directory");
+        return;
+    }
+
+    kpaging_dirs = 1;
+
+    for (unsigned int addr = 0; addr < KPAGING_KERNEL_END; addr += KPAGING_LARGE_SIZE) {
+        kpaging_kernel_dir[addr / KPAGING_LARGE_SIZE] =
+            addr | PAGE_PRESENT | PAGE_WRITE | PAGE_LARGE | PAGE_GLOBAL;
+    }
+
+    interrupts_irq_register(IRQ_PAGE_FAULT, isr_entry_page_fault, kpaging_fault);
+
+    // Enable 4 MB and global pages, then turn on paging
+    asm volatile("movl %%cr4, %0" : "=r"(reg));
+    reg |= CR4_PSE | CR4_PGE;
+    asm volatile("movl %0, %%cr4" :: "r"(reg));
+
+    kpaging_loaded = (unsigned int)kpaging_kernel_dir;
+    asm volatile("movl %0, %%cr3" :: "r"(kpaging_loaded) : "memory");
+
+    // Processes run in ring 0, so read-only (copy-on-write) pages are only
+    // enforced with CR0.WP set
+    asm volatile("movl %%cr0, %0" : "=r"(reg));
+    reg |= CR0_PG | CR0_WP;
+    asm volatile("movl %0, %%cr0" :: "r"(reg) : "memory");
+}
+
+/**
+ * Looks up the page table entry for a private virtual address
+ * @param proc - pointer to the process entry
+ * @param vaddr - virtual address in the private region
+ * @param create - non-zero to create the page directory and table if needed
+ * @return NULL if there is no page table for the address, otherwise a
+ *         pointer to the page table entry
+ */
+unsigned int *kpaging_pte(proc_t *proc, unsigned int vaddr, int create) {
+    unsigned int *table;
+    int pde = vaddr / KPAGING_LARGE_SIZE;
+
+    if (!proc || vaddr < KPAGING_PRIVATE_START || vaddr >= KPAGING_PRIVATE_END) {
+        return NULL;
+    }
+
+    if (!proc->page_dir) {
+        if (!create) {
+            return NULL;
+        }
+
+        proc->page_dir = kpaging_alloc_table();
+        if (!proc->page_dir) {
+            return NULL;
+        }
+
+        // Share the kernel mappings
+        memcpy(proc->page_dir, kpaging_kernel_dir, KPAGE_SIZE);
+        kpaging_dirs++;
+    }
+
+    if (!(proc->page_dir[pde] & PAGE_PRESENT)) {
+        if (!create) {
+            return NULL;
+        }
+
+        table = kpaging_alloc_table();
+        if (!table) {
+            return NULL;
+        }
+
+        proc->page_dir[pde] = (unsigned int)table | PAGE_PRESENT | PAGE_WRITE;
+        kpaging_tables++;
+    }
+
+    table = (unsigned int *)(proc->page_dir[pde] & PAGE_FRAME_MASK);
+    return &table[(vaddr / KPAGE_SIZE) % KPAGING_ENTRIES];
+}
+
+/**
+ * Maps an existing physical page into a process' private region
+ * The mapping holds a reference to the page; pages from the page allocator
+ * are freed when their last mapping is released. Pages mapped PAGE_PINNED
+ * hold no reference and are never freed or shared by fork.
+ * @param proc - pointer to the process entry
+ * @param vaddr - page aligned virtual address in the private region
+ * @param frame - physical address of the page
+ * @param flags - PAGE_* flags for the mapping (PAGE_PRESENT is implied)
+ * @return -1 on error, 0 on success
+ */
+int kpaging_map_frame(proc_t *proc, unsigned int vaddr, unsigned int frame, int flags) {
+    unsigned int *pte;
+
+    if (vaddr % KPAGE_SIZE || frame % KPAGE_SIZE) {
+        return -1;
+    }
+
+    pte = kpaging_pte(proc, vaddr, 1);
+    if (!pte || (*pte & PAGE_PRESENT)) {
+        return -1;
+    }
+
+    *pte = frame | flags | PAGE_PRESENT;
+    kpaging_pages++;
+
+    if (!(flags & PAGE_PINNED) && kpage_number((void *)frame) >= 0) {
+        kpaging_refs[kpage_number((void *)frame)]++;
+    }
+
+    // Drop any stale translation if the process is running
+    kpaging_flush(proc, vaddr);
+
+    return 0;
+}
+
+/**
+ * Maps newly allocated, zeroed pages into a process' private region
+ * @param proc - pointer to the process entry
+ * @param vaddr - page aligned virtual address in the private region
+ * @param pages - number of pages to map
+ * @param flags - PAGE_* flags for the mapping (PAGE_PRESENT is implied)
+ * @return -1 on error, 0 on success
+ */
+int kpaging_map(proc_t *proc, unsigned int vaddr, int pages, int flags) {
+    unsigned char *frame;
+
+    for (int i = 0; i < pages; i++) {
+        frame = kpage_alloc();
+        if (!frame) {
+            return -1;
+        }
+
+        memset(frame, 0, KPAGE_SIZE);
+
+        // The mapping holds the only reference to the frame
+        if (kpaging_map_frame(proc, vaddr + i * KPAGE_SIZE, (unsigned int)frame, flags) != 0) {
+            kpage_free(frame);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Releases a process' private memory, page tables and page directory
+ * @param proc - pointer to the process entry
+ */
+void kpaging_proc_destroy(proc_t *proc) {
+    unsigned int *table;
+
+    if (!proc) {
+        return;
+    }
+
+    proc->zero_start = 0;
+    proc->zero_end = 0;
+
+    if (!proc->page_dir) {
+        return;
+    }
+
+    for (unsigned int pde = KPAGING_PRIVATE_START / KPAGING_LARGE_SIZE;
+         pde < KPAGING_PRIVATE_END / KPAGING_LARGE_SIZE; pde++) {
+        if (!(proc->page_dir[pde] & PAGE_PRESENT)) {
+            continue;
+        }
+
+        table = (unsigned int *)(proc->page_dir[pde] & PAGE_FRAME_MASK);
+
+        for (int i = 0; i < KPAGING_ENTRIES; i++) {
+            if (!(table[i] & PAGE_PRESENT)) {
+                continue;
+            }
+
+            if (!(table[i] & PAGE_PINNED)) {
+                kpaging_frame_put(table[i] & PAGE_FRAME_MASK);
+            }
+
+            kpaging_pages--;
+        }
+
+        kpage_free(table);
+        kpaging_tables--;
+    }
+
+    // Never leave a freed directory loaded
+    if ((unsigned int)proc->page_dir == kpaging_loaded) {
+        kpaging_loaded = (unsigned int)kpaging_kernel_dir;
+        asm volatile("movl %0, %%cr3" :: "r"(kpaging_loaded) : "memory");
+        kpaging_cr3_loads++;
+    }
+
+    kpage_free(proc->page_dir);
+    proc->page_dir = NULL;
+    kpaging_dirs--;
+}
+
+/**
+ * Shares a process' private memory with a new process copy-on-write
+ * Pinned pages (the stack) are left out
+ * @param parent - the process being copied
+ * @param child - the new process, with no private memory besides its stack
+ * @return -1 on error, 0 on success
+ */
+int kpaging_fork(proc_t *parent, proc_t *child) {
+    unsigned int *table;
+    unsigned int *pte;
+    unsigned int vaddr;
+    int page;
+
+    if (!parent || !child) {
+        return -1;
+    }
+
+    child->zero_start = parent->zero_start;
+    child->zero_end = parent->zero_end;
+
+    if (!parent->page_dir) {
+        return 0;
+    }
+
+    for (unsigned int pde = KPAGING_PRIVATE_START / KPAGING_LARGE_SIZE;
+         pde < KPAGING_PRIVATE_END / KPAGING_LARGE_SIZE; pde++) {
+        if (!(parent->page_dir[pde] & PAGE_PRESENT)) {
+            continue;
+        }
+
+        table = (unsigned int *)(parent->page_dir[pde] & PAGE_FRAME_MASK);
+
+        for (int i = 0; i < KPAGING_ENTRIES; i++) {
+            if (!(table[i] & PAGE_PRESENT) || (table[i] & PAGE_PINNED)) {
+                continue;
+            }
+
+            vaddr = pde * KPAGING_LARGE_SIZE + i * KPAGE_SIZE;
+
+            pte = kpaging_pte(child, vaddr, 1);
+            if (!pte || (*pte & PAGE_PRESENT)) {
+                return -1;
+            }
+
+            // Writable pages become read-only in both processes until written
+            if (table[i] & PAGE_WRITE) {
+                table[i] = (table[i] & ~PAGE_WRITE) | PAGE_COW;
+            }
+
+            *pte = table[i];
+            kpaging_pages++;
+
+            page = kpage_number((void *)(table[i] & PAGE_FRAME_MASK));
+            if (page >= 0) {
+                kpaging_refs[page]++;
+            }
+        }
+    }
+
+    // Drop the parent's writable translations
+    if ((unsigned int)parent->page_dir == kpaging_loaded) {
+        asm volatile("movl %0, %%cr3" :: "r"(kpaging_loaded) : "memory");
+        kpaging_cr3_loads++;
+    }
+
+    return 0;
+}
+
+/**
+ * Resolves a write to a copy-on-write page
+ * @param proc - the process that wrote to the page
+ * @param vaddr - the faulting virtual address
+ * @return -1 if the page is not copy-on-write or memory is exhausted,
+ *         0 if the page is now writable
+ */
+int kpaging_cow(proc_t *proc, unsigned int vaddr) {
+    unsigned int *pte = kpaging_pte(proc, vaddr, 0);
+    unsigned int frame;
+    unsigned char *copy;
+    int page;
+
+    if (!pte || (*pte & (PAGE_PRESENT | PAGE_COW)) != (PAGE_PRESENT | PAGE_COW)) {
+        return -1;
+    }
+
+    kpaging_cow_faults++;
+
+    frame = *pte & PAGE_FRAME_MASK;
+    page = kpage_number((void *)frame);
+
+    // Copy the page unless this is the last mapping of it
+    if (page < 0 || kpaging_refs[page] > 1) {
+        copy = kpage_alloc();
+        if (!copy) {
+            return -1;
+        }
+
+        memcpy(copy, (void *)frame, KPAGE_SIZE);
+        kpaging_refs[kpage_number(copy)] = 1;
+        kpaging_frame_put(frame);
+        kpaging_cow_copies++;
+
+        frame = (unsigned int)copy;
+    }
+
+    *pte = frame | (*pte & ~PAGE_FRAME_MASK & ~PAGE_COW) | PAGE_WRITE;
+    kpaging_flush(proc, vaddr);
+
+    return 0;
+}
+
+/**
+ * Selects the page directory to load when returning to a process
+ * @param proc - the process being returned to
+ * @return physical address of the page directory to load into CR3, or 0
+ *         if the loaded page directory is already correct
+ */
+unsigned int kpaging_switch(proc_t *proc) {
+    unsigned int dir = (unsigned int)kpaging_kernel_dir;
+
+    if (proc && proc->page_dir) {
+        dir = (unsigned int)proc->page_dir;
+    }
+
+    if (dir == kpaging_loaded && !kpaging_reload_always) {
+        return 0;
+    }
+
+    kpaging_loaded = dir;
+    kpaging_cr3_loads++;
+
+    return dir;
+}
+
+/**
+ * Forces a CR3 reload on every return to a process
+ * @param enabled - non-zero to always reload, zero to reload on change only
+ */
+void kpaging_always_reload(int enabled) {
+    kpaging_reload_always = enabled;
+}
+
+/**
+ * Fills in the page table memory counters
+ * @param stats - pointer to the statistics to fill in
+ */
+void kpaging_stats(mem_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    stats->page_dirs = kpaging_dirs;
+    stats->page_tables = kpaging_tables;
+    stats->mapped_pages = kpaging_pages;
+    stats->cr3_loads = kpaging_cr3_loads;
+    stats->cow_faults = kpaging_cow_faults;
+    stats->cow_copies = kpaging_cow_copies;
+    stats->zero_fills = kpaging_zero_fills;
+}
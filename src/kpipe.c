@@ -0,0 +1,373 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Pipes
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kpipe.h"
+#include "ksyscall.h"
+#include "queue.h"
+#include "scheduler.h"
+
+// Table of all pipes
+pipe_t pipes[PIPE_MAX];
+
+// Pipe ids to be allocated
+queue_t pipe_queue;
+
+/**
+ * Initializes kernel pipe data structures
+ * @return -1 on error, 0 on success
+ */
+int kpipes_init(void) {
+    kernel_log_info("Initializing kernel pipes");
+
+    // Initialize the pipe table
+    memset(&pipes, 0, sizeof(pipes));
+
+    // Initialize and fill the pipe queue
+    queue_init(&pipe_queue);
+    for (int i = 0; i < PIPE_MAX; i++) {
+        if (queue_in(&pipe_queue, i) != 0) {
+            kernel_log_warn("pipe: unable to queue pipe %d", i);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Looks up the pipe attached to a process' I/O slot
+ * @param proc - the process
+ * @param io - the I/O slot
+ * @return NULL if the slot is not a pipe end, otherwise the pipe
+ */
+static pipe_t *kpipe_get(proc_t *proc, int io) {
+    if (!proc || io < 0 || io >= PROC_IO_MAX) {
+        return NULL;
+    }
+
+    if (proc->io_type[io] != IO_TYPE_PIPE_READ &&
+        proc->io_type[io] != IO_TYPE_PIPE_WRITE) {
+        return NULL;
+    }
+
+    for (int i = 0; i < PIPE_MAX; i++) {
+        if (pipes[i].allocated && proc->io[io] == &pipes[i].buf) {
+            return &pipes[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Reschedules every process blocked on a pipe wait queue
+ * Each process repeats its read or write from its own context, so pipes
+ * never copy to or from the buffer of another process
+ * @param queue - the pipe wait queue
+ */
+static void kpipe_wake(queue_t *queue) {
+    proc_t *proc;
+    int pid;
+
+    while (queue_out(queue, &pid) == 0) {
+        proc = pid_to_proc(pid);
+        if (proc) {
+            scheduler_add(proc);
+        }
+    }
+}
+
+/**
+ * Blocks the active process on a pipe wait queue until its system call
+ * can make progress
+ * @param queue - the pipe wait queue
+ * @return -1 on error, 0 on success
+ */
+static int kpipe_block(queue_t *queue) {
+    if (queue_in(queue, active_proc->pid) != 0) {
+        return -1;
+    }
+
+    ksyscall_restart(active_proc);
+    active_proc->state = WAITING;
+    scheduler_remove(active_proc);
+    return 0;
+}
+
+/**
+ * Allocates a pipe and installs its ends into the given I/O slots
+ * @param reader - process receiving the read end
+ * @param read_io - I/O slot of the read end
+ * @param writer - process receiving the write end
+ * @param write_io - I/O slot of the write end
+ * @return -1 on error, otherwise the pipe id that was allocated
+ */
+int kpipe_attach(proc_t *reader, int read_io, proc_t *writer, int write_io) {
+    int id = -1;
+    pipe_t *pipe;
+
+    if (!reader || !writer) {
+        return -1;
+    }
+
+    if (read_io < 0 || read_io >= PROC_IO_MAX || write_io < 0 || write_io >= PROC_IO_MAX) {
+        return -1;
+    }
+
+    if (reader->io[read_io] || writer->io[write_io]) {
+        return -1;
+    }
+
+    if (reader == writer && read_io == write_io) {
+        return -1;
+    }
+
+    // Obtain a pipe id from the pipe queue
+    if (queue_out(&pipe_queue, &id) != 0) {
+        return -1;
+    }
+
+    pipe = &pipes[id];
+
+    memset(pipe, 0, sizeof(pipe_t));
+    pipe->allocated = 1;
+    pipe->readers = 1;
+    pipe->writers = 1;
+
+    reader->io[read_io] = &pipe->buf;
+    reader->io_type[read_io] = IO_TYPE_PIPE_READ;
+    writer->io[write_io] = &pipe->buf;
+    writer->io_type[write_io] = IO_TYPE_PIPE_WRITE;
+
+    return id;
+}
+
+/**
+ * Allocates a pipe with both ends installed in free I/O slots of the
+ * active process
+ * @param fds - fds[0] is set to the read end, fds[1] to the write end
+ * @return -1 on error, 0 on success
+ */
+int kpipe_open(int *fds) {
+    int slots[2] = {-1, -1};
+    int found = 0;
+
+    if (!active_proc || !fds) {
+        return -1;
+    }
+
+    for (int i = 0; i < PROC_IO_MAX && found < 2; i++) {
+        if (!active_proc->io[i]) {
+            slots[found++] = i;
+        }
+    }
+
+    if (found < 2) {
+        return -1;
+    }
+
+    if (kpipe_attach(active_proc, slots[0], active_proc, slots[1]) < 0) {
+        return -1;
+    }
+
+    fds[0] = slots[0];
+    fds[1] = slots[1];
+    return 0;
+}
+
+/**
+ * Reads up to n bytes from the pipe in the active process' I/O slot
+ * @param io - the I/O slot of the read end
+ * @param buf - the buffer to copy to
+ * @param n - number of bytes to read
+ * @return -1 on error, 0 at end of file, otherwise the bytes read
+ */
+int kpipe_read(int io, char *buf, int n) {
+    pipe_t *pipe = kpipe_get(active_proc, io);
+    int count;
+
+    if (!pipe || active_proc->io_type[io] != IO_TYPE_PIPE_READ || !buf || n < 0) {
+        return -1;
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    if (ringbuf_is_empty(&pipe->buf)) {
+        // End of file once every writer has closed
+        if (pipe->writers == 0) {
+            return 0;
+        }
+
+        // Read again once a writer has filled the buffer
+        return kpipe_block(&pipe->read_queue);
+    }
+
+    count = ringbuf_read_mem(&pipe->buf, buf, n);
+
+    // Let blocked writers fill the space
+    kpipe_wake(&pipe->write_queue);
+
+    return count;
+}
+
+/**
+ * Writes n bytes to the pipe in the active process' I/O slot
+ * @param io - the I/O slot of the write end
+ * @param buf - the buffer to copy from
+ * @param n - number of bytes to write
+ * @return -1 on error, otherwise the bytes written
+ */
+int kpipe_write(int io, char *buf, int n) {
+    pipe_t *pipe = kpipe_get(active_proc, io);
+    proc_t *proc;
+    int done;
+    int count;
+    int space;
+
+    if (!pipe || active_proc->io_type[io] != IO_TYPE_PIPE_WRITE || !buf || n < 0) {
+        return -1;
+    }
+
+    // A repeated write continues after the bytes it has already written
+    done = active_proc->wait_done;
+    active_proc->wait_done = 0;
+
+    if (pipe->readers == 0) {
+        return done ? done : -1;
+    }
+
+    space = RINGBUF_SIZE - pipe->buf.size;
+    count = (n - done < space) ? n - done : space;
+
+    if (count > 0) {
+        ringbuf_write_mem(&pipe->buf, &buf[done], count);
+        done += count;
+
+        // Let blocked readers take the data
+        kpipe_wake(&pipe->read_queue);
+    }
+
+    // Wait for readers to make room for the rest; the full size is
+    // returned once it has all been written
+    if (done < n) {
+        proc = active_proc;
+
+        if (kpipe_block(&pipe->write_queue) != 0) {
+            return done;
+        }
+
+        proc->wait_done = done;
+    }
+
+    return n;
+}
+
+/**
+ * Reports the readiness of the pipe end in a process' I/O slot
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return POLL_IN and/or POLL_OUT bits, 0 if not ready or not a pipe
+ */
+int kpipe_poll(proc_t *proc, int io) {
+    pipe_t *pipe = kpipe_get(proc, io);
+
+    if (!pipe) {
+        return 0;
+    }
+
+    // A closed peer is reported as ready so the caller sees EOF or an error
+    if (proc->io_type[io] == IO_TYPE_PIPE_READ) {
+        if (!ringbuf_is_empty(&pipe->buf) || pipe->writers == 0) {
+            return POLL_IN;
+        }
+    } else {
+        if (!ringbuf_is_full(&pipe->buf) || pipe->readers == 0) {
+            return POLL_OUT;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Counts another reference to the pipe end in a process' I/O slot
+ * Used when the slot has been copied into a new process by fork
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a pipe end, 0 on success
+ */
+int kpipe_dup(proc_t *proc, int io) {
+    pipe_t *pipe = kpipe_get(proc, io);
+
+    if (!pipe) {
+        return -1;
+    }
+
+    if (proc->io_type[io] == IO_TYPE_PIPE_READ) {
+        pipe->readers++;
+    } else {
+        pipe->writers++;
+    }
+
+    return 0;
+}
+
+/**
+ * Closes the pipe end in a process' I/O slot
+ * @param proc - the process owning the I/O slot
+ * @param io - the I/O slot
+ * @return -1 if the slot is not a pipe end, 0 on success
+ */
+int kpipe_close(proc_t *proc, int io) {
+    pipe_t *pipe = kpipe_get(proc, io);
+
+    if (!pipe) {
+        return -1;
+    }
+
+    if (proc->io_type[io] == IO_TYPE_PIPE_READ) {
+        pipe->readers--;
+        queue_remove(&pipe->read_queue, proc->pid);
+
+        // With no readers left, blocked writers return the number of
+        // bytes they managed to write
+        if (pipe->readers == 0) {
+            kpipe_wake(&pipe->write_queue);
+        }
+    } else {
+        pipe->writers--;
+        queue_remove(&pipe->write_queue, proc->pid);
+
+        // With no writers left, blocked readers see end of file
+        if (pipe->writers == 0) {
+            kpipe_wake(&pipe->read_queue);
+        }
+    }
+
+    proc->io[io] = NULL;
+    proc->io_type[io] = IO_TYPE_RINGBUF;
+
+    // Let processes polling the other end see the close
+    if (pipe->buf.notify) {
+        pipe->buf.notify(&pipe->buf);
+    }
+
+    // Release the pipe once both ends are closed
+    if (pipe->readers == 0 && pipe->writers == 0) {
+        int id = pipe - pipes;
+
+        memset(pipe, 0, sizeof(pipe_t));
+        queue_in(&pipe_queue, id);
+    }
+
+    return 0;
+}
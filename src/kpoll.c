@@ -0,0 +1,309 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel I/O Polling
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kpipe.h"
+#include "kpoll.h"
+#include "ksyscall.h"
+#include "scheduler.h"
+#include "timer.h"
+
+// Table of processes blocked in poll
+poller_t pollers[POLL_MAX];
+
+/**
+ * Reports the readiness of a process' I/O buffer
+ * @param proc - the process entry
+ * @param io - the I/O buffer id
+ * @return POLL_IN and/or POLL_OUT bits
+ */
+static int kpoll_ready(proc_t *proc, int io) {
+    int events = 0;
+
+    if (io < 0 || io >= PROC_IO_MAX || !proc->io[io]) {
+        return 0;
+    }
+
+    switch (proc->io_type[io]) {
+        case IO_TYPE_RINGBUF:
+            if (!ringbuf_is_empty(proc->io[io])) {
+                events |= POLL_IN;
+            }
+
+            if (!ringbuf_is_full(proc->io[io])) {
+                events |= POLL_OUT;
+            }
+            break;
+
+        case IO_TYPE_SPSC:
+            // Only the IRQ handler may write, so never report POLL_OUT
+            if (!spscbuf_is_empty(proc->io[io])) {
+                events |= POLL_IN;
+            }
+            break;
+
+        case IO_TYPE_FILE:
+            // Reads never block; at end of file they return 0
+            events |= POLL_IN;
+            break;
+
+        default:
+            return kpipe_poll(proc, io);
+    }
+
+    return events;
+}
+
+/**
+ * Fills in the returned events for each polled I/O buffer
+ * @param proc - the process entry
+ * @param fds - the I/O buffers being polled
+ * @param n - number of entries in fds
+ * @return the number of ready entries
+ */
+static int kpoll_scan(proc_t *proc, pollfd_t *fds, int n) {
+    int ready = 0;
+
+    for (int i = 0; i < n; i++) {
+        fds[i].revents = kpoll_ready(proc, fds[i].io) & fds[i].events;
+
+        if (fds[i].revents) {
+            ready++;
+        }
+    }
+
+    return ready;
+}
+
+/**
+ * Installs or clears the readiness hook of a polled I/O buffer
+ * @param proc - the process entry
+ * @param io - the I/O buffer id
+ * @param hook - non-zero to install the hook, zero to clear it
+ */
+static void kpoll_hook(proc_t *proc, int io, int hook) {
+    if (io < 0 || io >= PROC_IO_MAX || !proc->io[io]) {
+        return;
+    }
+
+    switch (proc->io_type[io]) {
+        case IO_TYPE_RINGBUF:
+        case IO_TYPE_PIPE_READ:
+        case IO_TYPE_PIPE_WRITE:
+            // Pipe ends refer to the pipe's ring buffer
+            ((ringbuf_t *)proc->io[io])->notify = hook ? kpoll_notify : NULL;
+            break;
+
+        case IO_TYPE_SPSC:
+            ((spscbuf_t *)proc->io[io])->notify = hook ? kpoll_notify_spsc : NULL;
+            break;
+
+        default:
+            // Files are always ready and never need a hook
+            break;
+    }
+}
+
+/**
+ * Indicates if a poll table entry other than the given one polls a buffer
+ * @param skip - the poll table entry to ignore
+ * @param buf - the I/O buffer
+ * @return 1 if the buffer is polled, 0 if not
+ */
+static int kpoll_polled(poller_t *skip, void *buf) {
+    for (int i = 0; i < POLL_MAX; i++) {
+        if (&pollers[i] == skip || !pollers[i].proc) {
+            continue;
+        }
+
+        for (int j = 0; j < pollers[i].n; j++) {
+            int io = pollers[i].fds[j].io;
+
+            if (io >= 0 && io < PROC_IO_MAX && pollers[i].proc->io[io] == buf) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Frees a poll table entry
+ * The hooks of its buffers are cleared unless another process polls them,
+ * so buffers nobody polls are not scanned on every change
+ * @param poller - the poll table entry
+ */
+static void kpoll_release(poller_t *poller) {
+    for (int i = 0; i < poller->n; i++) {
+        int io = poller->fds[i].io;
+
+        if (io >= 0 && io < PROC_IO_MAX && !kpoll_polled(poller, poller->proc->io[io])) {
+            kpoll_hook(poller->proc, io, 0);
+        }
+    }
+
+    memset(poller, 0, sizeof(poller_t));
+}
+
+/**
+ * Reschedules a polling process
+ * The process repeats the poll with the ticks it has left, which fills in
+ * revents from its own context
+ * @param poller - the poll table entry
+ */
+static void kpoll_wake(poller_t *poller) {
+    proc_t *proc = poller->proc;
+
+    ksyscall_restart_arg(proc, 3, (unsigned int)poller->timeout);
+    kpoll_release(poller);
+
+    scheduler_add(proc);
+}
+
+/**
+ * Expires poll timeouts, once per timer tick
+ */
+void kpoll_timer(void) {
+    for (int i = 0; i < POLL_MAX; i++) {
+        if (!pollers[i].proc || pollers[i].timeout < 0) {
+            continue;
+        }
+
+        if (--pollers[i].timeout <= 0) {
+            pollers[i].timeout = 0;
+            kpoll_wake(&pollers[i]);
+        }
+    }
+}
+
+/**
+ * Initializes kernel poll data structures
+ * @return -1 on error, 0 on success
+ */
+int kpolls_init(void) {
+    kernel_log_info("Initializing kernel poll");
+
+    memset(&pollers, 0, sizeof(pollers));
+
+    // Expire poll timeouts every tick
+    if (timer_callback_register(&kpoll_timer, 1, -1) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Waits until any of the active process' I/O buffers is ready
+ * @param fds - I/O buffers and requested events; revents is filled in
+ * @param n - number of entries in fds
+ * @param timeout - ticks to wait, 0 to return immediately, -1 to wait forever
+ * @return -1 on error, otherwise the number of ready entries (0 on timeout)
+ */
+int kpoll(pollfd_t *fds, int n, int timeout) {
+    poller_t *poller = NULL;
+    int ready;
+
+    if (!active_proc || !fds || n <= 0 || n > POLL_FDS_MAX) {
+        return -1;
+    }
+
+    ready = kpoll_scan(active_proc, fds, n);
+    if (ready > 0 || timeout == 0) {
+        return ready;
+    }
+
+    for (int i = 0; i < POLL_MAX; i++) {
+        if (!pollers[i].proc) {
+            poller = &pollers[i];
+            break;
+        }
+    }
+
+    if (!poller) {
+        return -1;
+    }
+
+    // The buffers are staged in the poll table, since fds is only
+    // reachable while this process' page directory is loaded
+    poller->proc = active_proc;
+    memcpy(poller->fds, fds, n * sizeof(pollfd_t));
+    poller->n = n;
+    poller->timeout = (timeout < 0) ? -1 : timeout;
+
+    // Hook each polled buffer so changes wake the process
+    for (int i = 0; i < n; i++) {
+        kpoll_hook(active_proc, fds[i].io, 1);
+    }
+
+    ksyscall_restart(active_proc);
+    active_proc->state = WAITING;
+    scheduler_remove(active_proc);
+    return 0;
+}
+
+/**
+ * Wakes the polling processes that reference the given buffer and are ready
+ * @param buf - the I/O buffer whose contents changed
+ */
+static void kpoll_notify_buf(void *buf) {
+    poller_t *poller;
+
+    for (int i = 0; i < POLL_MAX; i++) {
+        poller = &pollers[i];
+
+        if (!poller->proc) {
+            continue;
+        }
+
+        for (int j = 0; j < poller->n; j++) {
+            int io = poller->fds[j].io;
+
+            if (io < 0 || io >= PROC_IO_MAX || poller->proc->io[io] != buf) {
+                continue;
+            }
+
+            if (kpoll_scan(poller->proc, poller->fds, poller->n) > 0) {
+                kpoll_wake(poller);
+            }
+
+            break;
+        }
+    }
+}
+
+/**
+ * Readiness hook for ring buffers being polled
+ * @param buf - the ring buffer whose contents changed
+ */
+void kpoll_notify(ringbuf_t *buf) {
+    kpoll_notify_buf(buf);
+}
+
+/**
+ * Readiness hook for SPSC buffers being polled
+ * @param buf - the SPSC buffer whose contents changed
+ */
+void kpoll_notify_spsc(spscbuf_t *buf) {
+    kpoll_notify_buf(buf);
+}
+
+/**
+ * Removes a process from the poll waiters (if it is polling)
+ * @param proc - the process entry
+ */
+void kpoll_cancel(proc_t *proc) {
+    for (int i = 0; i < POLL_MAX; i++) {
+        if (pollers[i].proc == proc) {
+            kpoll_release(&pollers[i]);
+        }
+    }
+}
@@ -18,19 +18,36 @@
 #include "queue.h"
 #include "vga.h"
 #include "prog_user.h"
+#include "prog_bench.h"
 #include "syscall_common.h"
+#include "kpipe.h"
+#include "kpoll.h"
+#include "kpaging.h"
+#include "kelf.h"
+#include "kfs.h"
+#include "kfpu.h"
+#include "kmutex.h"
+#include "krwlock.h"
 
 // Next available process id to be assigned
 int next_pid;
 
-// Process table allocator
-queue_t proc_allocator;
-
 // Process table
-proc_t proc_table[PROC_MAX];
+kslab_t proc_table;
+
+// Process id lookup table, chained through proc_t.hash_next
+proc_t *proc_hash[PROC_HASH_SIZE];
 
-// Process stacks
-unsigned char proc_stack[PROC_MAX][PROC_STACK_SIZE];
+// Process stack pools, indexed by stack class
+stack_pool_t proc_stack_pools[STACK_CLASS_MAX];
+
+// Stack size and stacks per slab of each stack class
+const int proc_stack_geometry[STACK_CLASS_MAX][2] = {
+    { 4 * 1024,   16 },
+    { 8 * 1024,   8 },
+    { 32 * 1024,  2 },
+    { 128 * 1024, 1 },
+};
 
 /**
  * Looks up a process in the process table via the process id
@@ -38,10 +55,14 @@ unsigned char proc_stack[PROC_MAX][PROC_STACK_SIZE];
  * @return pointer to the pruocess entry, NULL or error or if not found
  */
 proc_t *pid_to_proc(int pid) {
-    for (unsigned int i = 0; i < PROC_MAX; i++) {
-        if (proc_table[i].pid == pid) {
-            return &proc_table[i];
+    proc_t *proc = proc_hash[pid & (PROC_HASH_SIZE - 1)];
+
+    while (proc) {
+        if (proc->pid == pid) {
+            return proc;
         }
+
+        proc = proc->hash_next;
     }
 
     return NULL;
@@ -57,60 +78,172 @@ int proc_to_entry(proc_t *proc) {
         return -1;
     }
 
-    for (unsigned int i = 0; i < PROC_MAX; i++) {
-        if (proc->pid == proc_table[i].pid) {
-            return i;
-        }
-    }
-
-    return -1;
+    return proc->entry;
 }
 
 /**
  * Returns a pointer to the given process entry
+ * @return NULL if the entry is not in use
  */
 proc_t * entry_to_proc(int entry) {
-    if (entry >= 0 && entry < PROC_MAX) {
-        return &proc_table[entry];
+    if (kslab_is_allocated(&proc_table, entry)) {
+        return kslab_get(&proc_table, entry);
     }
 
     return NULL;
 }
 
 /**
- * Creates a new process
- * @param proc_ptr - address of process to execute
+ * Adds a process to the process id lookup table
+ * @param proc - pointer to the process entry
+ */
+static void kproc_hash_add(proc_t *proc) {
+    proc_t **bucket = &proc_hash[proc->pid & (PROC_HASH_SIZE - 1)];
+
+    proc->hash_next = *bucket;
+    *bucket = proc;
+}
+
+/**
+ * Removes a process from the process id lookup table
+ * @param proc - pointer to the process entry
+ */
+static void kproc_hash_remove(proc_t *proc) {
+    proc_t **link = &proc_hash[proc->pid & (PROC_HASH_SIZE - 1)];
+
+    while (*link) {
+        if (*link == proc) {
+            *link = proc->hash_next;
+            return;
+        }
+
+        link = &(*link)->hash_next;
+    }
+}
+
+/**
+ * Adds a free stack to the stacks waiting to be zeroed by the idle process
+ * @param pool - the stack pool
+ * @param slot - the stack slot
+ */
+static void kproc_stack_dirty(stack_pool_t *pool, int slot) {
+    stack_slot_t *meta = kslab_meta(&pool->slab, slot);
+
+    meta->state = STACK_DIRTY;
+    meta->dirty_prev = -1;
+    meta->dirty_next = pool->dirty;
+
+    if (pool->dirty >= 0) {
+        ((stack_slot_t *)kslab_meta(&pool->slab, pool->dirty))->dirty_prev = slot;
+    }
+
+    pool->dirty = slot;
+}
+
+/**
+ * Removes a stack from the stacks waiting to be zeroed
+ * @param pool - the stack pool
+ * @param slot - the stack slot, which must be dirty
+ */
+static void kproc_stack_undirty(stack_pool_t *pool, int slot) {
+    stack_slot_t *meta = kslab_meta(&pool->slab, slot);
+
+    if (meta->dirty_prev >= 0) {
+        ((stack_slot_t *)kslab_meta(&pool->slab, meta->dirty_prev))->dirty_next = meta->dirty_next;
+    } else {
+        pool->dirty = meta->dirty_next;
+    }
+
+    if (meta->dirty_next >= 0) {
+        ((stack_slot_t *)kslab_meta(&pool->slab, meta->dirty_next))->dirty_prev = meta->dirty_prev;
+    }
+}
+
+/**
+ * Maps a process' stack at the stack address of an address space
+ * The stack pages stay owned by the stack pool
+ * @param space - the process entry holding the page directory
+ * @param proc - the process whose stack is mapped
+ * @return -1 on error, 0 on success
+ */
+static int kproc_stack_map(proc_t *space, proc_t *proc) {
+    unsigned int vaddr = KPAGING_STACK_END - proc->stack_size;
+
+    for (int offset = 0; offset < proc->stack_size; offset += KPAGE_SIZE) {
+        if (kpaging_map_frame(space, vaddr + offset, (unsigned int)&proc->stack[offset],
+                              PAGE_WRITE | PAGE_PINNED) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Allocates and initializes a process entry and stack
+ * The process is not scheduled and its trapframe holds no context
  * @param proc_name - "friendly" process name
  * @param proc_type - process type (kernel or user)
- * @return process id of the created process, -1 on error
+ * @param stack_class - size class of the process stack
+ * @return NULL on error, otherwise the new process entry
  */
-int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type) {
+static proc_t *kproc_alloc(char *proc_name, proc_type_t proc_type, stack_class_t stack_class) {
+    stack_pool_t *pool;
+    stack_slot_t *meta;
     int proc_entry;
+    int stack_slot;
+    int capacity;
     proc_t *proc;
 
-    // Ensure that valid parameters have been specified
-    if (proc_name == NULL) {
-        kernel_panic("Invalid process title\n");
+    if (stack_class < 0 || stack_class >= STACK_CLASS_MAX) {
+        kernel_log_warn("Invalid stack class %d", stack_class);
+        return NULL;
     }
 
-    if (proc_ptr == NULL) {
-        kernel_panic("Invalid function pointer");
-    }
+    pool = &proc_stack_pools[stack_class];
 
     // Allocate the PCB entry for the process
-    if (queue_out(&proc_allocator, &proc_entry) != 0) {
+    proc_entry = kslab_alloc(&proc_table);
+    if (proc_entry < 0) {
         kernel_log_warn("Unable to allocate a process entry");
-        return -1;
+        return NULL;
+    }
+
+    // Allocate the stack for the process
+    capacity = kslab_capacity(&pool->slab);
+    stack_slot = kslab_alloc(&pool->slab);
+    if (stack_slot < 0) {
+        kernel_log_warn("Unable to allocate a %d byte process stack", pool->slab.size);
+        kslab_free(&proc_table, proc_entry);
+        return NULL;
+    }
+
+    // Slab memory is not zeroed, so the stacks of a new slab start out dirty
+    for (int i = capacity; i < kslab_capacity(&pool->slab); i++) {
+        kproc_stack_dirty(pool, i);
     }
 
     // Allocate the process table entry
-    proc = &proc_table[proc_entry];
+    proc = kslab_get(&proc_table, proc_entry);
 
     // Initialize the PCB entry for the process
     memset(proc, 0, sizeof(proc_t));
+    proc->entry = proc_entry;
 
     // Point the stack to the process stack
-    proc->stack = proc_stack[proc_entry];
+    proc->stack = kslab_get(&pool->slab, stack_slot);
+    proc->stack_size = pool->slab.size;
+    proc->stack_class = stack_class;
+    proc->stack_slot = stack_slot;
+
+    // The process sees its stack at the top of its private region
+    if (kproc_stack_map(proc, proc) != 0) {
+        kernel_log_warn("Unable to map a %d byte process stack", pool->slab.size);
+        kpaging_proc_destroy(proc);
+        kslab_free(&pool->slab, stack_slot);
+        kslab_free(&proc_table, proc_entry);
+        return NULL;
+    }
 
     // Set the process state to RUNNING
     // Initialize other process control block variables to default values
@@ -124,14 +257,39 @@ int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type) {
     // Copy the process name to the PCB
     strncpy(proc->name, proc_name, PROC_NAME_LEN);
 
-    // Ensure the stack for the process is cleared
-    memset(proc->stack, 0, PROC_STACK_SIZE);
+    // Make the process visible to pid lookups
+    kproc_hash_add(proc);
 
     // Allocate the trapframe data
-    proc->trapframe = (trapframe_t *)(&proc->stack[PROC_STACK_SIZE - sizeof(trapframe_t)]);
+    proc->trapframe = (trapframe_t *)(&proc->stack[proc->stack_size - sizeof(trapframe_t)]);
+
+    // Only the trapframe needs to be initialized; the rest of the stack is
+    // scrubbed by the idle process after the previous owner exits
+    meta = kslab_meta(&pool->slab, stack_slot);
+    if (meta->state != STACK_CLEAN) {
+        memset(proc->trapframe, 0, sizeof(trapframe_t));
+    }
+
+    if (meta->state == STACK_DIRTY) {
+        kproc_stack_undirty(pool, stack_slot);
+    }
+
+    meta->state = STACK_IN_USE;
 
+    // Mark the lowest word of the stack to detect overflows
+    *(unsigned int *)proc->stack = PROC_STACK_CANARY;
+
+    return proc;
+}
+
+/**
+ * Points a process' trapframe at the start of a program
+ * @param proc - pointer to the process entry
+ * @param entry - address of the first instruction
+ */
+static void kproc_start(proc_t *proc, unsigned int entry) {
     // Set the instruction pointer in the trapframe
-    proc->trapframe->eip = (unsigned int)proc_ptr;
+    proc->trapframe->eip = entry;
 
     // Set INTR flag
     proc->trapframe->eflags = EF_DEFAULT_VALUE | EF_INTR;
@@ -142,15 +300,151 @@ int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type) {
     proc->trapframe->es = get_es();
     proc->trapframe->fs = get_fs();
     proc->trapframe->gs = get_gs();
+}
+
+/**
+ * Creates a new process
+ * @param proc_ptr - address of process to execute
+ * @param proc_name - "friendly" process name
+ * @param proc_type - process type (kernel or user)
+ * @param stack_class - size class of the process stack
+ * @return process id of the created process, -1 on error
+ */
+int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type, stack_class_t stack_class) {
+    proc_t *proc;
+
+    // Ensure that valid parameters have been specified
+    if (proc_name == NULL) {
+        kernel_panic("Invalid process title\n");
+    }
+
+    if (proc_ptr == NULL) {
+        kernel_panic("Invalid function pointer");
+    }
+
+    proc = kproc_alloc(proc_name, proc_type, stack_class);
+    if (!proc) {
+        return -1;
+    }
+
+    kproc_start(proc, (unsigned int)proc_ptr);
 
     // Add the process to the run queue
     scheduler_add(proc);
 
-    kernel_log_info("Created process %s (%d) entry=%d", proc->name, proc->pid, proc_entry);
+    kernel_log_trace("Created process %s (%d) entry=%d", proc->name, proc->pid, proc_to_entry(proc));
+
+    return proc->pid;
+}
+
+/**
+ * Creates a copy of a process
+ * The copy gets its own stack holding the parent's stack contents, mapped
+ * at the same address, shares the parent's I/O buffers and shares its
+ * private memory copy-on-write. It resumes from the parent's trapframe
+ * with 0 as the syscall result.
+ * @param parent - the process to copy
+ * @return process id of the new process, -1 on error
+ */
+int kproc_fork(proc_t *parent) {
+    proc_t *proc;
+    int offset;
+
+    if (!parent || parent->pid == 0) {
+        return -1;
+    }
+
+    proc = kproc_alloc(parent->name, parent->type, parent->stack_class);
+    if (!proc) {
+        return -1;
+    }
+
+    // Copy the used part of the stack, from the trapframe up. Both stacks
+    // are mapped at the same address, so saved frame pointers and pointers
+    // to locals in the copy are valid as they are.
+    offset = (unsigned char *)parent->trapframe - parent->stack;
+    memcpy(&proc->stack[offset], parent->trapframe, parent->stack_size - offset);
+    proc->trapframe = (trapframe_t *)&proc->stack[offset];
+
+    // The new process sees fork return 0
+    proc->trapframe->eax = 0;
+
+    for (int i = 0; i < PROC_IO_MAX; i++) {
+        proc->io[i] = parent->io[i];
+        proc->io_type[i] = parent->io_type[i];
+
+        if (proc->io_type[i] == IO_TYPE_PIPE_READ || proc->io_type[i] == IO_TYPE_PIPE_WRITE) {
+            kpipe_dup(proc, i);
+        } else if (proc->io_type[i] == IO_TYPE_FILE) {
+            kfs_dup(proc, i);
+        }
+    }
+
+    if (kfpu_fork(parent, proc) != 0) {
+        kernel_log_warn("Unable to copy the FPU state of process %s (%d)", parent->name, parent->pid);
+        kproc_destroy(proc);
+        return -1;
+    }
+
+    if (kpaging_fork(parent, proc) != 0) {
+        kernel_log_warn("Unable to share the memory of process %s (%d)", parent->name, parent->pid);
+        kproc_destroy(proc);
+        return -1;
+    }
+
+    scheduler_add(proc);
+
+    kernel_log_debug("Forked process %s (%d) from %d", proc->name, proc->pid, parent->pid);
 
     return proc->pid;
 }
 
+/**
+ * Replaces a process' program with a program image
+ * The new program is loaded into a separate address space first, so on
+ * error the process continues unchanged. I/O buffers stay open.
+ * @param proc - pointer to the process entry
+ * @param name - name of the program image
+ * @return -1 on error, 0 on success
+ */
+int kproc_exec(proc_t *proc, char *name) {
+    kelf_image_t *image = kelf_find(name);
+    proc_t loaded;
+    unsigned int entry;
+
+    if (!proc || proc->pid == 0 || !image) {
+        return -1;
+    }
+
+    // Build the new address space on a scratch process entry
+    memset(&loaded, 0, sizeof(proc_t));
+
+    if (kelf_load(&loaded, image->data, image->size, &entry) != 0 ||
+        kproc_stack_map(&loaded, proc) != 0) {
+        kpaging_proc_destroy(&loaded);
+        return -1;
+    }
+
+    kpaging_proc_destroy(proc);
+    proc->page_dir = loaded.page_dir;
+    proc->zero_start = loaded.zero_start;
+    proc->zero_end = loaded.zero_end;
+
+    strncpy(proc->name, image->name, PROC_NAME_LEN);
+
+    // The new program starts with a clean FPU
+    kfpu_release(proc);
+
+    // Start over with an empty stack
+    proc->trapframe = (trapframe_t *)(&proc->stack[proc->stack_size - sizeof(trapframe_t)]);
+    memset(proc->trapframe, 0, sizeof(trapframe_t));
+    kproc_start(proc, entry);
+
+    kernel_log_debug("Process %d running image %s at 0x%x", proc->pid, proc->name, entry);
+
+    return 0;
+}
+
 /**
  * Destroys a process
  * If the process is currently scheduled it must be unscheduled
@@ -177,22 +471,204 @@ int kproc_destroy(proc_t *proc) {
         kernel_panic("Error obtaining the process table entry");
     }
 
-    kernel_log_info("Destroying process %s (%d) entry=%d", proc->name, proc->pid, entry);
+    kernel_log_trace("Destroying process %s (%d) entry=%d", proc->name, proc->pid, entry);
+
+    // Stop waiting on I/O buffers
+    kpoll_cancel(proc);
 
-    // Reset the process stack
-    memset(proc->stack, 0, PROC_STACK_SIZE);
+    // Hand the mutexes held by the process to their waiters
+    kmutex_release(proc);
+
+    // Close the process I/O buffers so pipe peers see the exit
+    for (int i = 0; i < PROC_IO_MAX; i++) {
+        kproc_io_close(proc, i);
+    }
+
+    // Release private memory, the page directory and the FPU state
+    kpaging_proc_destroy(proc);
+    kfpu_release(proc);
+
+    // Leave the stack to be scrubbed by the idle process
+    stack_pool_t *pool = &proc_stack_pools[proc->stack_class];
+    kproc_stack_dirty(pool, proc->stack_slot);
+
+    if (kslab_free(&pool->slab, proc->stack_slot) != 0) {
+        kernel_log_warn("Unable to free the process stack");
+    }
+
+    kproc_hash_remove(proc);
 
     // Reset the process control block
     memset(proc, 0, sizeof(proc_t));
 
-    // Add the entry back to the process queue (to be recycled)
-    if (queue_in(&proc_allocator, entry) != 0) {
-        kernel_log_warn("Unable to queue entry back into allocator");
+    // Free the entry (to be recycled)
+    if (kslab_free(&proc_table, entry) != 0) {
+        kernel_log_warn("Unable to free the process entry");
     }
 
     return 0;
 }
 
+/**
+ * Closes a process' I/O buffer
+ * @param proc - pointer to the process entry
+ * @param io - the I/O buffer to close
+ * @return 0 on success, -1 on error
+ */
+int kproc_io_close(proc_t *proc, int io) {
+    if (!proc || io < 0 || io >= PROC_IO_MAX) {
+        return -1;
+    }
+
+    if (!proc->io[io]) {
+        return -1;
+    }
+
+    if (proc->io_type[io] == IO_TYPE_PIPE_READ ||
+        proc->io_type[io] == IO_TYPE_PIPE_WRITE) {
+        return kpipe_close(proc, io);
+    }
+
+    if (proc->io_type[io] == IO_TYPE_FILE) {
+        return kfs_close(proc, io);
+    }
+
+    proc->io[io] = NULL;
+    proc->io_type[io] = IO_TYPE_RINGBUF;
+    return 0;
+}
+
+/**
+ * Zeroes the stack of one exited process
+ * Each pool keeps its dirty stacks on a list, so finding one does not
+ * depend on the number of stacks. The stack is cleared in chunks with interrupts disabled so that, if the
+ * entry is reallocated part way through, no chunk is cleared after the
+ * new process starts using it.
+ * @return 1 if a stack was zeroed, 0 if no stack needed zeroing
+ */
+int kproc_stack_scrub(void) {
+    stack_pool_t *pool = NULL;
+    stack_slot_t *meta = NULL;
+    unsigned char *stack;
+    int slot = -1;
+
+    asm("cli");
+    for (int c = 0; c < STACK_CLASS_MAX; c++) {
+        if (proc_stack_pools[c].dirty >= 0) {
+            pool = &proc_stack_pools[c];
+            slot = pool->dirty;
+            kproc_stack_undirty(pool, slot);
+
+            meta = kslab_meta(&pool->slab, slot);
+            meta->state = STACK_ZEROING;
+            break;
+        }
+    }
+    asm("sti");
+
+    if (!pool) {
+        return 0;
+    }
+
+    stack = kslab_get(&pool->slab, slot);
+
+    for (int offset = 0; offset < pool->slab.size; offset += PROC_STACK_SCRUB_CHUNK) {
+        asm("cli");
+        if (meta->state != STACK_ZEROING) {
+            // Reallocated while zeroing
+            asm("sti");
+            return 1;
+        }
+
+        memset(&stack[offset], 0, PROC_STACK_SCRUB_CHUNK);
+        asm("sti");
+    }
+
+    asm("cli");
+    if (meta->state == STACK_ZEROING) {
+        meta->state = STACK_CLEAN;
+    }
+    asm("sti");
+
+    return 1;
+}
+
+/**
+ * Translates an address on a process' stack from where the process sees it
+ * (the stack region of its page directory) to where the kernel sees it
+ * @param proc - pointer to the process entry
+ * @param addr - address in the process' stack region
+ * @return the kernel address, or addr if it is not in the stack region
+ */
+void *kproc_stack_to_kernel(proc_t *proc, void *addr) {
+    unsigned int base;
+
+    if (!proc || !proc->stack) {
+        return addr;
+    }
+
+    base = KPAGING_STACK_END - proc->stack_size;
+
+    if ((unsigned int)addr < base || (unsigned int)addr >= KPAGING_STACK_END) {
+        return addr;
+    }
+
+    return &proc->stack[(unsigned int)addr - base];
+}
+
+/**
+ * Translates an address on a process' stack from where the kernel sees it
+ * to where the process sees it
+ * @param proc - pointer to the process entry
+ * @param addr - kernel address in the process' stack
+ * @return the address in the process' stack region, or addr if it is not
+ *         in the process' stack
+ */
+void *kproc_stack_to_proc(proc_t *proc, void *addr) {
+    unsigned char *p = addr;
+
+    if (!proc || !proc->stack || p < proc->stack || p >= proc->stack + proc->stack_size) {
+        return addr;
+    }
+
+    return (void *)(KPAGING_STACK_END - proc->stack_size + (p - proc->stack));
+}
+
+/**
+ * Checks that a process has not overflowed its stack
+ * A process that has overflowed its stack is killed
+ * @param proc - pointer to the process entry
+ * @param trapframe - the trapframe the process entered the kernel with
+ * @return -1 if the process overflowed its stack and was killed, 0 otherwise
+ */
+int kproc_stack_check(proc_t *proc, trapframe_t *trapframe) {
+    unsigned int base;
+
+    if (!proc || !proc->stack) {
+        return 0;
+    }
+
+    // The trapframe is pushed onto the process stack, unless the process
+    // ran off the base of the stack and entered from a double fault
+    base = KPAGING_STACK_END - proc->stack_size;
+
+    if ((unsigned int)trapframe >= base && (unsigned int)trapframe < KPAGING_STACK_END &&
+        *(unsigned int *)proc->stack == PROC_STACK_CANARY) {
+        return 0;
+    }
+
+    // The idle process cannot be replaced
+    if (proc->pid == 0) {
+        kernel_panic("Stack overflow in the idle process, stack size %d", proc->stack_size);
+    }
+
+    kernel_log_error("Stack overflow in process %s (%d), stack size %d",
+                     proc->name, proc->pid, proc->stack_size);
+
+    kproc_destroy(proc);
+    return -1;
+}
+
 /**
  * Idle Process
  */
@@ -201,6 +677,11 @@ void kproc_idle(void) {
         // Ensure interrupts are enabled
         asm("sti");
 
+        // Use idle time to clear the stacks of exited processes
+        if (kproc_stack_scrub()) {
+            continue;
+        }
+
         // Halt the CPU
         asm("hlt");
     }
@@ -227,7 +708,9 @@ int kproc_attach_tty(int pid, int tty_number) {
     if (proc && tty) {
         kernel_log_debug("Attaching PID %d to TTY id %d", proc->pid, tty_number);
         proc->io[PROC_IO_IN] = &tty->io_input;
+        proc->io_type[PROC_IO_IN] = IO_TYPE_SPSC;
         proc->io[PROC_IO_OUT] = &tty->io_output;
+        proc->io_type[PROC_IO_OUT] = IO_TYPE_RINGBUF;
         return 0;
     }
 
@@ -244,27 +727,61 @@ void kproc_init(void) {
 
     kernel_log_info("Initializing process management");
 
-    // Initialize the process queue
-    queue_init(&proc_allocator);
-
-    // Populate the process queue
-    for (int i = 0; i < PROC_MAX; i++) {
-        queue_in(&proc_allocator, i);
-    }
-
-    // Initialize the process table
-    memset(&proc_table, 0, sizeof(proc_table));
+    // Initialize the process table; entries are added 32 at a time
+    kslab_init(&proc_table, "proc", sizeof(proc_t), 0, KSLAB_OBJS_PER_SLAB_MAX,
+               PROC_MAX / KSLAB_OBJS_PER_SLAB_MAX);
+    memset(proc_hash, 0, sizeof(proc_hash));
 
     // Initialize the process stacks
-    memset(proc_stack, 0, sizeof(proc_stack));
+    for (int c = 0; c < STACK_CLASS_MAX; c++) {
+        stack_pool_t *pool = &proc_stack_pools[c];
+
+        kslab_init(&pool->slab, "stack", proc_stack_geometry[c][0], sizeof(stack_slot_t),
+                   proc_stack_geometry[c][1],
+                   (PROC_MAX + proc_stack_geometry[c][1] - 1) / proc_stack_geometry[c][1]);
+        pool->dirty = -1;
+    }
 
     // Create/execute the idle process (kproc_idle)
-    pid = kproc_create(kproc_idle, "idle", PROC_TYPE_KERNEL);
+    pid = kproc_create(kproc_idle, "idle", PROC_TYPE_KERNEL, STACK_CLASS_4K);
 
     kernel_log_info("Created idle process %d", pid);
 
+#ifdef BENCH
+    // Start the benchmark processes instead of the user programs; the
+    // rwlock readers share locks that exist before any of them runs
+    bench_rwlock_mutex = kmutex_init();
+    bench_rwlock_lock = krwlock_init(RWLOCK_PREFER_READER);
+
+    for (int i = 0; i < BENCH_RWLOCK_READERS; i++) {
+        pid = kproc_create(prog_bench_rwlock, "bench_rwlock", PROC_TYPE_USER, PROC_STACK_DEFAULT);
+        kproc_attach_tty(pid, BENCH_TTY);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        pid = kproc_create(prog_bench_msg, "bench_msg", PROC_TYPE_USER, PROC_STACK_DEFAULT);
+        kproc_attach_tty(pid, BENCH_TTY);
+    }
+
+    // The pipe benchmark processes are connected to each other by a pipe
+    int writer = kproc_create(prog_bench_pipe_writer, "bench_pipe_w", PROC_TYPE_USER, PROC_STACK_DEFAULT);
+    kproc_attach_tty(writer, BENCH_TTY);
+
+    pid = kproc_create(prog_bench_pipe_reader, "bench_pipe_r", PROC_TYPE_USER, PROC_STACK_DEFAULT);
+    kproc_attach_tty(pid, BENCH_TTY);
+
+    kpipe_attach(pid_to_proc(pid), BENCH_PIPE_IO, pid_to_proc(writer), BENCH_PIPE_IO);
+
+    pid = kproc_create(prog_bench_solo, "bench_solo", PROC_TYPE_USER, PROC_STACK_DEFAULT);
+    kproc_attach_tty(pid, BENCH_TTY);
+
+    for (int i = 0; i < 2; i++) {
+        pid = kproc_create(prog_bench_pair, "bench_pair", PROC_TYPE_USER, PROC_STACK_DEFAULT);
+        kproc_attach_tty(pid, BENCH_TTY);
+    }
+#else
     for (int i = 1; i < 5; i++) {
-        pid = kproc_create(prog_shell, "shell", PROC_TYPE_USER);
+        pid = kproc_create(prog_shell, "shell", PROC_TYPE_USER, PROC_STACK_DEFAULT);
 
         kernel_log_debug("Created shell process %d", pid);
 
@@ -273,16 +790,17 @@ void kproc_init(void) {
     }
 
     for (int i = 0; i < 3; i++) {
-        pid = kproc_create(prog_ping, "ping", PROC_TYPE_USER);
+        pid = kproc_create(prog_ping, "ping", PROC_TYPE_USER, PROC_STACK_DEFAULT);
         kernel_log_debug("Created ping process %d", pid);
 
         kproc_attach_tty(pid, (TTY_MAX - (pid % 2) - 1));
     }
 
     for (int i = 0; i < 3; i++) {
-        pid = kproc_create(prog_pong, "pong", PROC_TYPE_USER);
+        pid = kproc_create(prog_pong, "pong", PROC_TYPE_USER, PROC_STACK_DEFAULT);
         kernel_log_debug("Created pong process %d", pid);
 
         kproc_attach_tty(pid, (TTY_MAX - (pid % 2) - 1));
     }
+#endif
 }
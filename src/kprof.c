@@ -0,0 +1,172 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Sampling Profiler
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kproc.h"
+#include "kprof.h"
+
+#if (PROF_BUCKETS & (PROF_BUCKETS - 1)) != 0
+#error "PROF_BUCKETS must be a power of two"
+#endif
+
+prof_sample_t prof_table[PROF_BUCKETS];
+
+int prof_interval;              // Ticks between samples (0 when stopped)
+int prof_countdown;             // Ticks until the next sample
+int prof_samples;               // Samples taken
+int prof_dropped;               // Samples with no free histogram entry
+
+/**
+ * Returns the first histogram entry to probe for a sample
+ * @param eip - instruction address
+ * @param pid - process id
+ * @return the entry index
+ */
+static int kprof_hash(unsigned int eip, int pid) {
+    return ((eip >> 2) * 2654435761u + pid) & (PROF_BUCKETS - 1);
+}
+
+/**
+ * Orders histogram entries by descending count, then by index
+ * @param a - index of the first entry
+ * @param b - index of the second entry
+ * @return non-zero if entry a comes before entry b
+ */
+static int kprof_before(int a, int b) {
+    if (prof_table[a].count != prof_table[b].count) {
+        return prof_table[a].count > prof_table[b].count;
+    }
+
+    return a < b;
+}
+
+/**
+ * Starts profiling, clearing the previous profile
+ * @param interval - timer ticks between samples (1 samples on every tick)
+ * @return -1 on error, 0 on success
+ */
+int kprof_start(int interval) {
+    if (interval <= 0) {
+        return -1;
+    }
+
+    memset(prof_table, 0, sizeof(prof_table));
+    prof_samples = 0;
+    prof_dropped = 0;
+    prof_countdown = interval;
+    prof_interval = interval;
+
+    kernel_log_info("prof: sampling every %d ticks", interval);
+    return 0;
+}
+
+/**
+ * Stops profiling and writes the profile to the kernel log
+ * @return -1 if not profiling, otherwise the number of samples taken
+ */
+int kprof_stop(void) {
+    if (!prof_interval) {
+        return -1;
+    }
+
+    prof_interval = 0;
+
+    kernel_log_info("prof: %d samples, %d dropped", prof_samples, prof_dropped);
+
+    for (int i = 0; i < PROF_BUCKETS; i++) {
+        if (prof_table[i].count) {
+            kernel_log_info("prof eip=0x%08x pid=%d count=%d",
+                            prof_table[i].eip, prof_table[i].pid, prof_table[i].count);
+        }
+    }
+
+    return prof_samples;
+}
+
+/**
+ * Copies the profile, most frequent entries first
+ * @param samples - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int kprof_dump(prof_sample_t *samples, int n) {
+    int copied = 0;
+    int prev = -1;
+    int next;
+
+    if (!samples || n < 0) {
+        return -1;
+    }
+
+    // Select the entries in order without sorting the table
+    while (copied < n) {
+        next = -1;
+
+        for (int i = 0; i < PROF_BUCKETS; i++) {
+            if (!prof_table[i].count || (prev >= 0 && !kprof_before(prev, i))) {
+                continue;
+            }
+
+            if (next < 0 || kprof_before(i, next)) {
+                next = i;
+            }
+        }
+
+        if (next < 0) {
+            break;
+        }
+
+        samples[copied++] = prof_table[next];
+        prev = next;
+    }
+
+    return copied;
+}
+
+/**
+ * Records a sample of the active process; called from the timer IRQ
+ */
+void kprof_tick(void) {
+    unsigned int eip;
+    int pid;
+    int slot;
+    prof_sample_t *entry;
+
+    if (!prof_interval || --prof_countdown > 0) {
+        return;
+    }
+
+    prof_countdown = prof_interval;
+
+    if (!active_proc || !active_proc->trapframe) {
+        return;
+    }
+
+    eip = active_proc->trapframe->eip;
+    pid = active_proc->pid;
+    slot = kprof_hash(eip, pid);
+    prof_samples++;
+
+    for (int i = 0; i < PROF_PROBES; i++) {
+        entry = &prof_table[(slot + i) & (PROF_BUCKETS - 1)];
+
+        if (entry->count == 0) {
+            entry->eip = eip;
+            entry->pid = pid;
+        }
+
+        if (entry->eip == eip && entry->pid == pid) {
+            entry->count++;
+            return;
+        }
+    }
+
+    prof_dropped++;
+}
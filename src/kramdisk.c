@@ -0,0 +1,71 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * RAM Disk Block Device
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kblock.h"
+#include "kpage.h"
+#include "kramdisk.h"
+
+// Disk image embedded in the DLI (see kramdisk_image.S)
+extern unsigned char kramdisk_image[];
+extern unsigned char kramdisk_image_end[];
+
+kblock_dev_t kramdisk_dev;
+
+/**
+ * Copies blocks from the disk image
+ * @param dev - the RAM disk
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory for count * BLOCK_SIZE bytes
+ * @return 0 (always succeeds)
+ */
+static int kramdisk_read(kblock_dev_t *dev, int block, int count, void *buf) {
+    memcpy(buf, (unsigned char *)dev->data + block * BLOCK_SIZE, count * BLOCK_SIZE);
+    return 0;
+}
+
+/**
+ * Copies blocks into the disk image
+ * @param dev - the RAM disk
+ * @param block - first block number
+ * @param count - number of blocks
+ * @param buf - memory holding count * BLOCK_SIZE bytes
+ * @return 0 (always succeeds)
+ */
+static int kramdisk_write(kblock_dev_t *dev, int block, int count, void *buf) {
+    memcpy((unsigned char *)dev->data + block * BLOCK_SIZE, buf, count * BLOCK_SIZE);
+    return 0;
+}
+
+/**
+ * Registers the RAM disk as a block device
+ * @return -1 on error, otherwise the block device id
+ */
+int kramdisk_init(void) {
+    int size = kramdisk_image_end - kramdisk_image;
+
+    // The image is part of the kernel image, which must end below the
+    // memory handed out by the page allocator
+    if ((unsigned int)kramdisk_image_end > KPAGE_MEM_START) {
+        kernel_panic("RAM disk image ends at 0x%x, above the page allocator start 0x%x",
+                     (unsigned int)kramdisk_image_end, KPAGE_MEM_START);
+        return -1;
+    }
+
+    memset(&kramdisk_dev, 0, sizeof(kramdisk_dev));
+    kramdisk_dev.name = RAMDISK_NAME;
+    kramdisk_dev.blocks = size / BLOCK_SIZE;
+    kramdisk_dev.read = kramdisk_read;
+    kramdisk_dev.write = kramdisk_write;
+    kramdisk_dev.data = kramdisk_image;
+
+    return kblock_register(&kramdisk_dev);
+}
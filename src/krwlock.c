@@ -0,0 +1,249 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Reader-Writer Locks
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "krwlock.h"
+#include "queue.h"
+#include "scheduler.h"
+
+// Table of all reader-writer locks
+rwlock_t rwlocks[RWLOCK_MAX];
+
+// Reader-writer lock ids to be allocated
+queue_t rwlock_queue;
+
+/**
+ * Initializes kernel reader-writer lock data structures
+ * @return -1 on error, 0 on success
+ */
+int krwlocks_init(void) {
+    kernel_log_info("Initializing kernel reader-writer locks");
+
+    // Initialize the lock table
+    memset(&rwlocks, 0, sizeof(rwlocks));
+
+    // Initialize and fill the lock queue
+    queue_init(&rwlock_queue);
+    for (int i = 0; i < RWLOCK_MAX; i++) {
+        if (queue_in(&rwlock_queue, i) != 0) {
+            kernel_log_warn("rwlock: unable to queue rwlock %d", i);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Looks up an allocated lock in the lock table
+ * @param id - the lock id
+ * @return NULL on error, otherwise the lock table entry
+ */
+static rwlock_t *krwlock_get(int id) {
+    if (id >= RWLOCK_MAX || id < 0) {
+        return NULL;
+    }
+
+    if (!rwlocks[id].allocated) {
+        return NULL;
+    }
+
+    return &rwlocks[id];
+}
+
+/**
+ * Blocks the active process in the given wait queue
+ * @param queue - the lock wait queue
+ * @return -1 on error, 0 on success
+ */
+static int krwlock_block(queue_t *queue) {
+    if (queue_in(queue, active_proc->pid) != 0) {
+        return -1;
+    }
+
+    active_proc->state = WAITING;
+    scheduler_remove(active_proc);
+    return 0;
+}
+
+/**
+ * Releases one read hold of the lock by a process
+ * @param rwlock - pointer to the lock table entry
+ * @param pid - the process id
+ * @return -1 if the process does not hold the lock for reading, 0 on success
+ */
+static int krwlock_release_reader(rwlock_t *rwlock, int pid) {
+    int size = rwlock->readers.size;
+    int found = 0;
+    int item;
+
+    // Rotate the readers through the queue, dropping the first match
+    for (int i = 0; i < size; i++) {
+        queue_out(&rwlock->readers, &item);
+
+        if (!found && item == pid) {
+            found = 1;
+            continue;
+        }
+
+        queue_in(&rwlock->readers, item);
+    }
+
+    return found ? 0 : -1;
+}
+
+/**
+ * Hands the lock over to waiting processes once it is free
+ * Writer preferring locks wake one writer before any readers; reader
+ * preferring locks wake every waiting reader before any writer
+ * @param rwlock - pointer to the lock table entry
+ */
+static void krwlock_wake(rwlock_t *rwlock) {
+    int pid;
+
+    if (rwlock->writer || rwlock->readers.size > 0) {
+        return;
+    }
+
+    if (rwlock->mode == RWLOCK_PREFER_WRITER || rwlock->read_queue.size == 0) {
+        if (queue_out(&rwlock->write_queue, &pid) == 0) {
+            rwlock->writer = pid_to_proc(pid);
+            scheduler_add(rwlock->writer);
+            return;
+        }
+    }
+
+    // The lock is taken on behalf of each reader before it runs again;
+    // readers beyond what the lock can track wait for the next hand over
+    while (rwlock->readers.size < QUEUE_SIZE && queue_out(&rwlock->read_queue, &pid) == 0) {
+        queue_in(&rwlock->readers, pid);
+        scheduler_add(pid_to_proc(pid));
+    }
+}
+
+/**
+ * Allocates a reader-writer lock
+ * @param mode - RWLOCK_PREFER_READER or RWLOCK_PREFER_WRITER
+ * @return -1 on error, otherwise the lock id that was allocated
+ */
+int krwlock_init(int mode) {
+    int id = -1;
+
+    if (mode != RWLOCK_PREFER_READER && mode != RWLOCK_PREFER_WRITER) {
+        return -1;
+    }
+
+    // Obtain a lock id from the lock queue
+    if (queue_out(&rwlock_queue, &id) != 0) {
+        return -1;
+    }
+
+    rwlock_t *rwlock = &rwlocks[id];
+
+    memset(rwlock, 0, sizeof(rwlock_t));
+    rwlock->allocated = 1;
+    rwlock->mode = mode;
+    queue_init(&rwlock->readers);
+
+    return id;
+}
+
+/**
+ * Frees the specified reader-writer lock
+ * @param id - the lock id
+ * @return 0 on success, -1 on error
+ */
+int krwlock_destroy(int id) {
+    rwlock_t *rwlock = krwlock_get(id);
+
+    if (!rwlock) {
+        return -1;
+    }
+
+    // Prevent a held lock from being destroyed
+    if (rwlock->writer || rwlock->readers.size > 0) {
+        return -1;
+    }
+
+    memset(rwlock, 0, sizeof(rwlock_t));
+
+    // Add the id back into the lock queue to be re-used later
+    queue_in(&rwlock_queue, id);
+
+    return 0;
+}
+
+/**
+ * Takes the lock for reading
+ * @param id - the lock id
+ * @return -1 on error, 0 on success
+ */
+int krwlock_rdlock(int id) {
+    rwlock_t *rwlock = krwlock_get(id);
+
+    if (!rwlock) {
+        return -1;
+    }
+
+    // Readers must wait while a writer holds the lock; writer preferring
+    // locks also queue readers behind any waiting writer
+    if (rwlock->writer || rwlock->readers.size >= QUEUE_SIZE ||
+        (rwlock->mode == RWLOCK_PREFER_WRITER && rwlock->write_queue.size > 0)) {
+        return krwlock_block(&rwlock->read_queue);
+    }
+
+    return queue_in(&rwlock->readers, active_proc->pid);
+}
+
+/**
+ * Takes the lock for writing
+ * @param id - the lock id
+ * @return -1 on error, 0 on success
+ */
+int krwlock_wrlock(int id) {
+    rwlock_t *rwlock = krwlock_get(id);
+
+    if (!rwlock) {
+        return -1;
+    }
+
+    if (rwlock->writer || rwlock->readers.size > 0) {
+        return krwlock_block(&rwlock->write_queue);
+    }
+
+    rwlock->writer = active_proc;
+    return 0;
+}
+
+/**
+ * Releases the lock held by the active process (read or write)
+ * @param id - the lock id
+ * @return -1 on error, 0 on success
+ */
+int krwlock_unlock(int id) {
+    rwlock_t *rwlock = krwlock_get(id);
+
+    if (!rwlock) {
+        return -1;
+    }
+
+    if (rwlock->writer) {
+        if (rwlock->writer != active_proc) {
+            return -1;
+        }
+
+        rwlock->writer = NULL;
+    } else if (krwlock_release_reader(rwlock, active_proc->pid) != 0) {
+        // Only a process holding the lock for reading may release it
+        return -1;
+    }
+
+    krwlock_wake(rwlock);
+    return 0;
+}
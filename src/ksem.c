@@ -12,6 +12,7 @@
 #include "ksem.h"
 #include "queue.h"
 #include "scheduler.h"
+#include "timer.h"
 
 // Table of all semephores
 sem_t semaphores[SEM_MAX];
@@ -19,6 +20,22 @@ sem_t semaphores[SEM_MAX];
 // semaphore ids to be allocated
 queue_t sem_queue;
 
+/**
+ * Records the time a process was blocked before being woken by a post
+ * @param sem - the semaphore
+ * @param proc - the process, blocked since proc->state_time
+ */
+static void ksem_waited(sem_t *sem, proc_t *proc) {
+    int wait = timer_get_ticks() - proc->state_time;
+
+    sem->stats.wait_ticks += wait;
+    if (wait > sem->stats.max_wait) {
+        sem->stats.max_wait = wait;
+    }
+
+    sem->stats.owner = proc->pid;
+}
+
 /**
  * Initializes kernel semaphore data structures
  * @return -1 on error, 0 on success
@@ -55,17 +72,17 @@ int ksem_init(int value) {
         id++;
     }
     // Ensure that the id is within the valid range
-    if(id > SEM_MAX || id < 0) {
+    if(id >= SEM_MAX || id < 0) {
         return -1;
     }
     // Initialize the semaphore data structure
     // sempohare table + all members (wait queue, allocated, count)
-        // set count to initial value
-    for (int i = 0; i < SEM_MAX; i++) {
-        memset(&semaphores[i].wait_queue, 0, sizeof(semaphores[i].wait_queue));
-        semaphores[i].allocated = 1;
-        semaphores[i].count = 0;
-    }
+    // set count to initial value
+    memset(&semaphores[id].wait_queue, 0, sizeof(semaphores[id].wait_queue));
+    semaphores[id].allocated = 1;
+    semaphores[id].count = value;
+    memset(&semaphores[id].stats, 0, sizeof(semaphores[id].stats));
+    semaphores[id].stats.owner = -1;
     return id;
 }
 
@@ -76,12 +93,13 @@ int ksem_init(int value) {
  */
 int ksem_destroy(int id) {
     // look up the sempaphore in the semaphore table
-    if(id > SEM_MAX || id < 0) {
+    if(id >= SEM_MAX || id < 0 || !semaphores[id].allocated) {
         return -1;
     }
     sem_t *sem = &semaphores[id];
-    // If the semaphore is locked, prevent it from being destroyed
-    if (sem->count > 0) {
+    // If the semaphore is locked or processes are waiting on it, prevent it
+    // from being destroyed
+    if (sem->count > 0 || sem->wait_queue.size > 0) {
         return -1;
     }
     // Add the id back into the semaphore queue to be re-used later
@@ -101,20 +119,31 @@ int ksem_destroy(int id) {
  */
 int ksem_wait(int id) {
     // look up the sempaphore in the semaphore table
+    if (id >= SEM_MAX || id < 0 || !semaphores[id].allocated) {
+        return -1;
+    }
     sem_t *sem = &semaphores[id];
     // If the semaphore count is 0, then the process must wait
         // Set the state to WAITING
         // add to the semaphore's wait queue
         // remove from the scheduler
+    sem->stats.acquisitions++;
     if (sem->count <= 0) {
+        if (queue_in(&sem->wait_queue, active_proc->pid) != 0) {
+            return -1;
+        }
         active_proc->state = WAITING;
-        queue_in(&sem->wait_queue, active_proc->pid);
+        sem->stats.contended++;
+        if (sem->wait_queue.size > sem->stats.max_queue) {
+            sem->stats.max_queue = sem->wait_queue.size;
+        }
         scheduler_remove(active_proc);
     }
     // If the semaphore count is > 0
         // Decrement the count
     if (sem->count > 0) {
         sem->count = sem->count - 1;
+        sem->stats.owner = active_proc->pid;
     }
     // Return the current semaphore count
     return sem->count;
@@ -128,6 +157,9 @@ int ksem_wait(int id) {
 int ksem_post(int id) {
 
     // look up the semaphore in the semaphore table
+    if (id >= SEM_MAX || id < 0 || !semaphores[id].allocated) {
+        return -1;
+    }
     sem_t *sem = &semaphores[id];
     // incrememnt the semaphore count
     sem->count = sem->count + 1;
@@ -140,6 +172,7 @@ int ksem_post(int id) {
             break;
         }
         else {
+            ksem_waited(sem, pid_to_proc(i));
             scheduler_add(pid_to_proc(i));
             sem->count = sem->count - 1;
             break;
@@ -148,3 +181,21 @@ int ksem_post(int id) {
     // return current semaphore count
     return sem->count;
 }
+
+/**
+ * Gets the contention statistics of a semaphore
+ * @param id - the semaphore id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the semaphore is not allocated, 0 on success
+ */
+int ksem_stats(int id, lock_stat_t *stats) {
+    if (id >= SEM_MAX || id < 0 || !stats || !semaphores[id].allocated) {
+        return -1;
+    }
+
+    *stats = semaphores[id].stats;
+    stats->type = LOCK_SEM;
+    stats->id = id;
+
+    return 0;
+}
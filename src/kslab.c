@@ -0,0 +1,219 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Slab Allocator
+ */
+
+#include <spede/string.h>
+
+#include "bit_util.h"
+#include "kernel.h"
+#include "kpage.h"
+#include "kslab.h"
+
+/**
+ * Adds a slab to the cache, doubling the slab directory if it is full
+ * @param slab - pointer to the slab cache
+ * @return -1 on error, 0 on success
+ */
+static int kslab_grow(kslab_t *slab) {
+    int s = slab->slabs;
+    kslab_slab_t *entry;
+    kslab_slab_t *dir;
+    int pages;
+
+    if (s >= slab->max_slabs) {
+        return -1;
+    }
+
+    if (s == slab->dir_pages * KPAGE_SIZE / (int)sizeof(kslab_slab_t)) {
+        pages = slab->dir_pages ? slab->dir_pages * 2 : 1;
+
+        dir = kpage_alloc_contig(pages);
+        if (!dir) {
+            kernel_log_warn("kslab %s: out of memory for the slab directory", slab->name);
+            return -1;
+        }
+
+        if (slab->dir) {
+            memcpy(dir, slab->dir, s * sizeof(kslab_slab_t));
+            kpage_free_contig(slab->dir, slab->dir_pages);
+        }
+
+        slab->dir = dir;
+        slab->dir_pages = pages;
+    }
+
+    entry = &slab->dir[s];
+    entry->mem = kpage_alloc_contig(((slab->size + slab->meta_size) * slab->per_slab + KPAGE_SIZE - 1) / KPAGE_SIZE);
+    if (!entry->mem) {
+        kernel_log_warn("kslab %s: out of memory", slab->name);
+        return -1;
+    }
+
+    entry->free = (slab->per_slab == 32) ? 0xffffffff : (1u << slab->per_slab) - 1;
+    entry->next_partial = slab->partial;
+    slab->partial = s;
+    slab->slabs++;
+
+    kernel_log_debug("kslab %s: added slab %d (%d objects)", slab->name, s, slab->per_slab);
+    return 0;
+}
+
+/**
+ * Initializes an empty slab cache
+ * @param slab - pointer to the slab cache
+ * @param name - name of the cache
+ * @param size - size of each object in bytes
+ * @param meta_size - size of the metadata of each object in bytes (may be 0)
+ * @param per_slab - number of objects in each slab (1 - 32)
+ * @param max_slabs - maximum number of slabs
+ * @return -1 on error, 0 on success
+ */
+int kslab_init(kslab_t *slab, char *name, int size, int meta_size, int per_slab, int max_slabs) {
+    if (!slab || size <= 0 || meta_size < 0) {
+        return -1;
+    }
+
+    if (per_slab < 1 || per_slab > KSLAB_OBJS_PER_SLAB_MAX) {
+        return -1;
+    }
+
+    if (max_slabs < 1) {
+        return -1;
+    }
+
+    memset(slab, 0, sizeof(kslab_t));
+    slab->name = name;
+    slab->size = size;
+    slab->meta_size = meta_size;
+    slab->per_slab = per_slab;
+    slab->max_slabs = max_slabs;
+    slab->partial = -1;
+
+    return 0;
+}
+
+/**
+ * Allocates an object, adding a slab to the cache if it is full
+ * @param slab - pointer to the slab cache
+ * @return -1 if no object could be allocated, otherwise the object index
+ */
+int kslab_alloc(kslab_t *slab) {
+    kslab_slab_t *entry;
+    int s;
+    int i;
+
+    if (!slab) {
+        return -1;
+    }
+
+    if (slab->partial < 0 && kslab_grow(slab) != 0) {
+        return -1;
+    }
+
+    // First slab with a free object, then its lowest free object
+    s = slab->partial;
+    entry = &slab->dir[s];
+    i = bit_ffs(entry->free);
+
+    entry->free &= ~(1u << i);
+    if (!entry->free) {
+        slab->partial = entry->next_partial;
+        entry->next_partial = -1;
+    }
+
+    slab->used++;
+
+    return s * slab->per_slab + i;
+}
+
+/**
+ * Frees an object
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return -1 on error, 0 on success
+ */
+int kslab_free(kslab_t *slab, int index) {
+    kslab_slab_t *entry;
+    int s;
+    int i;
+
+    if (!kslab_is_allocated(slab, index)) {
+        return -1;
+    }
+
+    s = index / slab->per_slab;
+    i = index % slab->per_slab;
+    entry = &slab->dir[s];
+
+    // A full slab goes back on the list of slabs with a free object
+    if (!entry->free) {
+        entry->next_partial = slab->partial;
+        slab->partial = s;
+    }
+
+    entry->free |= 1u << i;
+    slab->used--;
+
+    return 0;
+}
+
+/**
+ * Returns the memory of an object
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return NULL if the index is not backed by a slab, otherwise the object
+ */
+void *kslab_get(kslab_t *slab, int index) {
+    if (!slab || index < 0 || index >= kslab_capacity(slab)) {
+        return NULL;
+    }
+
+    return slab->dir[index / slab->per_slab].mem + (index % slab->per_slab) * slab->size;
+}
+
+/**
+ * Returns the metadata of an object
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return NULL if the index is not backed by a slab or the cache keeps no
+ *         metadata, otherwise the metadata of the object
+ */
+void *kslab_meta(kslab_t *slab, int index) {
+    if (!slab || !slab->meta_size || index < 0 || index >= kslab_capacity(slab)) {
+        return NULL;
+    }
+
+    return slab->dir[index / slab->per_slab].mem + slab->size * slab->per_slab +
+           (index % slab->per_slab) * slab->meta_size;
+}
+
+/**
+ * Indicates if an object is allocated
+ * @param slab - pointer to the slab cache
+ * @param index - the object index
+ * @return true if allocated, false if free or not backed by a slab
+ */
+bool kslab_is_allocated(kslab_t *slab, int index) {
+    if (!slab || index < 0 || index >= kslab_capacity(slab)) {
+        return false;
+    }
+
+    return !(slab->dir[index / slab->per_slab].free & (1u << (index % slab->per_slab)));
+}
+
+/**
+ * Returns the number of objects backed by slabs
+ * @param slab - pointer to the slab cache
+ * @return number of objects (allocated and free)
+ */
+int kslab_capacity(kslab_t *slab) {
+    if (!slab) {
+        return 0;
+    }
+
+    return slab->slabs * slab->per_slab;
+}
@@ -17,6 +17,17 @@
 #include "timer.h"
 #include "ksem.h"
 #include "kmutex.h"
+#include "krwlock.h"
+#include "kcond.h"
+#include "kmbox.h"
+#include "kpipe.h"
+#include "kpoll.h"
+#include "kmalloc.h"
+#include "kpaging.h"
+#include "kfs.h"
+#include "kprof.h"
+#include "klat.h"
+#include "ktrace.h"
 
 /**
  * System call IRQ handler
@@ -119,8 +130,141 @@ void ksyscall_irq_handler(void) {
             rc = ksyscall_sem_wait(arg1);
             break;
 
+        case SYSCALL_SYS_GET_TICKS:
+            rc = ksyscall_sys_get_ticks();
+            break;
+
+        case SYSCALL_RWLOCK_INIT:
+            rc = ksyscall_rwlock_init((int)arg1);
+            break;
+
+        case SYSCALL_RWLOCK_DESTROY:
+            rc = ksyscall_rwlock_destroy((int)arg1);
+            break;
+
+        case SYSCALL_RWLOCK_RDLOCK:
+            rc = ksyscall_rwlock_rdlock((int)arg1);
+            break;
+
+        case SYSCALL_RWLOCK_WRLOCK:
+            rc = ksyscall_rwlock_wrlock((int)arg1);
+            break;
+
+        case SYSCALL_RWLOCK_UNLOCK:
+            rc = ksyscall_rwlock_unlock((int)arg1);
+            break;
+
+        case SYSCALL_COND_INIT:
+            rc = ksyscall_cond_init((int)arg1);
+            break;
+
+        case SYSCALL_COND_DESTROY:
+            rc = ksyscall_cond_destroy((int)arg1);
+            break;
+
+        case SYSCALL_COND_WAIT:
+            rc = ksyscall_cond_wait((int)arg1);
+            break;
+
+        case SYSCALL_COND_SIGNAL:
+            rc = ksyscall_cond_signal((int)arg1);
+            break;
+
+        case SYSCALL_COND_BROADCAST:
+            rc = ksyscall_cond_broadcast((int)arg1);
+            break;
+
+        case SYSCALL_MBOX_INIT:
+            rc = ksyscall_mbox_init();
+            break;
+
+        case SYSCALL_MBOX_DESTROY:
+            rc = ksyscall_mbox_destroy((int)arg1);
+            break;
+
+        case SYSCALL_MSG_SEND:
+            rc = ksyscall_msg_send((int)arg1, (char *)arg2, (int)arg3);
+            break;
+
+        case SYSCALL_MSG_RECV:
+            rc = ksyscall_msg_recv((int)arg1, (char *)arg2, (int)arg3);
+            break;
+
+        case SYSCALL_MSG_SELECT:
+            rc = ksyscall_msg_select((int)arg1);
+            break;
+
+        case SYSCALL_IO_CLOSE:
+            rc = ksyscall_io_close((int)arg1);
+            break;
+
+        case SYSCALL_PIPE:
+            rc = ksyscall_pipe((int *)arg1);
+            break;
+
+        case SYSCALL_POLL:
+            rc = ksyscall_poll((pollfd_t *)arg1, (int)arg2, (int)arg3);
+            break;
+
+        case SYSCALL_MEM_STATS:
+            rc = ksyscall_mem_stats((mem_stats_t *)arg1);
+            break;
+
+        case SYSCALL_FORK:
+            rc = ksyscall_fork();
+            break;
+
+        case SYSCALL_EXEC:
+            rc = ksyscall_exec((char *)arg1);
+            break;
+
+        case SYSCALL_IO_OPEN:
+            rc = ksyscall_io_open((char *)arg1);
+            break;
+
+        case SYSCALL_IO_SEEK:
+            rc = ksyscall_io_seek((int)arg1, (int)arg2, (int)arg3);
+            break;
+
+        case SYSCALL_PROF_START:
+            rc = ksyscall_prof_start((int)arg1);
+            break;
+
+        case SYSCALL_PROF_STOP:
+            rc = ksyscall_prof_stop();
+            break;
+
+        case SYSCALL_PROF_DUMP:
+            rc = ksyscall_prof_dump((prof_sample_t *)arg1, (int)arg2);
+            break;
+
+        case SYSCALL_LAT_SNAPSHOT:
+            rc = ksyscall_lat_snapshot((int)arg1, (lat_hist_t *)arg2, (int)arg3);
+            break;
+
+        case SYSCALL_PROC_STATS:
+            rc = ksyscall_proc_stats((int)arg1, (sched_stats_t *)arg2);
+            break;
+
+        case SYSCALL_LOCKSTAT:
+            rc = ksyscall_lockstat((lock_stat_t *)arg1, (int)arg2);
+            break;
+
+        case SYSCALL_TRACE_READ:
+            rc = ksyscall_trace_read((trace_event_t *)arg1, (int)arg2);
+            break;
+
+        case SYSCALL_TRACE_DUMP:
+            rc = ksyscall_trace_dump();
+            break;
+
+        case SYSCALL_SYS_LOG:
+            rc = ksyscall_sys_log((char *)arg1);
+            break;
+
         default:
-            kernel_panic("Invalid system call %d!", syscall);
+            kernel_log_warn("Invalid system call %d from process %d", syscall, active_proc->pid);
+            break;
     }
 
     // Ensure that the EAX register contains a return value (if appropriate)
@@ -137,6 +281,51 @@ void ksyscall_init(void) {
     interrupts_irq_register(IRQ_SYSCALL, isr_entry_syscall, ksyscall_irq_handler);
 }
 
+/**
+ * Makes a process that is blocked in a system call repeat the call when
+ * it runs again
+ * The trapframe still holds the system call id and arguments because
+ * no return value is stored for a blocked process, so the instruction
+ * pointer only has to move back over the int $0x80 instruction.
+ * @param proc - the process
+ */
+void ksyscall_restart(proc_t *proc) {
+    if (proc && proc->trapframe) {
+        proc->trapframe->eip -= SYSCALL_INSN_SIZE;
+    }
+}
+
+/**
+ * Replaces an argument of a system call that a blocked process will repeat
+ * The arguments are read from the same registers the dispatcher reads them
+ * from when the call is repeated.
+ * @param proc - the process
+ * @param arg - the argument number (1 - 3)
+ * @param value - the new argument value
+ */
+void ksyscall_restart_arg(proc_t *proc, int arg, unsigned int value) {
+    if (!proc || !proc->trapframe) {
+        return;
+    }
+
+    switch (arg) {
+        case 1:
+            proc->trapframe->ebx = value;
+            break;
+
+        case 2:
+            proc->trapframe->ecx = value;
+            break;
+
+        case 3:
+            proc->trapframe->edx = value;
+            break;
+
+        default:
+            break;
+    }
+}
+
 /**
  * Writes up to n bytes to the process' specified IO buffer
  * @param io - the IO buffer to write to
@@ -153,7 +342,7 @@ int ksyscall_io_write(int io, char *buf, int size) {
         return -1;
     }
 
-    if (io < 0 || io >= PROC_IO_MAX) {
+    if (io < 0 || io >= PROC_IO_MAX || !buf || size < 0) {
         return -1;
     }
 
@@ -161,7 +350,17 @@ int ksyscall_io_write(int io, char *buf, int size) {
         return -1;
     }
 
-    return ringbuf_write_mem(active_proc->io[io], buf, size);
+    switch (active_proc->io_type[io]) {
+        case IO_TYPE_RINGBUF:
+            return ringbuf_write_mem(active_proc->io[io], buf, size);
+
+        case IO_TYPE_PIPE_WRITE:
+            return kpipe_write(io, buf, size);
+
+        default:
+            // The IRQ handler is the only producer of an SPSC buffer
+            return -1;
+    }
 }
 
 /**
@@ -176,7 +375,7 @@ int ksyscall_io_read(int io, char *buf, int size) {
         return -1;
     }
 
-    if (io < 0 || io >= PROC_IO_MAX) {
+    if (io < 0 || io >= PROC_IO_MAX || !buf || size < 0) {
         return -1;
     }
 
@@ -184,7 +383,19 @@ int ksyscall_io_read(int io, char *buf, int size) {
         return -1;
     }
 
-    return ringbuf_read_mem(active_proc->io[io], buf, size);
+    switch (active_proc->io_type[io]) {
+        case IO_TYPE_RINGBUF:
+            return ringbuf_read_mem(active_proc->io[io], buf, size);
+
+        case IO_TYPE_SPSC:
+            return spscbuf_read_mem(active_proc->io[io], buf, size);
+
+        case IO_TYPE_FILE:
+            return kfs_read(io, buf, size);
+
+        default:
+            return kpipe_read(io, buf, size);
+    }
 }
 
 /**
@@ -205,9 +416,16 @@ int ksyscall_io_flush(int io) {
         return -1;
     }
 
-    ringbuf_flush(active_proc->io[io]);
+    switch (active_proc->io_type[io]) {
+        case IO_TYPE_RINGBUF:
+            return ringbuf_flush(active_proc->io[io]);
 
-    return 0;
+        case IO_TYPE_SPSC:
+            return spscbuf_flush(active_proc->io[io]);
+
+        default:
+            return -1;
+    }
 }
 
 /**
@@ -354,3 +572,357 @@ int ksyscall_sem_post(int sem) {
     return ksem_post(sem);
 }
 
+/**
+ * Gets the number of timer ticks since startup
+ * @return system time in timer ticks
+ */
+int ksyscall_sys_get_ticks(void) {
+    return timer_get_ticks();
+}
+
+/**
+ * Allocates a reader-writer lock from the kernel
+ * @param mode - RWLOCK_PREFER_READER or RWLOCK_PREFER_WRITER
+ * @return -1 on error, all other values indicate the lock id
+ */
+int ksyscall_rwlock_init(int mode) {
+    return krwlock_init(mode);
+}
+
+/**
+ * Destroys a reader-writer lock
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_rwlock_destroy(int rwlock) {
+    return krwlock_destroy(rwlock);
+}
+
+/**
+ * Takes a reader-writer lock for reading
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ * @note If a writer holds the lock, process will block/wait.
+ */
+int ksyscall_rwlock_rdlock(int rwlock) {
+    return krwlock_rdlock(rwlock);
+}
+
+/**
+ * Takes a reader-writer lock for writing
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ * @note If the lock is held, process will block/wait.
+ */
+int ksyscall_rwlock_wrlock(int rwlock) {
+    return krwlock_wrlock(rwlock);
+}
+
+/**
+ * Releases a reader-writer lock
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_rwlock_unlock(int rwlock) {
+    return krwlock_unlock(rwlock);
+}
+
+/**
+ * Allocates a condition variable bound to a mutex
+ * @param mutex - mutex id protecting the condition
+ * @return -1 on error, all other values indicate the condition id
+ */
+int ksyscall_cond_init(int mutex) {
+    return kcond_init(mutex);
+}
+
+/**
+ * Destroys a condition variable
+ * @param cond - condition id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_cond_destroy(int cond) {
+    return kcond_destroy(cond);
+}
+
+/**
+ * Releases the bound mutex and waits on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, 0 on success
+ * @note The mutex is held again when the process resumes.
+ */
+int ksyscall_cond_wait(int cond) {
+    return kcond_wait(cond);
+}
+
+/**
+ * Wakes one process waiting on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int ksyscall_cond_signal(int cond) {
+    return kcond_signal(cond);
+}
+
+/**
+ * Wakes all processes waiting on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int ksyscall_cond_broadcast(int cond) {
+    return kcond_broadcast(cond);
+}
+
+/**
+ * Allocates a mailbox from the kernel
+ * @return -1 on error, all other values indicate the mailbox id
+ */
+int ksyscall_mbox_init(void) {
+    return kmbox_init();
+}
+
+/**
+ * Destroys a mailbox
+ * @param mbox - mailbox id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_mbox_destroy(int mbox) {
+    return kmbox_destroy(mbox);
+}
+
+/**
+ * Sends a message to a mailbox
+ * @param mbox - mailbox id
+ * @param buf - the message to send
+ * @param n - message size (at most MBOX_MSG_SIZE bytes)
+ * @return -1 on error, 0 on success
+ * @note If the mailbox is full, process will block/wait.
+ */
+int ksyscall_msg_send(int mbox, char *buf, int n) {
+    return kmbox_send(mbox, buf, n);
+}
+
+/**
+ * Receives a message from a mailbox
+ * @param mbox - mailbox id
+ * @param buf - the buffer to copy the message to
+ * @param n - size of the buffer
+ * @return -1 on error or value indicating number of bytes received
+ * @note If the mailbox is empty, process will block/wait.
+ */
+int ksyscall_msg_recv(int mbox, char *buf, int n) {
+    return kmbox_recv(mbox, buf, n);
+}
+
+/**
+ * Waits until any of the selected mailboxes holds a message
+ * @param mask - bitmask of mailbox ids (bit n selects mailbox n)
+ * @return -1 on error, otherwise the id of a mailbox with a message
+ */
+int ksyscall_msg_select(int mask) {
+    return kmbox_select(mask);
+}
+
+/**
+ * Closes the specified IO buffer
+ * @param io - the IO buffer to close
+ * @return -1 on error or 0 on success
+ * @note Closing the last write end of a pipe signals end of file to readers
+ */
+int ksyscall_io_close(int io) {
+    return kproc_io_close(active_proc, io);
+}
+
+/**
+ * Creates a pipe in two free IO buffers of the process
+ * @param fds - fds[0] is set to the read end, fds[1] to the write end
+ * @return -1 on error or 0 on success
+ */
+int ksyscall_pipe(int *fds) {
+    return kpipe_open(fds);
+}
+
+/**
+ * Waits until any of the specified IO buffers is ready
+ * @param fds - IO buffers and requested events; revents is filled in
+ * @param n - number of IO buffers in fds
+ * @param timeout - ticks to wait, 0 to return immediately, -1 to wait forever
+ * @return -1 on error, otherwise the number of ready IO buffers (0 on timeout)
+ */
+int ksyscall_poll(pollfd_t *fds, int n, int timeout) {
+    return kpoll(fds, n, timeout);
+}
+
+/**
+ * Obtains kernel heap, page allocator and page table statistics
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_mem_stats(mem_stats_t *stats) {
+    if (kmalloc_stats(stats) != 0) {
+        return -1;
+    }
+
+    kpaging_stats(stats);
+    return 0;
+}
+
+/**
+ * Creates a copy of the calling process
+ * The copy shares the caller's memory copy-on-write and its I/O buffers
+ * @return -1 on error, 0 in the new process, otherwise the process id of
+ *         the new process
+ */
+int ksyscall_fork(void) {
+    return kproc_fork(active_proc);
+}
+
+/**
+ * Replaces the calling process' program with a program image
+ * I/O buffers stay open; on success the call does not return
+ * @param name - name of the program image
+ * @return -1 on error
+ */
+int ksyscall_exec(char *name) {
+    return kproc_exec(active_proc, name);
+}
+
+/**
+ * Opens a file from the filesystem into a free IO buffer slot
+ * The slot is read with io_read and released with io_close
+ * @param name - file name
+ * @return -1 on error, otherwise the IO buffer slot
+ */
+int ksyscall_io_open(char *name) {
+    return kfs_open(name);
+}
+
+/**
+ * Moves the offset of an open file
+ * @param io - the IO buffer slot of the file
+ * @param offset - offset relative to whence
+ * @param whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * @return -1 on error, otherwise the new offset
+ */
+int ksyscall_io_seek(int io, int offset, int whence) {
+    return kfs_seek(io, offset, whence);
+}
+
+/**
+ * Starts the sampling profiler, clearing the previous profile
+ * @param interval - timer ticks between samples
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_prof_start(int interval) {
+    return kprof_start(interval);
+}
+
+/**
+ * Stops the sampling profiler and writes the profile to the kernel log
+ * @return -1 if not profiling, otherwise the number of samples taken
+ */
+int ksyscall_prof_stop(void) {
+    return kprof_stop();
+}
+
+/**
+ * Copies the profile, most frequent entries first
+ * @param samples - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int ksyscall_prof_dump(prof_sample_t *samples, int n) {
+    return kprof_dump(samples, n);
+}
+
+/**
+ * Copies the kernel latency histograms that have samples, in id order
+ * @param kind - LAT_IRQ or LAT_SYSCALL
+ * @param hists - destination for up to n histograms
+ * @param n - maximum number of histograms
+ * @return -1 on error, otherwise the number of histograms copied
+ */
+int ksyscall_lat_snapshot(int kind, lat_hist_t *hists, int n) {
+    return klat_snapshot(kind, hists, n);
+}
+
+/**
+ * Gets a process' context switch and scheduling delay statistics
+ * @param pid - the process id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the process does not exist, 0 on success
+ */
+int ksyscall_proc_stats(int pid, sched_stats_t *stats) {
+    return scheduler_stats(pid, stats);
+}
+
+/**
+ * Gets the contention statistics of the allocated mutexes and semaphores,
+ * sorted by total wait time (longest first)
+ * @param stats - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int ksyscall_lockstat(lock_stat_t *stats, int n) {
+    lock_stat_t entry;
+    int count = 0;
+    int i;
+
+    if (!stats || n < 0) {
+        return -1;
+    }
+
+    // Insert each lock into the sorted entries, keeping the top n
+    for (int id = 0; id < MUTEX_MAX + SEM_MAX; id++) {
+        if (id < MUTEX_MAX ? kmutex_stats(id, &entry) : ksem_stats(id - MUTEX_MAX, &entry)) {
+            continue;
+        }
+
+        for (i = count; i > 0 && stats[i - 1].wait_ticks < entry.wait_ticks; i--) {
+            if (i < n) {
+                stats[i] = stats[i - 1];
+            }
+        }
+
+        if (i < n) {
+            stats[i] = entry;
+            if (count < n) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Copies and consumes the oldest unread scheduler trace events
+ * @param events - destination for up to n events
+ * @param n - maximum number of events
+ * @return -1 on error, otherwise the number of events copied
+ */
+int ksyscall_trace_read(trace_event_t *events, int n) {
+    return ktrace_read(events, n);
+}
+
+/**
+ * Writes the unread scheduler trace events to the kernel log and consumes them
+ * @return the number of events written
+ */
+int ksyscall_trace_dump(void) {
+    return ktrace_dump();
+}
+
+/**
+ * Writes a line to the kernel log, which the host receives over the serial port
+ * @param msg - the message (without a newline)
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_sys_log(char *msg) {
+    if (!msg) {
+        return -1;
+    }
+
+    kernel_log_info("%s", msg);
+    return 0;
+}
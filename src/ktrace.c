@@ -0,0 +1,97 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Scheduler Trace
+ */
+
+#include "kernel.h"
+#include "klat.h"
+#include "ktrace.h"
+
+#if (TRACE_EVENTS & (TRACE_EVENTS - 1)) != 0
+#error "TRACE_EVENTS must be a power of two"
+#endif
+
+trace_event_t trace_ring[TRACE_EVENTS];
+
+unsigned int trace_head;        // Events recorded
+unsigned int trace_tail;        // Events consumed or dropped
+int trace_dropped;              // Events overwritten before being read
+
+/**
+ * Skips events that have been overwritten since they were recorded
+ * @return number of unread events
+ */
+static int ktrace_unread(void) {
+    unsigned int unread = trace_head - trace_tail;
+
+    if (unread > TRACE_EVENTS) {
+        trace_dropped += unread - TRACE_EVENTS;
+        trace_tail = trace_head - TRACE_EVENTS;
+        unread = TRACE_EVENTS;
+    }
+
+    return unread;
+}
+
+/**
+ * Records a trace event
+ * @param type - event type (TRACE_*)
+ * @param pid - process the event is about (-1 if none)
+ * @param other - related process (-1 if none)
+ * @param irq - interrupt number
+ */
+void ktrace_event(int type, int pid, int other, int irq) {
+    unsigned long long tsc = klat_rdtsc();
+    trace_event_t *event = &trace_ring[trace_head++ & (TRACE_EVENTS - 1)];
+
+    event->tsc_lo = (unsigned int)tsc;
+    event->tsc_hi = (unsigned int)(tsc >> 32);
+    event->type = type;
+    event->irq = irq;
+    event->pid = pid;
+    event->other = other;
+}
+
+/**
+ * Copies and consumes the oldest unread trace events
+ * @param events - destination for up to n events
+ * @param n - maximum number of events
+ * @return -1 on error, otherwise the number of events copied
+ */
+int ktrace_read(trace_event_t *events, int n) {
+    int unread = ktrace_unread();
+    int copied;
+
+    if (!events || n < 0) {
+        return -1;
+    }
+
+    for (copied = 0; copied < n && copied < unread; copied++) {
+        events[copied] = trace_ring[trace_tail++ & (TRACE_EVENTS - 1)];
+    }
+
+    return copied;
+}
+
+/**
+ * Writes the unread trace events to the kernel log and consumes them
+ * @return the number of events written
+ */
+int ktrace_dump(void) {
+    int unread = ktrace_unread();
+    trace_event_t *event;
+
+    kernel_log_info("trace: %d events, %d dropped", unread, trace_dropped);
+
+    for (int i = 0; i < unread; i++) {
+        event = &trace_ring[trace_tail++ & (TRACE_EVENTS - 1)];
+        kernel_log_info("trace tsc=%08x%08x type=%d pid=%d other=%d irq=%d",
+                        event->tsc_hi, event->tsc_lo, event->type,
+                        event->pid, event->other, event->irq);
+    }
+
+    return unread;
+}
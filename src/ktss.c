@@ -0,0 +1,156 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Task State Segments
+ */
+
+#include <spede/string.h>
+#include <spede/machine/proc_reg.h>
+
+#include "interrupts.h"
+#include "kernel.h"
+#include "kpaging.h"
+#include "kproc.h"
+#include "ktss.h"
+#include "trapframe.h"
+
+#define TSS_DESC_ACCESS 0x89    // Present, ring 0, available 32-bit TSS
+
+// Descriptor table register contents, as used by sgdt/lgdt
+typedef struct gdt_reg_t {
+    unsigned short limit;
+    unsigned int base;
+} __attribute__((packed)) gdt_reg_t;
+
+// Copy of the GDT with room for the TSS descriptors
+unsigned long long ktss_gdt[KTSS_GDT_MAX];
+
+// Task the kernel and processes run in
+tss_t ktss_main;
+
+// Task that handles double faults
+tss_t ktss_fault;
+unsigned char ktss_fault_stack[KTSS_STACK_SIZE];
+
+// Trapframe a process that overflowed its stack enters the kernel with
+trapframe_t ktss_frame;
+
+/**
+ * Builds a TSS descriptor
+ * @param tss - the task state segment
+ * @return the GDT entry
+ */
+static unsigned long long ktss_descriptor(tss_t *tss) {
+    unsigned long long base = (unsigned int)tss;
+    unsigned long long limit = sizeof(tss_t) - 1;
+
+    return (limit & 0xffff) |
+           ((base & 0xffffff) << 16) |
+           ((unsigned long long)TSS_DESC_ACCESS << 40) |
+           (((limit >> 16) & 0xf) << 48) |
+           (((base >> 24) & 0xff) << 56);
+}
+
+/**
+ * Loads the kernel's task register and installs the double fault task
+ * The GDT is copied to make room for the TSS descriptors; the existing
+ * selectors keep their entries.
+ */
+void ktss_init(void) {
+    gdt_reg_t gdt;
+    int entries;
+    unsigned short main_sel;
+    unsigned short fault_sel;
+
+    kernel_log_info("Initializing the double fault task");
+
+    asm volatile("sgdt %0" : "=m"(gdt));
+
+    entries = (gdt.limit + 1) / sizeof(unsigned long long);
+    if (entries + 2 > KTSS_GDT_MAX) {
+        kernel_panic("GDT has %d entries, at most %d fit", entries, KTSS_GDT_MAX - 2);
+        return;
+    }
+
+    memset(ktss_gdt, 0, sizeof(ktss_gdt));
+    memcpy(ktss_gdt, (void *)gdt.base, entries * sizeof(unsigned long long));
+
+    // The kernel's own task only needs somewhere to save its registers
+    memset(&ktss_main, 0, sizeof(tss_t));
+    ktss_main.io_map = sizeof(tss_t);
+
+    // The double fault task starts in ktss_fault_task with interrupts
+    // disabled, on its own stack and the kernel page directory
+    memset(&ktss_fault, 0, sizeof(tss_t));
+    ktss_fault.cr3 = (unsigned int)kpaging_kernel_dir;
+    ktss_fault.eip = (unsigned int)ktss_fault_task;
+    ktss_fault.eflags = EF_DEFAULT_VALUE;
+    ktss_fault.esp = (unsigned int)&ktss_fault_stack[KTSS_STACK_SIZE];
+    ktss_fault.cs = KCODE_SEG;
+    ktss_fault.ss = KDATA_SEG;
+    ktss_fault.ds = KDATA_SEG;
+    ktss_fault.es = KDATA_SEG;
+    ktss_fault.fs = KDATA_SEG;
+    ktss_fault.gs = KDATA_SEG;
+    ktss_fault.io_map = sizeof(tss_t);
+
+    main_sel = entries * sizeof(unsigned long long);
+    fault_sel = main_sel + sizeof(unsigned long long);
+    ktss_gdt[entries] = ktss_descriptor(&ktss_main);
+    ktss_gdt[entries + 1] = ktss_descriptor(&ktss_fault);
+
+    gdt.base = (unsigned int)ktss_gdt;
+    gdt.limit = (entries + 2) * sizeof(unsigned long long) - 1;
+    asm volatile("lgdt %0" :: "m"(gdt));
+    asm volatile("ltr %0" :: "r"(main_sel));
+
+    interrupts_task_register(IRQ_DOUBLE_FAULT, fault_sel);
+}
+
+/**
+ * Handles a double fault, running in the double fault task
+ * A process that ran off the base of its stack is sent into the kernel
+ * context to be killed; any other double fault panics
+ */
+void ktss_double_fault(void) {
+    unsigned int esp = ktss_main.esp;
+    unsigned int addr;
+    unsigned int base;
+
+    // The page fault that could not be pushed left its address in CR2;
+    // clear it so a later double fault does not see a stale address
+    asm volatile("movl %%cr2, %0" : "=r"(addr));
+    asm volatile("movl %0, %%cr2" :: "r"(0));
+
+    if (!active_proc || kpaging_loaded != (unsigned int)active_proc->page_dir) {
+        kernel_panic("Double fault in kernel (eip 0x%x, esp 0x%x)", ktss_main.eip, esp);
+        return;
+    }
+
+    // Only a process running on its stack that faulted below the base of
+    // the stack, in the unmapped rest of the stack region, is recovered
+    base = KPAGING_STACK_END - active_proc->stack_size;
+
+    if (esp < KPAGING_STACK_START || esp >= KPAGING_STACK_END ||
+        addr < KPAGING_STACK_START || addr >= base) {
+        kernel_panic("Double fault in process %s (%d) (eip 0x%x, esp 0x%x, address 0x%x)",
+                     active_proc->name, active_proc->pid, ktss_main.eip, esp, addr);
+        return;
+    }
+
+    // Resume the interrupted task at the kernel entry point, as if the
+    // process had been interrupted with ktss_frame as its trapframe. The
+    // entry point pushes everything up to the interrupt number.
+    ktss_main.eip = (unsigned int)isr_entry_double_fault;
+    ktss_main.esp = (unsigned int)&ktss_frame.eip;
+    ktss_main.eflags = EF_DEFAULT_VALUE;
+    ktss_main.cr3 = kpaging_loaded;
+    ktss_main.cs = KCODE_SEG;
+    ktss_main.ss = KDATA_SEG;
+    ktss_main.ds = KDATA_SEG;
+    ktss_main.es = KDATA_SEG;
+    ktss_main.fs = KDATA_SEG;
+    ktss_main.gs = KDATA_SEG;
+}
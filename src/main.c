@@ -19,14 +19,58 @@
 #include "test.h"
 #include "kmutex.h"
 #include "ksem.h"
+#include "krwlock.h"
+#include "kcond.h"
+#include "kmbox.h"
+#include "kpipe.h"
+#include "kpoll.h"
+#include "kpage.h"
+#include "kmalloc.h"
+#include "kpaging.h"
+#include "ktss.h"
+#include "kfpu.h"
+#include "kblock.h"
+#include "kbuf.h"
+#include "kramdisk.h"
+#include "kata.h"
+#include "kfs.h"
 
 int main(void) {
+    int ramdisk;
+    int disk;
+
     // Always iniialize the kernel
     kernel_init();
 
+    // Initialize the page allocator (used by the process table and heap)
+    kpages_init();
+
+    // Initialize the kernel heap
+    kmalloc_init();
+
     // Initialize interrupts
     interrupts_init();
 
+    // Enable paging (registers the page fault handler)
+    kpaging_init();
+
+    // Handle double faults on their own task and stack
+    ktss_init();
+
+    // Enable the FPU; its registers are switched lazily between processes
+    kfpu_init();
+
+    // Initialize block devices and the buffer cache, then mount the
+    // filesystem from the disk if it holds one, or else the RAM disk
+    kblock_init();
+    ramdisk = kramdisk_init();
+    disk = kata_init();
+    kbuf_init();
+
+    if (disk < 0 || kfs_mount(disk) != 0) {
+        kfs_mount(ramdisk);
+    }
+
     // Initialize timers
     timer_init();
 
@@ -42,6 +86,14 @@ int main(void) {
     // Initialize the scheduler
     scheduler_init();
 
+    // Initialize kernel pipes (processes may be started with pipes attached)
+    kpipes_init();
+
+    // Initialize kernel mutexes and reader-writer locks (processes may be
+    // started with locks created for them)
+    kmutexes_init();
+    krwlocks_init();
+
     // Initialize processes
     kproc_init();
 
@@ -51,8 +103,14 @@ int main(void) {
     // Initialize kernel semaphores
     ksemaphores_init();
 
-    // Initialize kernel mutexes
-    kmutexes_init();
+    // Initialize kernel condition variables
+    kconds_init();
+
+    // Initialize kernel mailboxes
+    kmboxes_init();
+
+    // Initialize kernel poll
+    kpolls_init();
 
     // Test initialization
     test_init();
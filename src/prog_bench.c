@@ -0,0 +1,650 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Benchmark Programs
+ */
+
+#include <spede/stdio.h>
+#include <spede/string.h>
+#include "prog_bench.h"
+#include "ringbuf.h"
+#include "syscall.h"
+
+#define pprintf(fmt, ...) { \
+    char __pprint_buf[512] = {0}; \
+    int __pprint_len = snprintf(__pprint_buf, sizeof(__pprint_buf), (fmt), ##__VA_ARGS__); \
+    if (__pprint_len > 0) { \
+        io_write(PROC_IO_OUT, __pprint_buf, __pprint_len); \
+    } \
+}
+
+/*
+ * Reports a result as a "bench <name> key=value ..." line on the TTY and
+ * over the serial port (the kernel log), where tools/benchcmp.py reads it
+ */
+#define bench_report(fmt, ...) { \
+    char __bench_buf[256] = {0}; \
+    int __bench_len = snprintf(__bench_buf, sizeof(__bench_buf), "bench " fmt, ##__VA_ARGS__); \
+    if (__bench_len > 0) { \
+        sys_log(__bench_buf); \
+        pprintf("%s\n", __bench_buf); \
+    } \
+}
+
+/**
+ * Reads the low word of the time stamp counter
+ * Measurements are kept well under 2^32 cycles, so the difference of two
+ * readings is exact.
+ * @return CPU cycles since reset, modulo 2^32
+ */
+unsigned int bench_cycles(void) {
+    unsigned int lo;
+    unsigned int hi;
+
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return lo;
+}
+
+/**
+ * Waits (mostly sleeping) until the system reaches the given tick
+ * @param tick - timer tick to wait for
+ */
+void bench_wait_until(int tick) {
+    while (tick - sys_get_ticks() > 100) {
+        proc_sleep(1);
+    }
+
+    while (sys_get_ticks() < tick) {
+        proc_sleep(0);
+    }
+}
+
+/*
+ * Benchmark currently allowed to run (see bench_id_t)
+ * Benchmarks run one after another so they do not compete for the CPU
+ */
+int bench_turn = BENCH_ID_RWLOCK;
+
+/**
+ * Waits until the given benchmark is allowed to run
+ * @param bench - benchmark id
+ */
+void bench_wait_turn(int bench) {
+    while (bench_turn != bench) {
+        proc_sleep(0);
+    }
+}
+
+/**
+ * Allows the next benchmark to run
+ * Reports "bench done" after the last one
+ */
+void bench_end_turn(void) {
+    bench_turn++;
+
+    if (bench_turn == BENCH_ID_MAX) {
+        bench_report("done");
+    }
+}
+
+/*
+ * rwlock benchmark
+ *
+ * Each window runs a number of reader processes that repeatedly scan a
+ * shared table, first under an exclusive mutex and then under a reader
+ * lock. Windows double the number of active readers each time.
+ */
+#define BENCH_RWLOCK_TABLE_SIZE 256
+#define BENCH_RWLOCK_WINDOWS    16
+
+int bench_rwlock_table[BENCH_RWLOCK_TABLE_SIZE];
+int bench_rwlock_mutex = -1;
+int bench_rwlock_lock = -1;
+int bench_rwlock_next = 0;
+int bench_rwlock_start = 0;
+int bench_rwlock_done = 0;
+int bench_rwlock_reads[BENCH_RWLOCK_WINDOWS];
+
+/**
+ * Scans the shared table under the given lock until the end tick
+ * @param rwlock - non-zero to use the reader lock, zero for the mutex
+ * @param end - timer tick at which to stop
+ * @return number of table scans completed
+ */
+int bench_rwlock_read(int rwlock, int end) {
+    int reads = 0;
+    int sum;
+
+    while (sys_get_ticks() < end) {
+        if (rwlock) {
+            rwlock_rdlock(bench_rwlock_lock);
+        } else {
+            mutex_lock(bench_rwlock_mutex);
+        }
+
+        sum = 0;
+        for (int i = 0; i < BENCH_RWLOCK_TABLE_SIZE; i++) {
+            sum += bench_rwlock_table[i];
+        }
+
+        if (rwlock) {
+            rwlock_unlock(bench_rwlock_lock);
+        } else {
+            mutex_unlock(bench_rwlock_mutex);
+        }
+
+        if (sum >= 0) {
+            reads++;
+        }
+    }
+
+    return reads;
+}
+
+void prog_bench_rwlock(void) {
+    int index = bench_rwlock_next++;
+    int window = 0;
+    int start;
+    int reads;
+
+    bench_wait_turn(BENCH_ID_RWLOCK);
+
+    if (index == 0) {
+        for (int i = 0; i < BENCH_RWLOCK_TABLE_SIZE; i++) {
+            bench_rwlock_table[i] = i;
+        }
+
+        bench_rwlock_start = sys_get_ticks() + BENCH_WINDOW_TICKS;
+    }
+
+    while (!bench_rwlock_start) {
+        proc_sleep(0);
+    }
+
+    for (int readers = 1; readers <= BENCH_RWLOCK_READERS; readers *= 2) {
+        for (int rwlock = 0; rwlock < 2; rwlock++, window++) {
+            start = bench_rwlock_start + window * BENCH_WINDOW_TICKS;
+
+            bench_wait_until(start);
+
+            if (index >= readers) {
+                continue;
+            }
+
+            reads = bench_rwlock_read(rwlock, start + BENCH_WINDOW_TICKS);
+
+            mutex_lock(bench_rwlock_mutex);
+            bench_rwlock_reads[window] += reads;
+            mutex_unlock(bench_rwlock_mutex);
+        }
+    }
+
+    mutex_lock(bench_rwlock_mutex);
+    bench_rwlock_done++;
+    mutex_unlock(bench_rwlock_mutex);
+
+    if (index == 0) {
+        while (bench_rwlock_done < bench_rwlock_next) {
+            proc_sleep(0);
+        }
+
+        window = 0;
+        for (int readers = 1; readers <= BENCH_RWLOCK_READERS; readers *= 2, window += 2) {
+            bench_report("rwlock readers=%d mutex_reads_per_sec=%d rwlock_reads_per_sec=%d",
+                    readers,
+                    bench_rwlock_reads[window] * 100 / BENCH_WINDOW_TICKS,
+                    bench_rwlock_reads[window + 1] * 100 / BENCH_WINDOW_TICKS);
+        }
+
+        bench_end_turn();
+    }
+
+    proc_exit(0);
+}
+
+/*
+ * Message passing benchmark
+ *
+ * A client and a server process exchange request/reply messages of
+ * MBOX_MSG_SIZE bytes, first through shared globals signaled with
+ * semaphores (as prog_ping/prog_pong do) and then through mailboxes.
+ */
+int bench_msg_next = 0;
+int bench_msg_start = 0;
+int bench_msg_stop = 0;
+int bench_msg_sem[2] = {-1, -1};
+int bench_msg_mbox[2] = {-1, -1};
+int bench_msg_request[MBOX_MSG_SIZE / sizeof(int)];
+int bench_msg_reply[MBOX_MSG_SIZE / sizeof(int)];
+
+/**
+ * Sends requests until the end tick, checking each reply
+ * @param mbox - non-zero to use mailboxes, zero for semaphores and globals
+ * @param end - timer tick at which to stop
+ * @return number of request/reply round trips, -1 on a bad reply
+ */
+int bench_msg_client(int mbox, int end) {
+    int msg[MBOX_MSG_SIZE / sizeof(int)] = {0};
+    int count = 0;
+
+    while (sys_get_ticks() < end) {
+        msg[0] = count;
+
+        if (mbox) {
+            msg_send(bench_msg_mbox[0], (char *)msg, sizeof(msg));
+            msg_recv(bench_msg_mbox[1], (char *)msg, sizeof(msg));
+        } else {
+            memcpy(bench_msg_request, msg, sizeof(msg));
+            sem_post(bench_msg_sem[0]);
+            sem_wait(bench_msg_sem[1]);
+            memcpy(msg, bench_msg_reply, sizeof(msg));
+        }
+
+        if (msg[0] != count + 1) {
+            return -1;
+        }
+
+        count++;
+    }
+
+    // Tell the server to stop
+    msg[0] = -1;
+    if (mbox) {
+        msg_send(bench_msg_mbox[0], (char *)msg, sizeof(msg));
+    } else {
+        bench_msg_stop = 1;
+        sem_post(bench_msg_sem[0]);
+    }
+
+    return count;
+}
+
+/**
+ * Replies to requests until the client stops
+ * @param mbox - non-zero to use mailboxes, zero for semaphores and globals
+ */
+void bench_msg_server(int mbox) {
+    int msg[MBOX_MSG_SIZE / sizeof(int)] = {0};
+
+    while (1) {
+        if (mbox) {
+            msg_recv(bench_msg_mbox[0], (char *)msg, sizeof(msg));
+        } else {
+            sem_wait(bench_msg_sem[0]);
+            if (bench_msg_stop) {
+                break;
+            }
+
+            memcpy(msg, bench_msg_request, sizeof(msg));
+        }
+
+        if (msg[0] < 0) {
+            break;
+        }
+
+        msg[0]++;
+
+        if (mbox) {
+            msg_send(bench_msg_mbox[1], (char *)msg, sizeof(msg));
+        } else {
+            memcpy(bench_msg_reply, msg, sizeof(msg));
+            sem_post(bench_msg_sem[1]);
+        }
+    }
+}
+
+void prog_bench_msg(void) {
+    int index = bench_msg_next++;
+    int count[2] = {0};
+
+    bench_wait_turn(BENCH_ID_MSG);
+
+    if (index == 0) {
+        bench_msg_sem[0] = sem_init(0);
+        bench_msg_sem[1] = sem_init(0);
+        bench_msg_mbox[0] = mbox_init();
+        bench_msg_mbox[1] = mbox_init();
+
+        bench_msg_start = sys_get_ticks() + BENCH_WINDOW_TICKS;
+    }
+
+    while (!bench_msg_start) {
+        proc_sleep(0);
+    }
+
+    for (int mbox = 0; mbox < 2; mbox++) {
+        int start = bench_msg_start + mbox * BENCH_WINDOW_TICKS;
+
+        bench_wait_until(start);
+
+        if (index == 0) {
+            count[mbox] = bench_msg_client(mbox, start + BENCH_WINDOW_TICKS);
+        } else {
+            bench_msg_server(mbox);
+        }
+    }
+
+    if (index == 0) {
+        // Each round trip is a request and a reply message
+        bench_report("msg size=%d sem_msgs_per_sec=%d mbox_msgs_per_sec=%d",
+                MBOX_MSG_SIZE,
+                count[0] * 2 * 100 / BENCH_WINDOW_TICKS,
+                count[1] * 2 * 100 / BENCH_WINDOW_TICKS);
+
+        bench_end_turn();
+    }
+
+    proc_exit(0);
+}
+
+/*
+ * Pipe benchmark
+ *
+ * The writer sends 1 MB through a pipe that the kernel connected to the
+ * reader's I/O slot BENCH_PIPE_IO, then exits so the reader sees end of
+ * file. The reader checks the data and reports the bandwidth.
+ */
+#define BENCH_PIPE_BYTES (1024 * 1024)
+#define BENCH_PIPE_CHUNK 1024
+
+int bench_pipe_start = 0;
+
+void prog_bench_pipe_writer(void) {
+    char buf[BENCH_PIPE_CHUNK];
+    int sent = 0;
+
+    bench_wait_turn(BENCH_ID_PIPE);
+
+    bench_pipe_start = sys_get_ticks();
+
+    while (sent < BENCH_PIPE_BYTES) {
+        for (int i = 0; i < BENCH_PIPE_CHUNK; i++) {
+            buf[i] = (char)(sent + i);
+        }
+
+        if (io_write(BENCH_PIPE_IO, buf, BENCH_PIPE_CHUNK) != BENCH_PIPE_CHUNK) {
+            bench_report("pipe error=write_failed offset=%d", sent);
+            break;
+        }
+
+        sent += BENCH_PIPE_CHUNK;
+    }
+
+    // Exiting closes the write end, signaling end of file to the reader
+    proc_exit(0);
+}
+
+void prog_bench_pipe_reader(void) {
+    char buf[BENCH_PIPE_CHUNK];
+    int received = 0;
+    int errors = 0;
+    int ticks;
+    int n;
+
+    while ((n = io_read(BENCH_PIPE_IO, buf, BENCH_PIPE_CHUNK)) > 0) {
+        for (int i = 0; i < n; i++) {
+            if (buf[i] != (char)(received + i)) {
+                errors++;
+            }
+        }
+
+        received += n;
+    }
+
+    ticks = sys_get_ticks() - bench_pipe_start;
+    if (ticks <= 0) {
+        ticks = 1;
+    }
+
+    bench_report("pipe bytes=%d errors=%d ticks=%d kb_per_sec=%d",
+            received, errors, ticks, (received / 1024) * 100 / ticks);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Single process microbenchmarks
+ *
+ * Times the system call round trip, an uncontended mutex, the ring buffer
+ * and process spawn/exit in TSC cycles per operation.
+ */
+#define BENCH_SOLO_ITERATIONS   10000
+#define BENCH_SPAWN_ITERATIONS  200
+#define BENCH_RINGBUF_BYTES     (1024 * 1024)
+#define BENCH_RINGBUF_CHUNK     256
+
+ringbuf_t bench_ringbuf;
+
+void prog_bench_solo(void) {
+    char chunk[BENCH_RINGBUF_CHUNK];
+    char copy[BENCH_RINGBUF_CHUNK];
+    unsigned int start;
+    unsigned int cycles;
+    int errors = 0;
+    int mutex;
+    int sem;
+    int pid;
+    int i;
+
+    bench_wait_turn(BENCH_ID_SOLO);
+
+    // System call round trip
+    start = bench_cycles();
+    for (i = 0; i < BENCH_SOLO_ITERATIONS; i++) {
+        proc_get_pid();
+    }
+    cycles = bench_cycles() - start;
+
+    bench_report("syscall iterations=%d cycles_per_op=%d",
+                 BENCH_SOLO_ITERATIONS, cycles / BENCH_SOLO_ITERATIONS);
+
+    // Uncontended mutex lock/unlock pairs
+    mutex = mutex_init();
+
+    start = bench_cycles();
+    for (i = 0; i < BENCH_SOLO_ITERATIONS; i++) {
+        mutex_lock(mutex);
+        mutex_unlock(mutex);
+    }
+    cycles = bench_cycles() - start;
+
+    mutex_destroy(mutex);
+
+    bench_report("mutex_uncontended iterations=%d cycles_per_op=%d",
+                 BENCH_SOLO_ITERATIONS, cycles / BENCH_SOLO_ITERATIONS);
+
+    // Ring buffer throughput, writing and reading back each chunk
+    ringbuf_init(&bench_ringbuf);
+    for (i = 0; i < BENCH_RINGBUF_CHUNK; i++) {
+        chunk[i] = (char)i;
+    }
+
+    start = bench_cycles();
+    for (i = 0; i < BENCH_RINGBUF_BYTES; i += BENCH_RINGBUF_CHUNK) {
+        if (ringbuf_write_mem(&bench_ringbuf, chunk, BENCH_RINGBUF_CHUNK) != 0
+            || ringbuf_read_mem(&bench_ringbuf, copy, BENCH_RINGBUF_CHUNK) != BENCH_RINGBUF_CHUNK
+            || copy[BENCH_RINGBUF_CHUNK - 1] != chunk[BENCH_RINGBUF_CHUNK - 1]) {
+            errors++;
+        }
+    }
+    cycles = bench_cycles() - start;
+
+    bench_report("ringbuf bytes=%d errors=%d cycles_per_kb=%d",
+                 BENCH_RINGBUF_BYTES, errors, cycles / (BENCH_RINGBUF_BYTES / 1024));
+
+    // Spawn/exit: each child signals the parent and exits
+    errors = 0;
+    sem = sem_init(0);
+
+    start = bench_cycles();
+    for (i = 0; i < BENCH_SPAWN_ITERATIONS; i++) {
+        pid = fork();
+
+        if (pid == 0) {
+            sem_post(sem);
+            proc_exit(0);
+        } else if (pid < 0) {
+            errors++;
+            break;
+        }
+
+        sem_wait(sem);
+    }
+    cycles = bench_cycles() - start;
+
+    sem_destroy(sem);
+
+    bench_report("spawn iterations=%d errors=%d cycles_per_op=%d",
+                 i, errors, i ? cycles / i : 0);
+
+    bench_end_turn();
+    proc_exit(0);
+}
+
+/*
+ * Two process microbenchmarks
+ *
+ * The first process (index 0) sets up and reports; the second follows.
+ *  - Contended mutex: the processes hand the mutex back and forth, so
+ *    every lock blocks until the other process unlocks
+ *  - Semaphore ping-pong: round trips of post/wait between the processes
+ *  - Context switch: cycles from the first process blocking on a
+ *    semaphore to the second one resuming from its own wait
+ */
+#define BENCH_PAIR_ITERATIONS   2000
+#define BENCH_PAIR_LOCKS        32      // Lock statistics searched for the mutex
+
+int bench_pair_next = 0;
+int bench_pair_start = 0;
+int bench_pair_mutex = -1;
+int bench_pair_sem[2] = {-1, -1};
+
+unsigned int bench_pair_mark;           // Cycle count as a process blocks
+unsigned int bench_pair_switch_total;   // Sum of the switch latencies
+unsigned int bench_pair_switch_min;     // Shortest switch latency
+
+/**
+ * Records the latency of the switch from the first process
+ */
+void bench_pair_switched(void) {
+    unsigned int latency = bench_cycles() - bench_pair_mark;
+
+    bench_pair_switch_total += latency;
+    if (latency < bench_pair_switch_min) {
+        bench_pair_switch_min = latency;
+    }
+}
+
+/**
+ * Gets the number of contended acquisitions of a mutex
+ * @param mutex - the mutex id
+ * @return number of contended acquisitions, -1 if unknown
+ */
+int bench_pair_contended(int mutex) {
+    lock_stat_t locks[BENCH_PAIR_LOCKS];
+    int n = lockstat(locks, BENCH_PAIR_LOCKS);
+
+    for (int i = 0; i < n; i++) {
+        if (locks[i].type == LOCK_MUTEX && locks[i].id == mutex) {
+            return locks[i].contended;
+        }
+    }
+
+    return -1;
+}
+
+void prog_bench_pair(void) {
+    int index = bench_pair_next++;
+    int *mine;
+    int *other;
+    unsigned int start;
+    unsigned int cycles[2] = {0, 0};
+    int i;
+
+    bench_wait_turn(BENCH_ID_PAIR);
+
+    if (index == 0) {
+        bench_pair_mutex = mutex_init();
+        bench_pair_sem[0] = sem_init(0);
+        bench_pair_sem[1] = sem_init(0);
+        bench_pair_switch_total = 0;
+        bench_pair_switch_min = 0xffffffff;
+
+        bench_pair_start = 1;
+    }
+
+    while (!bench_pair_start) {
+        proc_sleep(0);
+    }
+
+    mine = &bench_pair_sem[index];
+    other = &bench_pair_sem[1 - index];
+
+    // Contended mutex: the first process holds the mutex until the second
+    // one blocks on it, then each unlock hands it to the waiting process
+    if (index == 0) {
+        mutex_lock(bench_pair_mutex);
+        sem_wait(*mine);
+
+        start = bench_cycles();
+        for (i = 0; i < BENCH_PAIR_ITERATIONS; i++) {
+            mutex_unlock(bench_pair_mutex);
+            mutex_lock(bench_pair_mutex);
+        }
+        cycles[0] = bench_cycles() - start;
+
+        mutex_unlock(bench_pair_mutex);
+    } else {
+        sem_post(*other);
+
+        for (i = 0; i < BENCH_PAIR_ITERATIONS; i++) {
+            mutex_lock(bench_pair_mutex);
+            mutex_unlock(bench_pair_mutex);
+        }
+    }
+
+    // Semaphore ping-pong
+    start = bench_cycles();
+    for (i = 0; i < BENCH_PAIR_ITERATIONS; i++) {
+        if (index == 0) {
+            sem_post(*other);
+            sem_wait(*mine);
+        } else {
+            sem_wait(*mine);
+            sem_post(*other);
+        }
+    }
+    cycles[1] = bench_cycles() - start;
+
+    // Context switch latency from the first process blocking to the
+    // second one resuming
+    for (i = 0; i < BENCH_PAIR_ITERATIONS; i++) {
+        if (index == 0) {
+            sem_post(*other);
+            bench_pair_mark = bench_cycles();
+            sem_wait(*mine);
+        } else {
+            sem_wait(*mine);
+            bench_pair_switched();
+            sem_post(*other);
+        }
+    }
+
+    if (index == 0) {
+        bench_report("mutex_contended iterations=%d contended=%d cycles_per_op=%d",
+                     BENCH_PAIR_ITERATIONS * 2, bench_pair_contended(bench_pair_mutex),
+                     cycles[0] / (BENCH_PAIR_ITERATIONS * 2));
+        bench_report("sem_pingpong round_trips=%d cycles_per_op=%d",
+                     BENCH_PAIR_ITERATIONS, cycles[1] / BENCH_PAIR_ITERATIONS);
+        bench_report("switch switches=%d cycles_avg=%d cycles_min=%d",
+                     BENCH_PAIR_ITERATIONS, bench_pair_switch_total / BENCH_PAIR_ITERATIONS,
+                     bench_pair_switch_min);
+
+        bench_end_turn();
+    }
+
+    proc_exit(0);
+}
@@ -14,9 +14,9 @@
 
 #define pprintf(fmt, ...) { \
     char __pprint_buf[512] = {0}; \
-    int i = snprintf(__pprint_buf, sizeof(__pprint_buf), (fmt), ##__VA_ARGS__); \
-    if (i > 0) { \
-        io_write(PROC_IO_OUT, __pprint_buf, i); \
+    int __pprint_len = snprintf(__pprint_buf, sizeof(__pprint_buf), (fmt), ##__VA_ARGS__); \
+    if (__pprint_len > 0) { \
+        io_write(PROC_IO_OUT, __pprint_buf, __pprint_len); \
     } \
 }
 
@@ -25,12 +25,56 @@
 #define CMD_SLEEP "sleep"
 #define CMD_TIME "time"
 #define CMD_LOCK "lock"
+#define CMD_MEM "mem"
+#define CMD_RUN "run"
+#define CMD_CAT "cat"
+#define CMD_PROF "prof"
+#define CMD_LAT "lat"
+#define CMD_SCHED "sched"
+#define CMD_LOCKSTAT "lockstat"
+#define CMD_TRACE "trace"
+
+#define PROF_TOP 10
+#define LAT_SHOW 24
+#define LOCKSTAT_SHOW 16
 
 /*
  * Mutexes for the lock
  */
 int shell_mutex[2] = {-1, -1};
 
+/**
+ * Prints kernel latency histograms, one line per histogram followed by
+ * the non-empty buckets
+ * @param kind - LAT_IRQ or LAT_SYSCALL
+ * @param label - name printed before each id
+ */
+void shell_lat_show(int kind, char *label) {
+    lat_hist_t hists[LAT_SHOW];
+    int n = lat_snapshot(kind, hists, LAT_SHOW);
+
+    for (int i = 0; i < n; i++) {
+        lat_hist_t *hist = &hists[i];
+        int shown = 0;
+
+        pprintf("%s 0x%02x  count %d  min %d  max %d cycles\n", label, hist->id,
+                hist->count, hist->min, hist->max);
+
+        for (int b = 0; b < LAT_BUCKETS; b++) {
+            if (hist->buckets[b]) {
+                pprintf("  2^%d: %d", b, hist->buckets[b]);
+                if (++shown % 6 == 0) {
+                    pprintf("\n");
+                }
+            }
+        }
+
+        if (shown % 6) {
+            pprintf("\n");
+        }
+    }
+}
+
 void prog_shell(void) {
     char buf[BUF_SIZE];
     char name[32];
@@ -78,6 +122,10 @@ void prog_shell(void) {
 
         reading = 1;
         while (reading) {
+            // Sleep until there is input rather than spinning on io_read
+            pollfd_t input_fd = { PROC_IO_IN, POLL_IN, 0 };
+            poll(&input_fd, 1, -1);
+
             mutex_lock(shell_mutex[pid % 2]);
             buflen = io_read(PROC_IO_IN, buf, BUF_SIZE);
 
@@ -96,20 +144,138 @@ void prog_shell(void) {
         if (input_len) {
             if (strncmp(input, CMD_HELP, strlen(CMD_HELP)) == 0) {
                 pprintf("Enter one of the following commands:\n");
+                pprintf("\tcat\t  prints a file from the filesystem, e.g. cat motd.txt\n");
                 pprintf("\texit\t  exits the process\n");
+                pprintf("\tlat\t  displays kernel latency histograms per interrupt and system call\n");
                 pprintf("\tlock\t  takes a lock that may block other shells\n");
+                pprintf("\tlockstat  displays mutex and semaphore contention, longest waits first\n");
+                pprintf("\tmem\t  displays kernel memory fragmentation\n");
+                pprintf("\tprof\t  starts the profiler or stops it and shows the top addresses\n");
+                pprintf("\trun\t  starts a program image, e.g. run hello\n");
+                pprintf("\tsched\t  displays scheduler statistics of a process, e.g. sched 1\n");
                 pprintf("\tsleep\t  puts the process to sleep for %d seconds\n", sleep_seconds);
                 pprintf("\ttime\t  displays the current system time\n");
+                pprintf("\ttrace\t  writes the scheduler trace to the kernel log\n");
                 pprintf("\n");
             } else if(strncmp(input, CMD_SLEEP, strlen(CMD_SLEEP)) == 0) {
                 pprintf("Sleeping for %d seconds at time %d ... ", sleep_seconds, sys_get_time());
                 proc_sleep(sleep_seconds);
                 pprintf("... and awake at time %d!\n", sys_get_time());
+            } else if (strncmp(input, CMD_TRACE, strlen(CMD_TRACE)) == 0) {
+                pprintf("Wrote %d trace events to the kernel log\n", trace_dump());
             } else if (strncmp(input, CMD_TIME, strlen(CMD_TIME)) == 0) {
                 pprintf("The current time is %d seconds\n", sys_get_time());
             } else if (strncmp(input, CMD_EXIT, strlen(CMD_EXIT)) == 0) {
                 pprintf("Exiting process id %d\n", pid);
                 proc_exit(0);
+            } else if (strncmp(input, CMD_MEM, strlen(CMD_MEM)) == 0) {
+                mem_stats_t stats;
+
+                if (mem_stats(&stats) == 0) {
+                    pprintf("class  pages   used   free\n");
+                    for (int i = 0; i < MEM_CLASSES; i++) {
+                        pprintf("%5d  %5d  %5d  %5d\n", stats.class_size[i],
+                                stats.class_pages[i], stats.class_used[i], stats.class_free[i]);
+                    }
+                    pprintf("large allocations %d (%d pages)\n", stats.large_allocs, stats.large_pages);
+                    pprintf("pages %d/%d free in %d runs, largest run %d\n", stats.pages_free,
+                            stats.pages_total, stats.free_runs, stats.largest_free);
+                    pprintf("page tables: %d directories, %d tables, %d private pages, %d cr3 loads\n",
+                            stats.page_dirs, stats.page_tables, stats.mapped_pages, stats.cr3_loads);
+                }
+            } else if (strncmp(input, CMD_RUN, strlen(CMD_RUN)) == 0) {
+                // Pointers into the stack are not moved by fork, so the new
+                // process finds the name in its own copy of the input
+                if (fork() == 0) {
+                    char *image = input + strlen(CMD_RUN);
+
+                    while (*image == ' ') {
+                        image++;
+                    }
+
+                    exec(image);
+                    pprintf("Unable to run program image '%s'\n", image);
+                    proc_exit(-1);
+                }
+            } else if (strncmp(input, CMD_CAT, strlen(CMD_CAT)) == 0) {
+                char *file = input + strlen(CMD_CAT);
+                int fd;
+                int n;
+
+                while (*file == ' ') {
+                    file++;
+                }
+
+                fd = io_open(file);
+                if (fd < 0) {
+                    pprintf("Unable to open file '%s'\n", file);
+                } else {
+                    while ((n = io_read(fd, buf, BUF_SIZE)) > 0) {
+                        // The TTY drains the output buffer as it fills
+                        for (int i = 0, w = 0; i < n && w >= 0; i += w) {
+                            w = io_write(PROC_IO_OUT, &buf[i], n - i);
+                        }
+                    }
+
+                    io_close(fd);
+                }
+            } else if (strncmp(input, CMD_PROF, strlen(CMD_PROF)) == 0) {
+                prof_sample_t top[PROF_TOP];
+                int samples;
+                int n;
+
+                // The first prof samples every tick; the next one stops
+                samples = prof_stop();
+                if (samples < 0) {
+                    prof_start(1);
+                    pprintf("Profiling started; run prof again to stop\n");
+                } else {
+                    n = prof_dump(top, PROF_TOP);
+                    pprintf("%d samples (full profile in the kernel log)\n", samples);
+                    pprintf("       eip   pid  count\n");
+                    for (int i = 0; i < n; i++) {
+                        pprintf("0x%08x  %4d  %5d\n", top[i].eip, top[i].pid, top[i].count);
+                    }
+                }
+            } else if (strncmp(input, CMD_LAT, strlen(CMD_LAT)) == 0) {
+                shell_lat_show(LAT_IRQ, "irq");
+                shell_lat_show(LAT_SYSCALL, "syscall");
+            } else if (strncmp(input, CMD_SCHED, strlen(CMD_SCHED)) == 0) {
+                char *arg = input + strlen(CMD_SCHED);
+                sched_stats_t stats;
+                int target = 0;
+
+                while (*arg == ' ') {
+                    arg++;
+                }
+
+                if (*arg == 0) {
+                    target = pid;
+                }
+
+                while (*arg >= '0' && *arg <= '9') {
+                    target = target * 10 + (*arg++ - '0');
+                }
+
+                if (proc_stats(target, &stats) != 0) {
+                    pprintf("No process with id %d\n", target);
+                } else {
+                    pprintf("process %d switches: %d voluntary, %d involuntary, %d timeslices expired\n",
+                            target, stats.voluntary, stats.involuntary, stats.timeslices);
+                    pprintf("process %d ticks: %d running, %d ready, %d waiting, %d sleeping\n",
+                            target, stats.run_ticks, stats.ready_ticks, stats.wait_ticks, stats.sleep_ticks);
+                }
+            } else if (strncmp(input, CMD_LOCKSTAT, strlen(CMD_LOCKSTAT)) == 0) {
+                lock_stat_t locks[LOCKSTAT_SHOW];
+                int n = lockstat(locks, LOCKSTAT_SHOW);
+
+                pprintf("lock      owner  acquired  contended  wait ticks  max wait  max queue\n");
+                for (int i = 0; i < n; i++) {
+                    pprintf("%s %2d  %5d  %8d  %9d  %10d  %8d  %9d\n",
+                            locks[i].type == LOCK_MUTEX ? "mutex" : "sem  ", locks[i].id,
+                            locks[i].owner, locks[i].acquisitions, locks[i].contended,
+                            locks[i].wait_ticks, locks[i].max_wait, locks[i].max_queue);
+                }
             } else if (strncmp(input, CMD_LOCK, strlen(CMD_LOCK)) == 0) {
                 pprintf("Locking shells for %d seconds\n", sleep_seconds);
                 mutex_lock(shell_mutex[pid % 2]);
@@ -98,3 +98,34 @@ int queue_out(queue_t *queue, int *item) {
 
     return 0;
 }
+
+/**
+ * Removes every occurrence of an item from the queue
+ * The order of the remaining items is maintained
+ * @param  queue - pointer to the queue
+ * @param  item  - the item to remove
+ * @return -1 on error; otherwise the number of items removed
+ */
+int queue_remove(queue_t *queue, int item) {
+    int size;
+    int value = 0;
+    int removed = 0;
+
+    if (!queue) {
+        return -1;
+    }
+
+    // Cycle through each item once, only queueing back the items to keep
+    size = queue->size;
+    for (int i = 0; i < size; i++) {
+        queue_out(queue, &value);
+
+        if (value == item) {
+            removed++;
+        } else {
+            queue_in(queue, value);
+        }
+    }
+
+    return removed;
+}
@@ -12,6 +12,52 @@
 
 #include "ringbuf.h"
 
+/**
+ * Calls the readiness hook of the buffer, if one is set
+ * @param buf - pointer to the ring buffer structure
+ */
+static void ringbuf_notify(ringbuf_t *buf) {
+    if (buf->notify) {
+        buf->notify(buf);
+    }
+}
+
+/**
+ * Stores a byte at the tail of a buffer that is known not to be full
+ * @param buf - pointer to the ring buffer structure
+ * @param byte - the byte to write
+ */
+static void ringbuf_put(ringbuf_t *buf, char byte) {
+    buf->data[buf->tail] = byte;
+
+    buf->tail++;
+
+    if (buf->tail == RINGBUF_SIZE) {
+        buf->tail = 0;
+    }
+
+    buf->size++;
+}
+
+/**
+ * Takes a byte from the head of a buffer that is known not to be empty
+ * @param buf - pointer to the ring buffer structure
+ * @return the byte read
+ */
+static char ringbuf_get(ringbuf_t *buf) {
+    char byte = buf->data[buf->head];
+
+    buf->head++;
+
+    if (buf->head == RINGBUF_SIZE) {
+        buf->head = 0;
+    }
+
+    buf->size--;
+
+    return byte;
+}
+
 /**
  * Initializes an empty ring buffer
  * Sets the empty data to 0
@@ -24,7 +70,7 @@ int ringbuf_init(ringbuf_t *buf) {
         return -1;
     }
 
-    memset(buf, 0, RINGBUF_SIZE);
+    memset(buf, 0, sizeof(ringbuf_t));
 
     return 0;
 }
@@ -44,15 +90,8 @@ int ringbuf_write(ringbuf_t *buf, char byte) {
         return -1;
     }
 
-    buf->data[buf->tail] = byte;
-
-    buf->tail++;
-
-    if (buf->tail == RINGBUF_SIZE) {
-        buf->tail = 0;
-    }
-
-    buf->size++;
+    ringbuf_put(buf, byte);
+    ringbuf_notify(buf);
 
     return 0;
 }
@@ -72,15 +111,8 @@ int ringbuf_read(ringbuf_t *buf, char *byte) {
         return -1;
     }
 
-    *byte = buf->data[buf->head];
-
-    buf->head++;
-
-    if (buf->head == RINGBUF_SIZE) {
-        buf->head = 0;
-    }
-
-    buf->size--;
+    *byte = ringbuf_get(buf);
+    ringbuf_notify(buf);
 
     return 0;
 }
@@ -104,9 +136,11 @@ int ringbuf_write_mem(ringbuf_t *buf, char *mem, size_t size) {
     }
 
     while (size-- && !ringbuf_is_full(buf)) {
-        ringbuf_write(buf, *mem++);
+        ringbuf_put(buf, *mem++);
     }
 
+    ringbuf_notify(buf);
+
     return 0;
 }
 
@@ -126,10 +160,14 @@ int ringbuf_read_mem(ringbuf_t *buf, char *mem, size_t size) {
     int count = 0;
 
     while (size-- && !ringbuf_is_empty(buf)) {
-        ringbuf_read(buf, mem++);
+        *mem++ = ringbuf_get(buf);
         count++;
     }
 
+    if (count > 0) {
+        ringbuf_notify(buf);
+    }
+
     return count;
 }
 
@@ -144,6 +182,7 @@ int ringbuf_flush(ringbuf_t *buf) {
     }
 
     memset(buf, 0, RINGBUF_SIZE);
+    ringbuf_notify(buf);
     return 0;
 }
 
@@ -13,21 +13,70 @@
 
 #include "kernel.h"
 #include "kproc.h"
+#include "ktrace.h"
 #include "scheduler.h"
 #include "timer.h"
 
-#include "queue.h"
-
 // Process Queues
-queue_t run_queue;      // Run queue -> processes that will be scheduled to run
-queue_t sleep_queue;    // Sleep queue -> processes that are currently sleeping
+proc_queue_t run_queue;      // Run queue -> processes that will be scheduled to run
+proc_queue_t sleep_queue;    // Sleep queue -> processes that are currently sleeping
+
+/**
+ * Adds a process to the end of a process queue
+ * @param queue - pointer to the queue
+ * @param proc - pointer to the process entry
+ */
+static void scheduler_queue_in(proc_queue_t *queue, proc_t *proc) {
+    proc->scheduler_queue = queue;
+    proc->queue_next = NULL;
+    proc->queue_prev = queue->tail;
+
+    if (queue->tail) {
+        queue->tail->queue_next = proc;
+    } else {
+        queue->head = proc;
+    }
+
+    queue->tail = proc;
+    queue->size++;
+}
+
+/**
+ * Unlinks a process from the queue it resides in
+ * @param proc - pointer to the process entry
+ */
+static void scheduler_queue_remove(proc_t *proc) {
+    proc_queue_t *queue = proc->scheduler_queue;
+
+    if (!queue) {
+        return;
+    }
+
+    if (proc->queue_prev) {
+        proc->queue_prev->queue_next = proc->queue_next;
+    } else {
+        queue->head = proc->queue_next;
+    }
+
+    if (proc->queue_next) {
+        proc->queue_next->queue_prev = proc->queue_prev;
+    } else {
+        queue->tail = proc->queue_prev;
+    }
+
+    queue->size--;
+
+    proc->scheduler_queue = NULL;
+    proc->queue_next = NULL;
+    proc->queue_prev = NULL;
+}
 
 /**
  * Scheduler timer callback
  */
 void scheduler_timer(void) {
-    int pid;
     proc_t *proc;
+    proc_t *next;
 
     // Update the active process' run time and CPU time
     if (active_proc) {
@@ -35,23 +84,10 @@ void scheduler_timer(void) {
         active_proc->cpu_time++;
     }
 
-    for (int i = 0; i < sleep_queue.size; i++) {
-        pid = -1;
+    for (proc = sleep_queue.head; proc; proc = next) {
+        next = proc->queue_next;
 
-        if (queue_out(&sleep_queue, &pid) != 0) {
-            kernel_log_warn("Unable to queue out of sleep queue");
-            continue;
-        }
-
-        proc = pid_to_proc(pid);
-        if (!proc) {
-            kernel_log_warn("Unable to look up process id %d", pid);
-            continue;
-        }
-
-        if (proc->sleep_time-- >= 0) {
-            queue_in(&sleep_queue, pid);
-        } else {
+        if (proc->sleep_time-- < 0) {
             scheduler_add(proc);
         }
     }
@@ -62,7 +98,7 @@ void scheduler_timer(void) {
  * Should ensure that `active_proc` is set to a valid process entry
  */
 void scheduler_run(void) {
-    int pid;
+    proc_t *preempted = NULL;
 
     // Ensure that processes not in the active state aren't still scheduled
     if (active_proc && active_proc->state != ACTIVE) {
@@ -75,6 +111,8 @@ void scheduler_run(void) {
         if (active_proc->cpu_time >= SCHEDULER_TIMESLICE) {
             // Reset the active time
             active_proc->cpu_time = 0;
+            active_proc->sched.timeslices++;
+            preempted = active_proc;
 
             // If the process is not the idle task, add it back to the scheduler
             // Otherwise, simply set the state to IDLE
@@ -94,13 +132,17 @@ void scheduler_run(void) {
 
     // Check if we have a process scheduled or not
     if (!active_proc) {
-        // Get the proces id from the run queue
-        if (queue_out(&run_queue, &pid) != 0) {
+        // Get the process from the run queue
+        active_proc = run_queue.head;
+
+        if (active_proc) {
+            scheduler_queue_remove(active_proc);
+            active_proc->sched.ready_ticks += timer_get_ticks() - active_proc->state_time;
+        } else {
             // default to process id 0 (idle task)
-            pid = 0;
+            active_proc = pid_to_proc(0);
         }
 
-        active_proc = pid_to_proc(pid);
         kernel_log_trace("Scheduling process pid=%d, name=%s", active_proc->pid, active_proc->name);
     }
 
@@ -109,6 +151,11 @@ void scheduler_run(void) {
         kernel_panic("Unable to schedule a process!");
     }
 
+    // A preempted process that is scheduled again has not been switched out
+    if (preempted && preempted != active_proc) {
+        preempted->sched.involuntary++;
+    }
+
     // Ensure that the process state is correct
     active_proc->state = ACTIVE;
 }
@@ -122,13 +169,31 @@ void scheduler_add(proc_t *proc) {
         kernel_panic("Invalid process!");
     }
 
-    proc->scheduler_queue = &run_queue;
+    int now = timer_get_ticks();
+
+    // Account for the time the process was blocked; a process already on
+    // the run queue keeps waiting from when it was first added
+    if (proc->state == WAITING) {
+        proc->sched.wait_ticks += now - proc->state_time;
+    } else if (proc->state == SLEEPING) {
+        proc->sched.sleep_ticks += now - proc->state_time;
+    }
+
+    if (proc->state == WAITING || proc->state == SLEEPING) {
+        ktrace_event(TRACE_WAKE, proc->pid, active_proc ? active_proc->pid : -1, 0);
+    }
+
+    if (proc->scheduler_queue != &run_queue) {
+        proc->state_time = now;
+    }
+
+    // A process may only reside in one queue
+    scheduler_queue_remove(proc);
+
     proc->state = IDLE;
     proc->cpu_time = 0;
 
-    if (queue_in(proc->scheduler_queue, proc->pid) != 0) {
-        kernel_panic("Unable to add the process to the scheduler");
-    }
+    scheduler_queue_in(&run_queue, proc);
 }
 
 /**
@@ -136,40 +201,33 @@ void scheduler_add(proc_t *proc) {
  * @param proc - pointer to the process entry
  */
 void scheduler_remove(proc_t *proc) {
-    int pid;
-
     if (!proc) {
         kernel_panic("Invalid process!");
         exit(1);
     }
 
-    if (proc->scheduler_queue) {
-        for (int i = 0; i < proc->scheduler_queue->size; i++) {
-            if (queue_out(proc->scheduler_queue, &pid) != 0) {
-                kernel_panic("Unable to queue out the process entry");
-            }
+    int now = timer_get_ticks();
 
-            if (proc->pid == pid) {
-                // Found the process
-                // continue iterating so the run queue order is maintained
-                continue;
-            }
+    if (proc->scheduler_queue == &run_queue) {
+        proc->sched.ready_ticks += now - proc->state_time;
+    }
 
-            // Add the item back to the run queue
-            if (queue_in(proc->scheduler_queue, pid) != 0) {
-                kernel_panic("Unable to queue process back to the run queue");
-            }
-        }
+    // Unlink the process; the order of the other processes is maintained
+    scheduler_queue_remove(proc);
 
-        // Set the queue to NULL since it does not exist in a queue any longer
-        proc->scheduler_queue = NULL;
-    }
+    // The process is blocked from now until it is added back
+    proc->state_time = now;
 
     // If the process is the current process, ensure that the current
     // process is reset so a new process will be scheduled
     if (proc == active_proc) {
+        proc->sched.voluntary++;
         active_proc = NULL;
     }
+
+    if (proc->state == WAITING) {
+        ktrace_event(TRACE_BLOCK, proc->pid, -1, 0);
+    }
 }
 
 /**
@@ -192,9 +250,39 @@ void scheduler_sleep(proc_t *proc, int time) {
     scheduler_remove(proc);
 
     proc->state = SLEEPING;
-    proc->scheduler_queue = &sleep_queue;
+    ktrace_event(TRACE_SLEEP, proc->pid, -1, 0);
+
+    scheduler_queue_in(&sleep_queue, proc);
+}
+
+/**
+ * Fills in a process' scheduler statistics, including the time spent so
+ * far in its current state
+ * @param pid - the process id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the process does not exist, 0 on success
+ */
+int scheduler_stats(int pid, sched_stats_t *stats) {
+    proc_t *proc = pid_to_proc(pid);
+    int elapsed;
+
+    if (!proc || !stats) {
+        return -1;
+    }
+
+    *stats = proc->sched;
+    stats->run_ticks = proc->run_time;
+
+    elapsed = timer_get_ticks() - proc->state_time;
+    if (proc->scheduler_queue == &run_queue) {
+        stats->ready_ticks += elapsed;
+    } else if (proc->state == WAITING) {
+        stats->wait_ticks += elapsed;
+    } else if (proc->state == SLEEPING) {
+        stats->sleep_ticks += elapsed;
+    }
 
-    queue_in(proc->scheduler_queue, proc->pid);
+    return 0;
 }
 
 /**
@@ -204,10 +292,10 @@ void scheduler_init(void) {
     kernel_log_info("Initializing scheduler");
 
     /* Initialize the run queue */
-    queue_init(&run_queue);
+    memset(&run_queue, 0, sizeof(run_queue));
 
     /* Initialize the sleep queue */
-    queue_init(&sleep_queue);
+    memset(&sleep_queue, 0, sizeof(sleep_queue));
 
     /* Register the timer callback */
     timer_callback_register(&scheduler_timer, 1, -1);
@@ -0,0 +1,213 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Single-producer/single-consumer ring buffer
+ */
+
+#include <spede/stdbool.h>      // for bool type
+#include <spede/stddef.h>       // for size_t
+#include <spede/string.h>       // for memset, memcpy
+
+#include "spscbuf.h"
+
+// Keeps the compiler from moving memory accesses across the barrier.
+// x86 does not reorder loads with loads or stores with stores, so this is
+// enough to order the data copy against publishing an index, both with
+// interrupts and between CPUs.
+#define spscbuf_barrier() asm volatile("" ::: "memory")
+
+/**
+ * Calls the readiness hook of the buffer, if one is set
+ * @param buf - pointer to the buffer
+ */
+static void spscbuf_notify(spscbuf_t *buf) {
+    if (buf->notify) {
+        buf->notify(buf);
+    }
+}
+
+/**
+ * Initializes an empty buffer
+ * @param  buf - pointer to the buffer
+ * @return -1 on error; 0 on success
+ */
+int spscbuf_init(spscbuf_t *buf) {
+    if (!buf) {
+        return -1;
+    }
+
+    memset(buf, 0, sizeof(spscbuf_t));
+
+    return 0;
+}
+
+/**
+ * Writes a byte to the buffer (producer only)
+ * @param  buf   - pointer to the buffer
+ * @param  byte  - the byte to write
+ * @return -1 on error or if full; 0 on success
+ */
+int spscbuf_write(spscbuf_t *buf, char byte) {
+    return spscbuf_write_mem(buf, &byte, 1);
+}
+
+/**
+ * Reads a byte from the buffer (consumer only)
+ * @param  buf - pointer to the buffer
+ * @param  byte - pointer to the byte to be stored
+ * @return -1 on error or if empty; 0 on success
+ */
+int spscbuf_read(spscbuf_t *buf, char *byte) {
+    if (!byte) {
+        return -1;
+    }
+
+    return (spscbuf_read_mem(buf, byte, 1) == 1) ? 0 : -1;
+}
+
+/**
+ * Copies multiple bytes into the buffer (producer only)
+ * @param buf - pointer to the buffer
+ * @param mem - pointer to the memory location to copy from
+ * @param size - number of bytes to copy
+ * @return -1 on error or if all bytes do not fit, 0 on success
+ */
+int spscbuf_write_mem(spscbuf_t *buf, char *mem, size_t size) {
+    unsigned int tail;
+    unsigned int head;
+    unsigned int offset;
+    unsigned int first;
+
+    if (!buf || (!mem && size)) {
+        return -1;
+    }
+
+    // Only the producer changes the tail; the head may move concurrently,
+    // which can only free more space
+    tail = buf->tail;
+    head = buf->head;
+
+    if (size > SPSCBUF_SIZE - (tail - head)) {
+        return -1;
+    }
+
+    // Copy in at most two pieces: up to the end of the array, then the
+    // remainder from the start
+    offset = tail & SPSCBUF_MASK;
+    first = SPSCBUF_SIZE - offset;
+    if (first > size) {
+        first = size;
+    }
+
+    memcpy(&buf->data[offset], mem, first);
+    memcpy(buf->data, mem + first, size - first);
+
+    // Publish the tail only after the data is in place
+    spscbuf_barrier();
+    buf->tail = tail + size;
+
+    spscbuf_notify(buf);
+
+    return 0;
+}
+
+/**
+ * Copies up to size bytes out of the buffer (consumer only)
+ * @param buf - pointer to the buffer
+ * @param mem - pointer to the memory location to copy to
+ * @param size - maximum number of bytes to copy
+ * @return -1 on error, otherwise the number of bytes copied
+ */
+int spscbuf_read_mem(spscbuf_t *buf, char *mem, size_t size) {
+    unsigned int head;
+    unsigned int tail;
+    unsigned int count;
+    unsigned int offset;
+    unsigned int first;
+
+    if (!buf || (!mem && size)) {
+        return -1;
+    }
+
+    // Only the consumer changes the head; the tail may move concurrently,
+    // which can only add more data
+    head = buf->head;
+    tail = buf->tail;
+    spscbuf_barrier();
+
+    count = tail - head;
+    if (count > size) {
+        count = size;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    offset = head & SPSCBUF_MASK;
+    first = SPSCBUF_SIZE - offset;
+    if (first > count) {
+        first = count;
+    }
+
+    memcpy(mem, &buf->data[offset], first);
+    memcpy(mem + first, buf->data, count - first);
+
+    // Release the space only after the data has been copied out
+    spscbuf_barrier();
+    buf->head = head + count;
+
+    spscbuf_notify(buf);
+
+    return count;
+}
+
+/**
+ * Discards all data in the buffer (consumer only)
+ * @param buf - pointer to the buffer
+ * @return -1 on error, 0 on success
+ */
+int spscbuf_flush(spscbuf_t *buf) {
+    if (!buf) {
+        return -1;
+    }
+
+    buf->head = buf->tail;
+
+    spscbuf_notify(buf);
+
+    return 0;
+}
+
+/**
+ * Returns the number of bytes in the buffer
+ * @param buf - pointer to the buffer
+ * @return number of bytes that can be read
+ */
+int spscbuf_count(spscbuf_t *buf) {
+    if (!buf) {
+        return 0;
+    }
+
+    return buf->tail - buf->head;
+}
+
+/**
+ * Indicates if the buffer is empty
+ * @param buf - pointer to the buffer
+ * @return true if empty, false if not empty
+ */
+bool spscbuf_is_empty(spscbuf_t *buf) {
+    return buf && buf->tail == buf->head;
+}
+
+/**
+ * Indicates if the buffer is full
+ * @param buf - pointer to the buffer
+ * @return true if full, false if not full
+ */
+bool spscbuf_is_full(spscbuf_t *buf) {
+    return buf && buf->tail - buf->head == SPSCBUF_SIZE;
+}
@@ -243,3 +243,319 @@ int sem_post(int sem) {
     return _syscall1(SYSCALL_SEM_POST, sem);
 }
 
+/**
+ * Gets the number of timer ticks since startup
+ * @return system time in timer ticks
+ */
+int sys_get_ticks(void) {
+    return _syscall0(SYSCALL_SYS_GET_TICKS);
+}
+
+/**
+ * Allocates a reader-writer lock from the kernel
+ * @param mode - RWLOCK_PREFER_READER or RWLOCK_PREFER_WRITER
+ * @return -1 on error, all other values indicate the lock id
+ */
+int rwlock_init(int mode) {
+    return _syscall1(SYSCALL_RWLOCK_INIT, mode);
+}
+
+/**
+ * Destroys a reader-writer lock
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ */
+int rwlock_destroy(int rwlock) {
+    return _syscall1(SYSCALL_RWLOCK_DESTROY, rwlock);
+}
+
+/**
+ * Takes a reader-writer lock for reading
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ * @note If a writer holds the lock, process will block/wait.
+ */
+int rwlock_rdlock(int rwlock) {
+    return _syscall1(SYSCALL_RWLOCK_RDLOCK, rwlock);
+}
+
+/**
+ * Takes a reader-writer lock for writing
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ * @note If the lock is held, process will block/wait.
+ */
+int rwlock_wrlock(int rwlock) {
+    return _syscall1(SYSCALL_RWLOCK_WRLOCK, rwlock);
+}
+
+/**
+ * Releases a reader-writer lock
+ * @param rwlock - lock id
+ * @return -1 on error, 0 on success
+ */
+int rwlock_unlock(int rwlock) {
+    return _syscall1(SYSCALL_RWLOCK_UNLOCK, rwlock);
+}
+
+/**
+ * Allocates a condition variable bound to a mutex
+ * @param mutex - mutex id protecting the condition
+ * @return -1 on error, all other values indicate the condition id
+ */
+int cond_init(int mutex) {
+    return _syscall1(SYSCALL_COND_INIT, mutex);
+}
+
+/**
+ * Destroys a condition variable
+ * @param cond - condition id
+ * @return -1 on error, 0 on success
+ */
+int cond_destroy(int cond) {
+    return _syscall1(SYSCALL_COND_DESTROY, cond);
+}
+
+/**
+ * Releases the bound mutex and waits on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, 0 on success
+ * @note The mutex is held again when the process resumes.
+ */
+int cond_wait(int cond) {
+    return _syscall1(SYSCALL_COND_WAIT, cond);
+}
+
+/**
+ * Wakes one process waiting on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int cond_signal(int cond) {
+    return _syscall1(SYSCALL_COND_SIGNAL, cond);
+}
+
+/**
+ * Wakes all processes waiting on a condition variable
+ * @param cond - condition id
+ * @return -1 on error, otherwise the number of processes woken
+ */
+int cond_broadcast(int cond) {
+    return _syscall1(SYSCALL_COND_BROADCAST, cond);
+}
+
+/**
+ * Allocates a mailbox from the kernel
+ * @return -1 on error, all other values indicate the mailbox id
+ */
+int mbox_init(void) {
+    return _syscall0(SYSCALL_MBOX_INIT);
+}
+
+/**
+ * Destroys a mailbox
+ * @param mbox - mailbox id
+ * @return -1 on error, 0 on success
+ */
+int mbox_destroy(int mbox) {
+    return _syscall1(SYSCALL_MBOX_DESTROY, mbox);
+}
+
+/**
+ * Sends a message to a mailbox
+ * @param mbox - mailbox id
+ * @param buf - the message to send
+ * @param n - message size (at most MBOX_MSG_SIZE bytes)
+ * @return -1 on error, 0 on success
+ * @note If the mailbox is full, process will block/wait.
+ */
+int msg_send(int mbox, char *buf, int n) {
+    return _syscall3(SYSCALL_MSG_SEND, mbox, (int)buf, n);
+}
+
+/**
+ * Receives a message from a mailbox
+ * @param mbox - mailbox id
+ * @param buf - the buffer to copy the message to
+ * @param n - size of the buffer
+ * @return -1 on error or value indicating number of bytes received
+ * @note If the mailbox is empty, process will block/wait.
+ */
+int msg_recv(int mbox, char *buf, int n) {
+    return _syscall3(SYSCALL_MSG_RECV, mbox, (int)buf, n);
+}
+
+/**
+ * Waits until any of the selected mailboxes holds a message
+ * @param mask - bitmask of mailbox ids (bit n selects mailbox n)
+ * @return -1 on error, otherwise the id of a mailbox with a message
+ */
+int msg_select(int mask) {
+    return _syscall1(SYSCALL_MSG_SELECT, mask);
+}
+
+/**
+ * Closes the specified IO buffer
+ * @param io - the IO buffer to close
+ * @return -1 on error or 0 on success
+ * @note Closing the last write end of a pipe signals end of file to readers
+ */
+int io_close(int io) {
+    return _syscall1(SYSCALL_IO_CLOSE, io);
+}
+
+/**
+ * Creates a pipe in two free IO buffers of the process
+ * @param fds - fds[0] is set to the read end, fds[1] to the write end
+ * @return -1 on error or 0 on success
+ */
+int pipe(int *fds) {
+    return _syscall1(SYSCALL_PIPE, (int)fds);
+}
+
+/**
+ * Waits until any of the specified IO buffers is ready
+ * @param fds - IO buffers and requested events; revents is filled in
+ * @param n - number of IO buffers in fds
+ * @param timeout - ticks to wait, 0 to return immediately, -1 to wait forever
+ * @return -1 on error, otherwise the number of ready IO buffers (0 on timeout)
+ */
+int poll(pollfd_t *fds, int n, int timeout) {
+    return _syscall3(SYSCALL_POLL, (int)fds, n, timeout);
+}
+
+/**
+ * Obtains kernel heap, page allocator and page table statistics
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 on error, 0 on success
+ */
+int mem_stats(mem_stats_t *stats) {
+    return _syscall1(SYSCALL_MEM_STATS, (int)stats);
+}
+
+/**
+ * Creates a copy of the calling process
+ * The copy shares the caller's memory copy-on-write and its I/O buffers
+ * @return -1 on error, 0 in the new process, otherwise the process id of
+ *         the new process
+ */
+int fork(void) {
+    return _syscall0(SYSCALL_FORK);
+}
+
+/**
+ * Replaces the calling process' program with a program image
+ * I/O buffers stay open; on success the call does not return
+ * @param name - name of the program image
+ * @return -1 on error
+ */
+int exec(char *name) {
+    return _syscall1(SYSCALL_EXEC, (int)name);
+}
+
+/**
+ * Opens a file from the filesystem into a free IO buffer slot
+ * The slot is read with io_read and released with io_close
+ * @param name - file name
+ * @return -1 on error, otherwise the IO buffer slot
+ */
+int io_open(char *name) {
+    return _syscall1(SYSCALL_IO_OPEN, (int)name);
+}
+
+/**
+ * Moves the offset of an open file
+ * @param io - the IO buffer slot of the file
+ * @param offset - offset relative to whence
+ * @param whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * @return -1 on error, otherwise the new offset
+ */
+int io_seek(int io, int offset, int whence) {
+    return _syscall3(SYSCALL_IO_SEEK, io, offset, whence);
+}
+
+/**
+ * Starts the sampling profiler, clearing the previous profile
+ * @param interval - timer ticks between samples
+ * @return -1 on error, 0 on success
+ */
+int prof_start(int interval) {
+    return _syscall1(SYSCALL_PROF_START, interval);
+}
+
+/**
+ * Stops the sampling profiler and writes the profile to the kernel log
+ * @return -1 if not profiling, otherwise the number of samples taken
+ */
+int prof_stop(void) {
+    return _syscall0(SYSCALL_PROF_STOP);
+}
+
+/**
+ * Copies the profile, most frequent entries first
+ * @param samples - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int prof_dump(prof_sample_t *samples, int n) {
+    return _syscall2(SYSCALL_PROF_DUMP, (int)samples, n);
+}
+
+/**
+ * Copies the kernel latency histograms that have samples, in id order
+ * @param kind - LAT_IRQ or LAT_SYSCALL
+ * @param hists - destination for up to n histograms
+ * @param n - maximum number of histograms
+ * @return -1 on error, otherwise the number of histograms copied
+ */
+int lat_snapshot(int kind, lat_hist_t *hists, int n) {
+    return _syscall3(SYSCALL_LAT_SNAPSHOT, kind, (int)hists, n);
+}
+
+/**
+ * Gets a process' context switch and scheduling delay statistics
+ * @param pid - the process id
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 if the process does not exist, 0 on success
+ */
+int proc_stats(int pid, sched_stats_t *stats) {
+    return _syscall2(SYSCALL_PROC_STATS, pid, (int)stats);
+}
+
+/**
+ * Gets the contention statistics of the allocated mutexes and semaphores,
+ * sorted by total wait time (longest first)
+ * @param stats - destination for up to n entries
+ * @param n - maximum number of entries
+ * @return -1 on error, otherwise the number of entries copied
+ */
+int lockstat(lock_stat_t *stats, int n) {
+    return _syscall2(SYSCALL_LOCKSTAT, (int)stats, n);
+}
+
+/**
+ * Copies and consumes the oldest unread scheduler trace events
+ * @param events - destination for up to n events
+ * @param n - maximum number of events
+ * @return -1 on error, otherwise the number of events copied
+ */
+int trace_read(trace_event_t *events, int n) {
+    return _syscall2(SYSCALL_TRACE_READ, (int)events, n);
+}
+
+/**
+ * Writes the unread scheduler trace events to the kernel log and consumes them
+ * @return the number of events written
+ */
+int trace_dump(void) {
+    return _syscall0(SYSCALL_TRACE_DUMP);
+}
+
+/**
+ * Writes a line to the kernel log, which the host receives over the serial port
+ * @param msg - the message (without a newline)
+ * @return -1 on error, 0 on success
+ */
+int sys_log(char *msg) {
+    return _syscall1(SYSCALL_SYS_LOG, (int)msg);
+}
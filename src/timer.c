@@ -9,6 +9,7 @@
 
 #include "interrupts.h"
 #include "kernel.h"
+#include "kprof.h"
 #include "queue.h"
 #include "timer.h"
 
@@ -120,6 +121,9 @@ void timer_irq_handler(void) {
     // Increment the timer_ticks value
     timer_ticks++;
 
+    // Sample the interrupted process while profiling
+    kprof_tick();
+
     // Iterate through the timers table
     for (int i = 0; i < TIMERS_MAX; i++) {
         timer = &timers[i];
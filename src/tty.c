@@ -116,7 +116,7 @@ void tty_input(char c) {
     if (!active_tty) {
         return;
     }
-    ringbuf_write(&active_tty->io_input, c);
+    spscbuf_write(&active_tty->io_input, c);
     if (active_tty->echo) {
         ringbuf_write(&active_tty->io_output, c);
     }
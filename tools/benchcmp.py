@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# Reads the results of a "make bench" image from the kernel log (lines of
+# the form "bench <name> key=value ...") and prints them, or compares them
+# against the results of an earlier run
+#
+# Usage: benchcmp.py <kernel.log> [baseline.log]
+#
+import re
+import sys
+
+RESULT_RE = re.compile(r'bench (\w+)((?: \w+=-?\d+)*)\s*$')
+
+
+def results(path):
+    runs = {}
+    seen = {}
+
+    with open(path) as f:
+        for line in f:
+            m = RESULT_RE.search(line)
+            if not m or m.group(1) == 'done':
+                continue
+
+            name = m.group(1)
+            fields = dict(kv.split('=') for kv in m.group(2).split())
+
+            # Benchmarks that report several lines are told apart by order
+            seen[name] = seen.get(name, 0) + 1
+            key = name if seen[name] == 1 else '%s#%d' % (name, seen[name])
+            runs[key] = {k: int(v) for k, v in fields.items()}
+
+    return runs
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit('usage: benchcmp.py <kernel.log> [baseline.log]')
+
+    current = results(sys.argv[1])
+    baseline = results(sys.argv[2]) if len(sys.argv) == 3 else {}
+
+    if not current:
+        sys.exit('no benchmark results found')
+
+    for key, fields in current.items():
+        for field, value in fields.items():
+            line = '%-24s %-24s %12d' % (key, field, value)
+            old = baseline.get(key, {}).get(field)
+            if old:
+                line += '  %12d  %+7.1f%%' % (old, 100.0 * (value - old) / old)
+            print(line)
+
+
+if __name__ == '__main__':
+    main()
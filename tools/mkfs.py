@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+#
+# Builds a filesystem image (see kfs.h) holding the given files
+#
+# Every file is written as a single extent of consecutive blocks. A file
+# argument of the form name:size=N generates an N byte test file whose
+# 32-bit words hold their own byte offset, so readers can verify the data.
+#
+# Usage: mkfs.py <output.img> <blocks> [file | name:size=N ...]
+#
+import os
+import struct
+import sys
+
+BLOCK_SIZE = 1024
+FS_MAGIC = 0x3153464b
+FS_NAME_LEN = 28
+FS_EXTENTS = 4
+DIRENT_SIZE = FS_NAME_LEN + 4 + FS_EXTENTS * 8
+
+
+def pattern(size):
+    words = (size + 3) // 4
+    data = struct.pack('<%dI' % words, *range(0, words * 4, 4))
+    return data[:size]
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: mkfs.py <output.img> <blocks> [file | name:size=N ...]')
+
+    out = sys.argv[1]
+    blocks = int(sys.argv[2])
+    files = []
+
+    for arg in sys.argv[3:]:
+        if ':size=' in arg:
+            name, size = arg.split(':size=')
+            files.append((name, pattern(int(size))))
+        else:
+            with open(arg, 'rb') as f:
+                files.append((os.path.basename(arg), f.read()))
+
+    per_block = BLOCK_SIZE // DIRENT_SIZE
+    dir_blocks = max(1, (len(files) + per_block - 1) // per_block)
+    next_block = 1 + dir_blocks
+
+    directory = b''
+    data = b''
+
+    for name, contents in files:
+        if len(name.encode()) >= FS_NAME_LEN:
+            sys.exit('mkfs.py: file name too long: %s' % name)
+
+        count = (len(contents) + BLOCK_SIZE - 1) // BLOCK_SIZE
+        extents = [next_block, count] + [0, 0] * (FS_EXTENTS - 1)
+        directory += struct.pack('<%dsI%dI' % (FS_NAME_LEN, FS_EXTENTS * 2),
+                                 name.encode(), len(contents), *extents)
+        data += contents.ljust(count * BLOCK_SIZE, b'\0')
+        next_block += count
+
+    if next_block > blocks:
+        sys.exit('mkfs.py: %d blocks needed, the disk has %d' % (next_block, blocks))
+
+    image = struct.pack('<5I', FS_MAGIC, blocks, 1, dir_blocks, len(files))
+    image = image.ljust(BLOCK_SIZE, b'\0')
+    image += directory.ljust(dir_blocks * BLOCK_SIZE, b'\0')
+    image += data
+    image = image.ljust(blocks * BLOCK_SIZE, b'\0')
+
+    with open(out, 'wb') as f:
+        f.write(image)
+
+
+if __name__ == '__main__':
+    main()
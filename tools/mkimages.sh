@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Generates the program image table (kelf_images, see kelf.h) as assembly
+# that embeds each ELF executable
+#
+# Usage: mkimages.sh <output.S> [program.elf ...]
+#
+out=$1
+shift
+
+{
+    echo '#include <spede/machine/asmacros.h>'
+    echo ''
+    echo '.section .rodata'
+
+    i=0
+    for elf in "$@"; do
+        echo "image_name_$i: .asciz \"$(basename "$elf" .elf)\""
+        echo '.align 4'
+        echo "image_data_$i: .incbin \"$elf\""
+        echo "image_end_$i:"
+        i=$((i + 1))
+    done
+
+    echo ''
+    echo '.data'
+    echo '.align 4'
+    echo '.globl CNAME(kelf_images)'
+    echo 'CNAME(kelf_images):'
+
+    j=0
+    while [ $j -lt $i ]; do
+        echo "    .long image_name_$j, image_data_$j, image_end_$j - image_data_$j"
+        j=$((j + 1))
+    done
+
+    echo '    .long 0, 0, 0'
+} > "$out"
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+#
+# Maps a profile written to the kernel log (see kprof.h) to symbols
+#
+# Symbols are read from the disassembly generated by "make text"
+# (build/<image>.asm). Program images are linked at the same address, so
+# samples taken in process private memory are resolved against the program
+# disassembly given for each pid with -p, then against any given with -u
+# (e.g. i386-elf-objdump -d build/user/hello.elf > hello.asm).
+#
+# Usage: profsym.py [-p pid=prog.asm] [-u prog.asm] <image.asm> [kernel.log]
+#
+import argparse
+import bisect
+import re
+import sys
+
+SYMBOL_RE = re.compile(r'^([0-9a-fA-F]{8}) <([^>]+)>:')
+SAMPLE_RE = re.compile(r'prof eip=0x([0-9a-fA-F]+) pid=(-?\d+) count=(\d+)')
+
+
+class Symbols:
+    def __init__(self, path):
+        table = []
+
+        with open(path) as f:
+            for line in f:
+                m = SYMBOL_RE.match(line)
+                if m:
+                    table.append((int(m.group(1), 16), m.group(2)))
+
+        table.sort()
+        self.addrs = [a for a, _ in table]
+        self.names = [n for _, n in table]
+
+    def lookup(self, eip):
+        i = bisect.bisect_right(self.addrs, eip) - 1
+        if i < 0:
+            return None
+        return self.names[i]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Maps a kernel profile to symbols')
+    parser.add_argument('image', help='kernel disassembly from make text')
+    parser.add_argument('log', nargs='?', help='kernel log (default: stdin)')
+    parser.add_argument('-p', dest='procs', action='append', default=[],
+                        metavar='PID=ASM', help='program disassembly for a pid')
+    parser.add_argument('-u', dest='user', action='append', default=[],
+                        metavar='ASM', help='program disassembly for any pid')
+    parser.add_argument('-n', dest='top', type=int, default=30,
+                        help='number of symbols to show')
+    args = parser.parse_args()
+
+    kernel = Symbols(args.image)
+    user = [Symbols(path) for path in args.user]
+    procs = {}
+    for spec in args.procs:
+        pid, path = spec.split('=', 1)
+        procs[int(pid)] = Symbols(path)
+
+    log = open(args.log) if args.log else sys.stdin
+    samples = []
+    for line in log:
+        m = SAMPLE_RE.search(line)
+        if m:
+            samples.append((int(m.group(1), 16), int(m.group(2)), int(m.group(3))))
+
+    if not samples:
+        sys.exit('no profile samples found')
+
+    # Kernel addresses are below the first program image symbol
+    user_start = min([s.addrs[0] for s in user + list(procs.values()) if s.addrs],
+                     default=0x40000000)
+
+    by_symbol = {}
+    by_pid = {}
+    total = 0
+    for eip, pid, count in samples:
+        name = None
+        if eip < user_start:
+            name = kernel.lookup(eip)
+        else:
+            for table in ([procs[pid]] if pid in procs else []) + user:
+                name = table.lookup(eip)
+                if name:
+                    break
+
+        if not name:
+            name = '0x%08x' % eip
+
+        by_symbol[name] = by_symbol.get(name, 0) + count
+        by_pid[pid] = by_pid.get(pid, 0) + count
+        total += count
+
+    print('%d samples' % total)
+    print()
+    print('%7s  %6s  %s' % ('samples', '%', 'symbol'))
+    for name, count in sorted(by_symbol.items(), key=lambda x: -x[1])[:args.top]:
+        print('%7d  %5.1f%%  %s' % (count, 100.0 * count / total, name))
+
+    print()
+    print('%7s  %6s  %s' % ('samples', '%', 'pid'))
+    for pid, count in sorted(by_pid.items(), key=lambda x: -x[1]):
+        print('%7d  %5.1f%%  %d' % (count, 100.0 * count / total, pid))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+#
+# Converts a scheduler trace written to the kernel log (see ktrace.h) to the
+# Chrome trace event format, for chrome://tracing or ui.perfetto.dev
+#
+# Each process gets a row showing when it ran, with instant events where it
+# was woken, went to sleep or blocked. Kernel entries are shown on their own
+# row, named by interrupt number. Time stamp counter values are converted to
+# microseconds using --mhz, or by measuring the timer interrupt spacing.
+#
+# Usage: trace2json.py [--mhz N] [--tick-hz N] [kernel.log] > trace.json
+#
+import argparse
+import json
+import re
+import statistics
+import sys
+
+EVENT_RE = re.compile(r'trace tsc=([0-9a-fA-F]+) type=(\d+) pid=(-?\d+) '
+                      r'other=(-?\d+) irq=(\d+)')
+
+SWITCH_IN = 1
+SWITCH_OUT = 2
+WAKE = 3
+SLEEP = 4
+BLOCK = 5
+IRQ_ENTER = 6
+IRQ_EXIT = 7
+
+IRQ_TIMER = 0x20
+IRQ_NAMES = {
+    0x07: 'fpu',
+    0x0e: 'page fault',
+    0x20: 'timer',
+    0x21: 'keyboard',
+    0x2e: 'ata',
+    0x80: 'syscall',
+}
+
+KERNEL_TID = -1
+
+
+def cycles_per_us(events, tick_hz):
+    ticks = [tsc for tsc, kind, _, _, irq in events if kind == IRQ_ENTER and irq == IRQ_TIMER]
+    gaps = [b - a for a, b in zip(ticks, ticks[1:])]
+    if not gaps:
+        sys.exit('no timer interrupts in the trace; give the TSC rate with --mhz')
+
+    return statistics.median(gaps) * tick_hz / 1e6
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts a kernel trace to Chrome trace JSON')
+    parser.add_argument('log', nargs='?', help='kernel log (default: stdin)')
+    parser.add_argument('--mhz', type=float, help='time stamp counter rate in MHz')
+    parser.add_argument('--tick-hz', type=float, default=100, help='timer interrupt rate')
+    args = parser.parse_args()
+
+    log = open(args.log) if args.log else sys.stdin
+    events = []
+    for line in log:
+        m = EVENT_RE.search(line)
+        if m:
+            events.append((int(m.group(1), 16), int(m.group(2)), int(m.group(3)),
+                           int(m.group(4)), int(m.group(5))))
+
+    if not events:
+        sys.exit('no trace events found')
+
+    mhz = args.mhz or cycles_per_us(events, args.tick_hz)
+    base = events[0][0]
+
+    def us(tsc):
+        return (tsc - base) / mhz
+
+    out = []
+    pids = set()
+    running = {}
+    irq_start = None
+
+    for tsc, kind, pid, other, irq in events:
+        ts = us(tsc)
+
+        if kind == SWITCH_IN:
+            running[pid] = ts
+        elif kind == SWITCH_OUT:
+            start = running.pop(pid, us(base))
+            out.append({'name': 'running', 'ph': 'X', 'pid': 0, 'tid': pid,
+                        'ts': start, 'dur': ts - start, 'args': {'next': other}})
+        elif kind in (WAKE, SLEEP, BLOCK):
+            name = {WAKE: 'wake', SLEEP: 'sleep', BLOCK: 'block'}[kind]
+            out.append({'name': name, 'ph': 'i', 's': 't', 'pid': 0, 'tid': pid,
+                        'ts': ts, 'args': {'by': other} if kind == WAKE else {}})
+        elif kind == IRQ_ENTER:
+            irq_start = ts
+        elif kind == IRQ_EXIT and irq_start is not None:
+            name = IRQ_NAMES.get(irq, 'irq 0x%02x' % irq)
+            out.append({'name': name, 'ph': 'X', 'pid': 0, 'tid': KERNEL_TID,
+                        'ts': irq_start, 'dur': ts - irq_start,
+                        'args': {'interrupted': other, 'resumed': pid}})
+            irq_start = None
+
+        if pid >= 0:
+            pids.add(pid)
+
+    # Close the intervals of processes still running at the end
+    end = us(events[-1][0])
+    for pid, start in running.items():
+        out.append({'name': 'running', 'ph': 'X', 'pid': 0, 'tid': pid,
+                    'ts': start, 'dur': end - start})
+
+    out.append({'name': 'process_name', 'ph': 'M', 'pid': 0, 'args': {'name': 'kernel'}})
+    out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': KERNEL_TID,
+                'args': {'name': 'interrupts'}})
+    for pid in sorted(pids):
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': pid,
+                    'args': {'name': 'pid %d' % pid}})
+
+    json.dump({'traceEvents': out, 'displayTimeUnit': 'ns'}, sys.stdout)
+    sys.stdout.write('\n')
+
+
+if __name__ == '__main__':
+    main()
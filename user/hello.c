@@ -0,0 +1,60 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Hello World Program Image
+ */
+#include "syscall.h"
+
+// Lives in BSS, so its pages are zero filled as the message is built
+char hello_buf[8192];
+
+/**
+ * Appends a string to the message
+ * @param pos - position in the message
+ * @param str - the string to append
+ * @return position after the string
+ */
+int hello_str(int pos, char *str) {
+    while (*str) {
+        hello_buf[pos++] = *str++;
+    }
+
+    return pos;
+}
+
+/**
+ * Appends a non-negative number to the message
+ * @param pos - position in the message
+ * @param n - the number to append
+ * @return position after the number
+ */
+int hello_num(int pos, int n) {
+    char digits[12];
+    int len = 0;
+
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+
+    while (len > 0) {
+        hello_buf[pos++] = digits[--len];
+    }
+
+    return pos;
+}
+
+int main(void) {
+    // Start the message on the second BSS page
+    int start = sizeof(hello_buf) / 2;
+    int pos = start;
+
+    pos = hello_str(pos, "Hello from a program image (process id ");
+    pos = hello_num(pos, proc_get_pid());
+    pos = hello_str(pos, ")!\n");
+
+    io_write(PROC_IO_OUT, &hello_buf[start], pos - start);
+    return 0;
+}
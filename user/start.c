@@ -0,0 +1,19 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Program Image Startup
+ *
+ * Linked into every program image; the loader starts the program here.
+ */
+#include "syscall.h"
+
+int main(void);
+
+/**
+ * Runs the program and exits with its return value
+ */
+void _start(void) {
+    proc_exit(main());
+}
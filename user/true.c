@@ -0,0 +1,11 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Program that exits immediately (used to measure program startup)
+ */
+
+int main(void) {
+    return 0;
+}